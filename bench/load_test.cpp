@@ -0,0 +1,759 @@
+// End-to-end load test: N accounts of M vehicles each against a local STARLINK stand-in.
+//
+// Usage: subarulink_loadtest [--accounts N] [--vehicles M] [--duration SECONDS] [--period SECONDS]
+//                            [--mix FETCH:UPDATE:COMMAND] [--latency MEDIAN_MS:P99_MS]
+//                            [--command-latency MEDIAN_MS:P99_MS] [--fixtures DIR]
+//                            [--metrics FILE] [--trace FILE]
+//
+// The stand-in answers the endpoints Connection and Controller use with the
+// recorded responses in bench/fixtures, after a log-normal delay per request.
+// Remote commands finish after a delay drawn from the command latency. It
+// runs in a child process so its threads and memory do not count against the
+// client. Every vehicle starts one operation per period, picked by the mix;
+// the report covers operation latency, throughput, peak threads, RSS and CPU
+// time per vehicle refresh, plus the client's per-endpoint request latency.
+// Linux only.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "controller.h"
+#include "metrics.h"
+#include "trace.h"
+
+#ifndef SUBARULINK_BENCH_FIXTURES
+#define SUBARULINK_BENCH_FIXTURES "bench/fixtures"
+#endif
+
+namespace {
+  using subarulink::Controller;
+  using Clock = std::chrono::steady_clock;
+
+  const char *GENERATIONS[] = {"g1", "g2", "g3", "phev"};
+  constexpr size_t GENERATION_COUNT = sizeof(GENERATIONS) / sizeof(GENERATIONS[0]);
+
+  /**
+   * @brief Log-normal delay given by its median and 99th percentile
+   */
+  struct Latency {
+    double median_ms{0.0};
+    double p99_ms{0.0};
+
+    std::chrono::microseconds sample(std::mt19937_64 &random) const {
+      if (median_ms <= 0.0) {
+        return std::chrono::microseconds(0);
+      }
+      // 2.326 is the standard normal's 99th percentile
+      double sigma = p99_ms > median_ms ? std::log(p99_ms / median_ms) / 2.326 : 0.0;
+      std::lognormal_distribution<double> distribution(std::log(median_ms), sigma);
+      return std::chrono::microseconds(static_cast<int64_t>(distribution(random) * 1000.0));
+    }
+  };
+
+  struct Options {
+    size_t accounts = 10;
+    size_t vehicles = 2;
+    double duration = 30.0;
+    double period = 5.0;
+    double mix[3] = {8.0, 1.0, 1.0};
+    Latency latency{40.0, 250.0};
+    Latency command_latency{3000.0, 8000.0};
+    std::string fixtures = SUBARULINK_BENCH_FIXTURES;
+    std::string metrics_path;
+    std::string trace_path;
+  };
+
+  nlohmann::json load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+      throw std::runtime_error("Cannot open fixture " + path);
+    }
+    return nlohmann::json::parse(in);
+  }
+
+  /// Account and vehicle numbers are encoded in the login name and VIN so the stand-in keeps no account state
+  std::string vin_for(const std::string &fixture_vin, size_t serial) {
+    char digits[8];
+    std::snprintf(digits, sizeof(digits), "%06zu", serial % 1000000);
+    return fixture_vin.substr(0, 11) + digits;
+  }
+
+  size_t generation_of(const std::string &vin) {
+    return vin.size() == 17 ? std::strtoul(vin.c_str() + 11, nullptr, 10) % GENERATION_COUNT : 0;
+  }
+
+  /**
+   * @brief Minimal HTTP/1.1 server emulating the STARLINK mobile API
+   */
+  class StandIn {
+  public:
+    StandIn(const Options &options) : _options(options) {
+      auto presets = load(options.fixtures + "/presets.json");
+      _subaru_presets = presets["subaru"].dump();
+      _user_presets = presets["user"].dump();
+
+      for (size_t i = 0; i < GENERATION_COUNT; ++i) {
+        auto fixture = load(options.fixtures + "/" + GENERATIONS[i] + ".json");
+        _vehicle.push_back(fixture["vehicle"]);
+        _status.push_back(fixture["status"].dump());
+        _condition.push_back(fixture["condition"].dump());
+        _health.push_back(fixture["health"].dump());
+        _location.push_back(fixture["location"]);
+        _locate.push_back(nlohmann::json{
+            {"success", true}, {"errorCode", nullptr},
+            {"data", {{"remoteServiceState", "finished"}, {"result", fixture["location"]}}}}.dump());
+      }
+    }
+
+    /**
+     * @brief Accepts connections until the process is killed, one thread each
+     */
+    [[noreturn]] void serve(int listener) {
+      for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+          continue;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        std::thread(&StandIn::_connection, this, fd).detach();
+      }
+    }
+
+  private:
+    struct Reply {
+      Reply(int status, std::string body, std::string cookie = "")
+          : status(status), body(std::move(body)), cookie(std::move(cookie)) {}
+
+      int status;
+      std::string body;
+      std::string cookie;   ///< New session to set, if any
+    };
+
+    struct Command {
+      Clock::time_point finishes;
+      size_t generation{0};
+    };
+
+    void _connection(int fd) {
+      std::mt19937_64 random(std::random_device{}());
+      std::string buffer;
+      char chunk[16384];
+      auto fill = [&]() {
+        auto n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+          return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+      };
+
+      for (;;) {
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+          if (!fill()) {
+            close(fd);
+            return;
+          }
+        }
+
+        // Request line and the few headers that matter
+        auto line_end = buffer.find("\r\n");
+        auto request_line = buffer.substr(0, line_end);
+        auto method = request_line.substr(0, request_line.find(' '));
+        auto target_start = method.size() + 1;
+        auto target = request_line.substr(target_start, request_line.find(' ', target_start) - target_start);
+        size_t content_length = 0;
+        std::string cookie;
+        bool expect_continue = false;
+        for (size_t pos = line_end + 2; pos < header_end;) {
+          auto end = buffer.find("\r\n", pos);
+          auto header = buffer.substr(pos, end - pos);
+          auto colon = header.find(':');
+          auto name = header.substr(0, colon);
+          std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+          auto value_start = colon == std::string::npos ? std::string::npos : header.find_first_not_of(' ', colon + 1);
+          auto value = value_start == std::string::npos ? "" : header.substr(value_start);
+          if (name == "content-length") {
+            content_length = std::strtoul(value.c_str(), nullptr, 10);
+          } else if (name == "cookie") {
+            cookie = value;
+          } else if (name == "expect") {
+            expect_continue = true;
+          }
+          pos = end + 2;
+        }
+
+        if (expect_continue && buffer.size() < header_end + 4 + content_length) {
+          static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+          send(fd, CONTINUE, sizeof(CONTINUE) - 1, MSG_NOSIGNAL);
+        }
+        while (buffer.size() < header_end + 4 + content_length) {
+          if (!fill()) {
+            close(fd);
+            return;
+          }
+        }
+        auto body = buffer.substr(header_end + 4, content_length);
+        buffer.erase(0, header_end + 4 + content_length);
+
+        auto query_start = target.find('?');
+        auto path = target.substr(0, query_start);
+        auto query = query_start == std::string::npos ? "" : target.substr(query_start + 1);
+        auto reply = _handle(method, path, query, _session_of(cookie), body, random);
+
+        std::this_thread::sleep_for(_options.latency.sample(random));
+
+        std::string response = "HTTP/1.1 " + std::to_string(reply.status) + (reply.status == 200 ? " OK" : " Not Found") +
+                               "\r\nContent-Type: application/json\r\nContent-Length: " +
+                               std::to_string(reply.body.size()) + "\r\n";
+        if (!reply.cookie.empty()) {
+          response += "Set-Cookie: JSESSIONID=" + reply.cookie + "; Path=/\r\n";
+        }
+        response += "\r\n" + reply.body;
+        if (send(fd, response.data(), response.size(), MSG_NOSIGNAL) < 0) {
+          close(fd);
+          return;
+        }
+      }
+    }
+
+    Reply _handle(const std::string &method, const std::string &path, const std::string &query,
+                  const std::string &session, const std::string &body, std::mt19937_64 &random) {
+      static const std::string OK = R"({"success":true,"errorCode":null,"dataName":null,"data":null})";
+      static const std::string NO_SESSION = R"({"success":false,"errorCode":"InvalidToken","data":null})";
+
+      auto ends_with = [&path](const std::string &suffix) {
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+      };
+
+      if (ends_with("/login.json")) {
+        return _login(_parameter(body, "loginUsername"));
+      }
+
+      std::string vin;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _sessions.find(session);
+        if (it == _sessions.end()) {
+          return {200, ends_with("/validateSession.json") ? R"({"success":false,"errorCode":null,"data":null})"
+                                                          : NO_SESSION};
+        }
+        if (ends_with("/selectVehicle.json")) {
+          it->second = _parameter(query, "vin");
+        }
+        vin = it->second;
+      }
+      auto generation = generation_of(vin);
+
+      if (ends_with("/validateSession.json")) {
+        return {200, OK};
+      }
+      if (ends_with("/selectVehicle.json")) {
+        auto vehicle = _vehicle[generation];
+        vehicle["vin"] = vin;
+        return {200, nlohmann::json{{"success", true}, {"errorCode", nullptr}, {"data", vehicle}}.dump()};
+      }
+      if (ends_with("/vehicleStatus.json")) {
+        return {200, _status[generation]};
+      }
+      if (ends_with("/vehicleHealth.json")) {
+        return {200, _health[generation]};
+      }
+      if (ends_with("/condition/execute.json")) {
+        return {200, _condition[generation]};
+      }
+      if (ends_with("/locate/execute.json")) {
+        return {200, _locate[generation]};
+      }
+      if (ends_with("/climatePresetSettings/fetch.json")) {
+        return {200, _subaru_presets};
+      }
+      if (ends_with("/remoteEngineStartSettings/fetch.json")) {
+        return {200, _user_presets};
+      }
+      if (ends_with("/remoteEngineQuickStartSettings/fetch.json")) {
+        return {200, OK};
+      }
+      if (ends_with("/cancel.json")) {
+        auto form = nlohmann::json::parse(body, nullptr, false);
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (form.is_object()) {
+          _commands.erase(form.value("serviceRequestId", ""));
+        }
+        return {200, OK};
+      }
+      if (method == "POST" && (ends_with("/status.json") || ends_with("/locationStatus.json"))) {
+        return _command_status(_parameter(query, "serviceRequestId"));
+      }
+      if (method == "POST" && (ends_with("/execute.json") || ends_with("/stop.json"))) {
+        std::string id;
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          id = std::to_string(++_next_request);
+          _commands[id] = {Clock::now() + _options.command_latency.sample(random), generation};
+        }
+        return {200, nlohmann::json{
+            {"success", true}, {"errorCode", nullptr},
+            {"data", {{"serviceRequestId", id}, {"remoteServiceState", "started"}, {"success", false}}}}.dump()};
+      }
+      return {404, R"({"success":false,"errorCode":"notFound"})"};
+    }
+
+    Reply _login(const std::string &username) {
+      // load<account>@example.com owns vehicles account * M .. account * M + M - 1
+      auto account = std::strtoul(username.c_str() + std::min<size_t>(4, username.size()), nullptr, 10);
+      auto vehicles = nlohmann::json::array();
+      for (size_t i = 0; i < _options.vehicles; ++i) {
+        auto serial = account * _options.vehicles + i;
+        vehicles.push_back({{"vin", vin_for(_vehicle[serial % GENERATION_COUNT]["vin"], serial)}});
+      }
+
+      std::string session;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        session = std::to_string(++_next_session);
+        _sessions[session] = "";
+      }
+      return {200, nlohmann::json{
+          {"success", true}, {"errorCode", nullptr},
+          {"data", {{"deviceRegistered", true}, {"vehicles", vehicles}}}}.dump(), session};
+    }
+
+    Reply _command_status(const std::string &id) {
+      Command command;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _commands.find(id);
+        if (it == _commands.end()) {
+          return {200, R"({"success":false,"errorCode":"serviceRequestNotFound","data":null})"};
+        }
+        command = it->second;
+        if (Clock::now() >= command.finishes) {
+          _commands.erase(it);
+        }
+      }
+
+      nlohmann::json data = {{"serviceRequestId", id}, {"remoteServiceState", "STARTED"}, {"success", false}};
+      if (Clock::now() >= command.finishes) {
+        data["remoteServiceState"] = "SUCCESS";
+        data["success"] = true;
+        data["result"] = _location[command.generation];
+      }
+      return {200, nlohmann::json{{"success", true}, {"errorCode", nullptr}, {"data", data}}.dump()};
+    }
+
+    static std::string _session_of(const std::string &cookie) {
+      auto pos = cookie.find("JSESSIONID=");
+      if (pos == std::string::npos) {
+        return "";
+      }
+      pos += 11;
+      return cookie.substr(pos, cookie.find(';', pos) - pos);
+    }
+
+    /// Value of a form or query parameter; the values the stand-in reads are never escaped
+    static std::string _parameter(const std::string &encoded, const std::string &name) {
+      for (size_t pos = 0; pos < encoded.size();) {
+        auto end = encoded.find('&', pos);
+        if (end == std::string::npos) {
+          end = encoded.size();
+        }
+        auto pair = encoded.substr(pos, end - pos);
+        auto eq = pair.find('=');
+        if (pair.substr(0, eq) == name) {
+          return eq == std::string::npos ? "" : pair.substr(eq + 1);
+        }
+        pos = end + 1;
+      }
+      return "";
+    }
+
+    const Options &_options;
+    std::vector <nlohmann::json> _vehicle;
+    std::vector <std::string> _status;
+    std::vector <std::string> _condition;
+    std::vector <std::string> _health;
+    std::vector <nlohmann::json> _location;
+    std::vector <std::string> _locate;
+    std::string _subaru_presets;
+    std::string _user_presets;
+
+    std::mutex _mutex;
+    std::map <std::string, std::string> _sessions;   ///< Session cookie to selected VIN
+    std::map <std::string, Command> _commands;       ///< Running remote commands by serviceRequestId
+    uint64_t _next_session{0};
+    uint64_t _next_request{0};
+  };
+
+  /**
+   * @brief Peak thread count and RSS of this process, sampled from /proc
+   */
+  class ResourceSampler {
+  public:
+    ResourceSampler() : _thread([this]() {
+      while (!_stop.load()) {
+        _sample();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }) {}
+
+    ~ResourceSampler() {
+      _stop.store(true);
+      _thread.join();
+    }
+
+    /// Excludes the sampler's own thread
+    size_t peak_threads() const { return _peak_threads.load() - 1; }
+    size_t peak_rss_kib() const { return _peak_rss_kib.load(); }
+
+  private:
+    void _sample() {
+      std::ifstream status("/proc/self/status");
+      std::string line;
+      while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+          _raise(_peak_threads, std::strtoul(line.c_str() + 8, nullptr, 10));
+        } else if (line.rfind("VmRSS:", 0) == 0) {
+          _raise(_peak_rss_kib, std::strtoul(line.c_str() + 6, nullptr, 10));
+        }
+      }
+    }
+
+    static void _raise(std::atomic<size_t> &peak, size_t value) {
+      auto current = peak.load();
+      while (value > current && !peak.compare_exchange_weak(current, value)) {}
+    }
+
+    std::atomic<bool> _stop{false};
+    std::atomic<size_t> _peak_threads{0};
+    std::atomic<size_t> _peak_rss_kib{0};
+    std::thread _thread;
+  };
+
+  double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval &time) { return time.tv_sec + time.tv_usec / 1e6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+  }
+
+  /**
+   * @brief Latencies and failures of one kind of operation
+   */
+  struct Samples {
+    std::vector<double> millis;
+    size_t errors{0};
+
+    double percentile(double quantile) {
+      if (millis.empty()) {
+        return 0.0;
+      }
+      std::sort(millis.begin(), millis.end());
+      return millis[std::min(millis.size() - 1, static_cast<size_t>(quantile * millis.size()))];
+    }
+  };
+
+  enum Operation { FETCH, UPDATE, COMMAND, OPERATION_COUNT };
+  const char *OPERATION_NAMES[] = {"fetch", "update", "command"};
+
+  struct Vehicle {
+    Controller *controller{nullptr};
+    std::string vin;
+    bool remote{false};
+    Clock::time_point due;
+    std::future<bool> running;
+    Operation operation{FETCH};
+    Clock::time_point started;
+    bool lock_next{true};
+  };
+
+  Latency parse_latency(const std::string &text) {
+    auto colon = text.find(':');
+    if (colon == std::string::npos) {
+      throw std::invalid_argument("Expected MEDIAN_MS:P99_MS, got " + text);
+    }
+    return {std::stod(text.substr(0, colon)), std::stod(text.substr(colon + 1))};
+  }
+
+  Options parse_args(int argc, char **argv) {
+    Options options;
+    try {
+      for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--accounts" && has_value) {
+          options.accounts = std::stoul(argv[++i]);
+        } else if (arg == "--vehicles" && has_value) {
+          options.vehicles = std::stoul(argv[++i]);
+        } else if (arg == "--duration" && has_value) {
+          options.duration = std::stod(argv[++i]);
+        } else if (arg == "--period" && has_value) {
+          options.period = std::stod(argv[++i]);
+        } else if (arg == "--mix" && has_value) {
+          std::string mix = argv[++i];
+          auto first = mix.find(':');
+          auto second = mix.find(':', first + 1);
+          if (first == std::string::npos || second == std::string::npos) {
+            throw std::invalid_argument("Expected FETCH:UPDATE:COMMAND, got " + mix);
+          }
+          options.mix[FETCH] = std::stod(mix.substr(0, first));
+          options.mix[UPDATE] = std::stod(mix.substr(first + 1, second - first - 1));
+          options.mix[COMMAND] = std::stod(mix.substr(second + 1));
+        } else if (arg == "--latency" && has_value) {
+          options.latency = parse_latency(argv[++i]);
+        } else if (arg == "--command-latency" && has_value) {
+          options.command_latency = parse_latency(argv[++i]);
+        } else if (arg == "--fixtures" && has_value) {
+          options.fixtures = argv[++i];
+        } else if (arg == "--metrics" && has_value) {
+          options.metrics_path = argv[++i];
+        } else if (arg == "--trace" && has_value) {
+          options.trace_path = argv[++i];
+        } else {
+          throw std::invalid_argument(arg == "--help" ? "" : "Unknown option " + arg);
+        }
+      }
+    } catch (const std::exception &e) {
+      if (*e.what()) {
+        std::cerr << e.what() << std::endl;
+      }
+      std::cerr << "Usage: " << argv[0] << " [--accounts N] [--vehicles M] [--duration SECONDS] [--period SECONDS]\n"
+                << "       [--mix FETCH:UPDATE:COMMAND] [--latency MEDIAN_MS:P99_MS]\n"
+                << "       [--command-latency MEDIAN_MS:P99_MS] [--fixtures DIR] [--metrics FILE] [--trace FILE]"
+                << std::endl;
+      std::exit(*e.what() ? 2 : 0);
+    }
+    return options;
+  }
+
+  double elapsed_ms(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+  }
+
+  void print_row(const char *name, Samples &samples, double seconds) {
+    std::printf("%-22s %8zu %7zu %9.2f %9.1f %9.1f %9.1f %9.1f\n", name, samples.millis.size(), samples.errors,
+                samples.millis.size() / seconds, samples.percentile(0.5), samples.percentile(0.9),
+                samples.percentile(0.99), samples.millis.empty() ? 0.0 : samples.percentile(1.0));
+  }
+}
+
+int main(int argc, char **argv) {
+  auto options = parse_args(argc, argv);
+
+  // Bind before forking so the port is known and connections queue until the stand-in accepts
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+      listen(listener, 1024) != 0 || getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+    std::perror("Cannot listen on loopback");
+    return 1;
+  }
+  auto port = ntohs(address.sin_port);
+
+  std::unique_ptr<StandIn> stand_in;
+  try {
+    stand_in = std::make_unique<StandIn>(options);
+  } catch (const std::exception &e) {
+    std::cerr << "Load test failed: " << e.what() << std::endl;
+    return 1;
+  }
+
+  auto server = fork();
+  if (server < 0) {
+    std::perror("fork");
+    return 1;
+  }
+  if (server == 0) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    stand_in->serve(listener);
+  }
+  close(listener);
+  stand_in.reset();
+
+  int status = 0;
+  try {
+    subarulink::Tracer::instance().set_enabled(!options.trace_path.empty());
+    ResourceSampler sampler;
+    auto base_url = "http://127.0.0.1:" + std::to_string(port) + "/g2v30";
+
+    std::vector<std::unique_ptr<Controller>> controllers;
+    for (size_t i = 0; i < options.accounts; ++i) {
+      controllers.push_back(std::make_unique<Controller>(
+          "load" + std::to_string(i) + "@example.com", "password", "load-device-" + std::to_string(i),
+          "1234", "loadtest", "USA"));
+      controllers.back()->set_base_url(base_url);
+    }
+
+    // Connect every account at once
+    Samples connect;
+    auto connect_started = Clock::now();
+    std::vector<std::future<bool>> connecting;
+    for (auto &controller: controllers) {
+      connecting.push_back(controller->connect());
+    }
+    for (auto &future: connecting) {
+      try {
+        if (future.get()) {
+          connect.millis.push_back(elapsed_ms(connect_started));
+        } else {
+          ++connect.errors;
+        }
+      } catch (const std::exception &e) {
+        ++connect.errors;
+        std::cerr << "Connect failed: " << e.what() << std::endl;
+      }
+    }
+    auto connect_seconds = elapsed_ms(connect_started) / 1000.0;
+
+    // Stagger the first operation of each vehicle across one period
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> offset(0.0, options.period);
+    std::discrete_distribution<int> pick({options.mix[FETCH], options.mix[UPDATE], options.mix[COMMAND]});
+    std::vector<Vehicle> vehicles;
+    auto started = Clock::now();
+    for (auto &controller: controllers) {
+      for (const auto &vin: controller->get_vehicles()) {
+        Vehicle vehicle;
+        vehicle.controller = controller.get();
+        vehicle.vin = vin;
+        vehicle.remote = controller->get_remote_status(vin);
+        vehicle.due = started + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(offset(random)));
+        vehicles.push_back(std::move(vehicle));
+      }
+    }
+
+    Samples samples[OPERATION_COUNT];
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.period));
+    auto stop_at = started + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+    auto cpu_started = cpu_seconds();
+
+    // One driver thread starts operations when due and collects them when done
+    for (;;) {
+      auto now = Clock::now();
+      size_t running = 0;
+      for (auto &vehicle: vehicles) {
+        if (vehicle.running.valid()) {
+          if (vehicle.running.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++running;
+            continue;
+          }
+          auto &kind = samples[vehicle.operation];
+          try {
+            if (vehicle.running.get()) {
+              kind.millis.push_back(elapsed_ms(vehicle.started));
+            } else {
+              ++kind.errors;
+            }
+          } catch (const std::exception &) {
+            ++kind.errors;
+          }
+          vehicle.due = std::max(vehicle.due + period, now);
+        }
+
+        if (now >= stop_at || now < vehicle.due) {
+          continue;
+        }
+        auto operation = static_cast<Operation>(pick(random));
+        if (!vehicle.remote) {
+          operation = FETCH;
+        }
+        vehicle.operation = operation;
+        vehicle.started = now;
+        if (operation == FETCH) {
+          vehicle.running = vehicle.controller->fetch(vehicle.vin, true);
+        } else if (operation == UPDATE) {
+          vehicle.running = vehicle.controller->update(vehicle.vin, true);
+        } else {
+          vehicle.running = vehicle.lock_next ? vehicle.controller->lock(vehicle.vin)
+                                              : vehicle.controller->unlock(vehicle.vin);
+          vehicle.lock_next = !vehicle.lock_next;
+        }
+        ++running;
+      }
+      if (now >= stop_at && running == 0) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    auto seconds = elapsed_ms(started) / 1000.0;
+    auto cpu = cpu_seconds() - cpu_started;
+    auto refreshes = samples[FETCH].millis.size();
+
+    std::printf("%zu accounts x %zu vehicles, %.0f s, one operation per vehicle every %.1f s, mix %g:%g:%g\n",
+                options.accounts, options.vehicles, options.duration, options.period,
+                options.mix[FETCH], options.mix[UPDATE], options.mix[COMMAND]);
+    std::printf("stand-in latency median %.0f ms p99 %.0f ms, commands median %.0f ms p99 %.0f ms\n\n",
+                options.latency.median_ms, options.latency.p99_ms,
+                options.command_latency.median_ms, options.command_latency.p99_ms);
+
+    std::printf("%-22s %8s %7s %9s %9s %9s %9s %9s\n", "operation", "count", "errors", "per sec",
+                "p50 ms", "p90 ms", "p99 ms", "max ms");
+    print_row("connect", connect, connect_seconds);
+    for (int i = 0; i < OPERATION_COUNT; ++i) {
+      print_row(OPERATION_NAMES[i], samples[i], seconds);
+    }
+
+    std::printf("\nvehicle refreshes      %.2f per second\n", refreshes / seconds);
+    std::printf("peak threads           %zu\n", sampler.peak_threads());
+    std::printf("peak RSS               %.1f MiB\n", sampler.peak_rss_kib() / 1024.0);
+    std::printf("CPU time               %.2f s, %.3f ms per vehicle refresh\n", cpu,
+                refreshes ? cpu * 1000.0 / refreshes : 0.0);
+
+    // Time spent in the client beyond the stand-in's delay shows up here
+    auto snapshot = subarulink::Metrics::instance().snapshot();
+    std::printf("\n%-52s %8s %9s %9s %9s\n", "endpoint", "requests", "mean ms", "p50 ms", "p99 ms");
+    for (const auto &[endpoint, stats]: snapshot.requests) {
+      std::printf("%-52s %8llu %9.1f %9.1f %9.1f\n", endpoint.c_str(), static_cast<unsigned long long>(stats.count),
+                  stats.count ? stats.sum_seconds * 1000.0 / stats.count : 0.0,
+                  stats.percentile(0.5) * 1000.0, stats.percentile(0.99) * 1000.0);
+    }
+
+    if (!options.metrics_path.empty() && !subarulink::Metrics::instance().write_prometheus(options.metrics_path)) {
+      std::cerr << "Cannot write " << options.metrics_path << std::endl;
+      status = 1;
+    }
+    if (!options.trace_path.empty() &&
+        !subarulink::Tracer::instance().write_chrome_trace(options.trace_path)) {
+      std::cerr << "Cannot write " << options.trace_path << std::endl;
+      status = 1;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Load test failed: " << e.what() << std::endl;
+    status = 1;
+  }
+
+  kill(server, SIGKILL);
+  waitpid(server, nullptr, 0);
+  return status;
+}
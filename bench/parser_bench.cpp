@@ -0,0 +1,236 @@
+// Micro-benchmarks of the response parsers on recorded, anonymized STARLINK payloads.
+//
+// Usage: subarulink_bench [--fixtures DIR] [--filter TEXT] [--min-time SECONDS]
+//
+// Each benchmark reports wall time, heap allocations and bytes allocated per
+// operation. Allocations are counted process-wide, so parsers that hand work
+// to other threads are charged for it too.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "climate_preset.h"
+
+#ifndef SUBARULINK_BENCH_FIXTURES
+#define SUBARULINK_BENCH_FIXTURES "bench/fixtures"
+#endif
+
+namespace {
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> allocated_bytes{0};
+
+  void *counted_alloc(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+      return p;
+    }
+    throw std::bad_alloc();
+  }
+}
+
+void *operator new(std::size_t size) { return counted_alloc(size); }
+void *operator new[](std::size_t size) { return counted_alloc(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try { return counted_alloc(size); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  try { return counted_alloc(size); } catch (...) { return nullptr; }
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace subarulink {
+
+  /**
+   * @brief Calls the private Controller parsers
+   */
+  class ParserBench {
+  public:
+    static void parse_vehicle(Controller &ctrl, const nlohmann::json &vehicle) {
+      ctrl._parse_vehicle(vehicle);
+    }
+
+    static nlohmann::json parse_vehicle_status(Controller &ctrl, const nlohmann::json &response,
+                                               const std::string &vin) {
+      return ctrl._parse_vehicle_status(response, vin);
+    }
+
+    static nlohmann::json parse_condition(Controller &ctrl, const nlohmann::json &response, const std::string &vin) {
+      return ctrl._parse_condition(response, vin).get();
+    }
+
+    static nlohmann::json parse_health(Controller &ctrl, const nlohmann::json &response, const std::string &vin) {
+      return ctrl._parse_health(response, vin);
+    }
+
+    static size_t parse_location(Controller &ctrl, const std::string &vin, const nlohmann::json &result) {
+      return ctrl._parse_location(vin, result).size();
+    }
+
+    static bool validate_remote_start_params(Controller &ctrl, const std::string &vin, ClimatePreset &preset) {
+      return ctrl._validate_remote_start_params(vin, preset);
+    }
+  };
+
+} // namespace subarulink
+
+namespace {
+  using subarulink::ClimatePreset;
+  using subarulink::Controller;
+  using subarulink::ParserBench;
+  using Clock = std::chrono::steady_clock;
+
+  const char *GENERATIONS[] = {"g1", "g2", "g3", "phev"};
+
+  struct Options {
+    std::string fixtures = SUBARULINK_BENCH_FIXTURES;
+    std::string filter;
+    double min_time = 0.5;
+  };
+
+  /// Keeps the optimizer from discarding a result
+  template<typename T>
+  void keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+  }
+
+  nlohmann::json load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+      throw std::runtime_error("Cannot open fixture " + path);
+    }
+    return nlohmann::json::parse(in);
+  }
+
+  void run(const Options &options, const std::string &name, const std::function<void()> &op) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+      return;
+    }
+
+    // Warm up caches and lazily built tables, then grow the batch until it runs long enough
+    op();
+    uint64_t iterations = 1;
+    for (;;) {
+      auto calls_before = allocations.load();
+      auto bytes_before = allocated_bytes.load();
+      auto started = Clock::now();
+      for (uint64_t i = 0; i < iterations; ++i) {
+        op();
+      }
+      auto elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+      if (elapsed >= options.min_time || iterations >= (uint64_t{1} << 30)) {
+        auto n = static_cast<double>(iterations);
+        std::printf("%-44s %12.0f %12.1f %12.0f %10llu\n", name.c_str(), elapsed * 1e9 / n,
+                    static_cast<double>(allocations.load() - calls_before) / n,
+                    static_cast<double>(allocated_bytes.load() - bytes_before) / n,
+                    static_cast<unsigned long long>(iterations));
+        return;
+      }
+      auto scale = elapsed > 0 ? options.min_time / elapsed * 1.2 : 10.0;
+      iterations = std::max(iterations + 1, static_cast<uint64_t>(static_cast<double>(iterations) * std::min(scale, 10.0)));
+    }
+  }
+
+  Options parse_args(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--fixtures" && i + 1 < argc) {
+        options.fixtures = argv[++i];
+      } else if (arg == "--filter" && i + 1 < argc) {
+        options.filter = argv[++i];
+      } else if (arg == "--min-time" && i + 1 < argc) {
+        options.min_time = std::stod(argv[++i]);
+      } else {
+        std::cerr << "Usage: " << argv[0] << " [--fixtures DIR] [--filter TEXT] [--min-time SECONDS]" << std::endl;
+        std::exit(arg == "--help" ? 0 : 2);
+      }
+    }
+    return options;
+  }
+}
+
+int main(int argc, char **argv) {
+  auto options = parse_args(argc, argv);
+
+  try {
+    // No request is sent; the controller only holds the parsed vehicles
+    Controller ctrl("bench@example.com", "password", "bench-device", "1234", "bench", "USA");
+
+    std::printf("%-44s %12s %12s %12s %10s\n", "benchmark", "ns/op", "allocs/op", "bytes/op", "iterations");
+    auto presets = load(options.fixtures + "/presets.json");
+
+    for (const auto *generation: GENERATIONS) {
+      auto fixture = load(options.fixtures + "/" + generation + ".json");
+      const auto &vehicle = fixture["vehicle"];
+      const auto vin = vehicle["vin"].get<std::string>();
+      const std::string suffix = std::string("/") + generation;
+      ParserBench::parse_vehicle(ctrl, vehicle);
+
+      run(options, "parse_vehicle" + suffix, [&]() {
+        ParserBench::parse_vehicle(ctrl, vehicle);
+      });
+      run(options, "parse_vehicle_status" + suffix, [&]() {
+        keep(ParserBench::parse_vehicle_status(ctrl, fixture["status"], vin));
+      });
+      run(options, "parse_condition" + suffix, [&]() {
+        keep(ParserBench::parse_condition(ctrl, fixture["condition"], vin));
+      });
+      run(options, "parse_health" + suffix, [&]() {
+        keep(ParserBench::parse_health(ctrl, fixture["health"], vin));
+      });
+      run(options, "parse_location" + suffix, [&]() {
+        keep(ParserBench::parse_location(ctrl, vin, fixture["location"]));
+      });
+
+      if (ctrl.get_res_status(vin) || ctrl.get_ev_status(vin)) {
+        // Only user presets are validated; Subaru's own presets are sent as they are
+        auto preset = ClimatePreset::from_json(nlohmann::json::parse(presets["user"]["data"].get<std::string>())[0]);
+        run(options, "validate_remote_start_params" + suffix, [&]() {
+          keep(ParserBench::validate_remote_start_params(ctrl, vin, preset));
+        });
+      }
+    }
+
+    // Preset decoding as done when the account's presets are fetched
+    run(options, "decode_subaru_presets", [&]() {
+      std::vector<ClimatePreset> decoded;
+      for (const auto &preset: presets["subaru"]["data"]) {
+        decoded.push_back(ClimatePreset::from_json(nlohmann::json::parse(preset.get<std::string>())));
+      }
+      keep(decoded);
+    });
+    run(options, "decode_user_presets", [&]() {
+      std::vector<ClimatePreset> decoded;
+      for (const auto &preset: nlohmann::json::parse(presets["user"]["data"].get<std::string>())) {
+        decoded.push_back(ClimatePreset::from_json(preset));
+      }
+      keep(decoded);
+    });
+    auto user_preset = ClimatePreset::from_json(nlohmann::json::parse(presets["user"]["data"].get<std::string>())[0]);
+    run(options, "encode_user_preset", [&]() {
+      keep(user_preset.to_json());
+    });
+  } catch (const std::exception &e) {
+    std::cerr << "Benchmark failed: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#ifndef SUBARULINK_BULK_OPERATION_HPP
+#define SUBARULINK_BULK_OPERATION_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <functional>
+
+namespace subarulink {
+
+/**
+ * @brief What an operation did for one vehicle
+ */
+  enum class BulkStatus {
+    SUCCEEDED,  ///< The operation ran and succeeded
+    SKIPPED,    ///< Nothing was due, e.g. the cache was still fresh, so nothing was sent
+    FAILED      ///< The operation ran and failed
+  };
+
+/**
+ * @brief Outcome of one vehicle in a bulk operation
+ */
+  struct BulkOutcome {
+    bool success{false};                  ///< Whether the operation succeeded or had nothing to do
+    bool skipped{false};                  ///< Nothing was due, so nothing was sent; success is true
+    std::string error;                    ///< Exception message, empty if none was thrown
+    std::chrono::milliseconds elapsed{0}; ///< Time spent on this vehicle
+  };
+
+/**
+ * @brief Called after each vehicle finishes, never concurrently
+ * @param vin Vehicle that finished
+ * @param outcome Its outcome
+ * @param completed Vehicles finished so far
+ * @param total Vehicles in the operation
+ */
+  using BulkProgressCallback = std::function<void(const std::string &vin, const BulkOutcome &outcome,
+                                                  size_t completed, size_t total)>;
+
+/**
+ * @brief Tuning for a bulk operation
+ */
+  struct BulkOptions {
+    size_t max_parallel{8};               ///< Vehicles in progress at once
+    BulkProgressCallback on_progress;     ///< Optional progress callback
+  };
+
+/**
+ * @brief Aggregate outcome of a bulk operation
+ */
+  struct BulkResult {
+    std::map <std::string, BulkOutcome> outcomes;  ///< Outcome per VIN
+    size_t succeeded{0};                  ///< Vehicles that reported success, skipped ones included
+    size_t skipped{0};                    ///< Vehicles that had nothing due
+    size_t failed{0};                     ///< Vehicles that failed or threw
+    std::chrono::milliseconds elapsed{0}; ///< Wall time of the whole operation
+
+    /**
+     * @brief Checks whether every vehicle succeeded
+     * @return True if nothing failed
+     */
+    bool all_succeeded() const { return failed == 0; }
+
+    /**
+     * @brief Lists the vehicles that did not succeed
+     * @return Failed VINs in sorted order
+     */
+    std::vector <std::string> failed_vins() const;
+  };
+
+/**
+ * @brief Runs an operation over many vehicles with bounded parallelism
+ *
+ * Up to max_parallel workers take VINs in order until none are left. The
+ * workers overlap whatever the operation spends waiting; requests that share
+ * a limited resource, such as one account's vehicle selection, still take
+ * turns there. Duplicate VINs run once. Exceptions are recorded as failures
+ * and do not stop the sweep.
+ *
+ * @param vins Vehicles to operate on
+ * @param operation Blocking operation for one vehicle, returning what it did
+ * @param options Parallelism and progress callback
+ * @return Aggregate outcome
+ */
+  BulkResult run_bulk(const std::vector <std::string> &vins,
+                      const std::function<BulkStatus(const std::string &)> &operation,
+                      const BulkOptions &options = BulkOptions());
+
+/**
+ * @brief Runs an operation that only reports success over many vehicles
+ * @param vins Vehicles to operate on
+ * @param operation Blocking operation for one vehicle, returning success
+ * @param options Parallelism and progress callback
+ * @return Aggregate outcome
+ */
+  BulkResult run_bulk(const std::vector <std::string> &vins,
+                      const std::function<bool(const std::string &)> &operation,
+                      const BulkOptions &options = BulkOptions());
+
+} // namespace subarulink
+
+#endif // SUBARULINK_BULK_OPERATION_HPP
@@ -0,0 +1,100 @@
+#pragma once
+#ifndef SUBARULINK_CHANGE_LOG_HPP
+#define SUBARULINK_CHANGE_LOG_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+
+namespace subarulink {
+
+  using FieldId = uint16_t;
+
+/**
+ * @brief Interns a vehicle field name
+ * @param name Field name such as "ODOMETER"
+ * @return Stable compact id for the name
+ */
+  FieldId field_id(const std::string &name);
+
+/**
+ * @brief Looks up the name of an interned field
+ * @param id Field id returned by field_id
+ * @return Field name
+ * @throws SubaruException if the id is unknown
+ */
+  const std::string &field_name(FieldId id);
+
+/**
+ * @brief A single field change detected while merging fetched data
+ */
+  struct FieldDelta {
+    uint64_t version;               ///< Vehicle state version that introduced the change
+    FieldId field;                  ///< Interned field name (see field_name)
+    nlohmann::json old_value;       ///< Previous value, null if the field was absent
+    nlohmann::json new_value;       ///< New value
+    std::chrono::system_clock::time_point source_time;  ///< Time the vehicle reported the data
+  };
+
+/**
+ * @brief Bounded, versioned record of field changes for one vehicle
+ *
+ * Each merge that changes at least one field commits a batch under a new
+ * version. Consumers remember the last version they processed and ask for
+ * the changes after it instead of diffing full snapshots.
+ */
+  class ChangeLog {
+  public:
+    /**
+     * @brief Constructs a change log
+     * @param capacity Maximum number of deltas retained
+     */
+    explicit ChangeLog(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Commits a batch of deltas under the next version
+     * @param deltas Changes detected by one merge; their version is overwritten
+     * @return Version after the commit, unchanged if deltas is empty
+     */
+    uint64_t commit(std::vector <FieldDelta> deltas);
+
+    /**
+     * @brief Gets changes committed after a version
+     * @param version Last version the caller has processed
+     * @return Deltas in commit order
+     */
+    std::vector <FieldDelta> since(uint64_t version) const;
+
+    /**
+     * @brief Gets the current version
+     * @return Version of the latest commit, 0 if nothing changed yet
+     */
+    uint64_t version() const { return _version; }
+
+    /**
+     * @brief Gets the newest version that lost deltas to the capacity limit
+     *
+     * since(version) is complete only when version is at least this. A caller
+     * whose last version is older has missed changes and should resynchronize
+     * from a full snapshot.
+     *
+     * @return Newest version with evicted deltas, 0 if nothing was evicted
+     */
+    uint64_t evicted_through() const { return _evicted_version; }
+
+    static constexpr size_t DEFAULT_CAPACITY = 1024;  ///< Default number of retained deltas
+
+  private:
+    size_t _capacity;                   ///< Maximum number of retained deltas
+    uint64_t _version{0};               ///< Latest committed version
+    uint64_t _evicted_version{0};       ///< Newest version with evicted deltas
+    std::deque <FieldDelta> _deltas;    ///< Retained deltas in commit order
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_CHANGE_LOG_HPP
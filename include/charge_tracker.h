@@ -0,0 +1,116 @@
+#pragma once
+#ifndef SUBARULINK_CHARGE_TRACKER_HPP
+#define SUBARULINK_CHARGE_TRACKER_HPP
+
+#include <string>
+#include <map>
+#include <chrono>
+#include <optional>
+#include <mutex>
+
+namespace subarulink {
+
+/**
+ * @brief EV charge state reported by one condition query
+ */
+  struct ChargeSample {
+    std::chrono::system_clock::time_point time;  ///< Vehicle-reported time of the condition data
+    std::optional<double> state_of_charge;       ///< Battery level in percent
+    bool charging{false};                        ///< Charger reported CHARGING
+    std::optional <std::chrono::system_clock::time_point> full_at;  ///< Vehicle's own full-charge estimate
+  };
+
+/**
+ * @brief One period of continuous charging
+ */
+  struct ChargeSession {
+    std::chrono::system_clock::time_point started;  ///< Time of the first charging sample
+    std::optional <std::chrono::system_clock::time_point> ended;  ///< Time of the first non-charging sample
+    double start_percent{0.0};                      ///< Battery level when charging was first seen
+    double percent{0.0};                            ///< Latest battery level
+    std::chrono::system_clock::time_point updated;  ///< Time of the latest sample
+    std::optional<double> rate;                     ///< Percent per hour, from successive samples
+    std::optional <std::chrono::system_clock::time_point> predicted_full;  ///< When the battery should reach 100%
+    bool completed{false};                          ///< Ended at a full battery rather than unplugged or stopped
+  };
+
+/**
+ * @brief Follows charge sessions and predicts when each will finish
+ *
+ * The charge rate is the rise in battery level between the samples where it
+ * changed, smoothed across the session, so an unchanged level between two
+ * quick polls does not skew it. Until a rate is known the vehicle's own
+ * estimate is used. The poll delay aims the next condition query at the
+ * predicted finish: far from it the delay is half the remaining time, so the
+ * rate is refined a few times, and close to it the query lands just after.
+ */
+  class ChargeTracker {
+  public:
+    static constexpr int PROBE_INTERVAL = 900;       ///< Seconds between polls while no finish time is known
+    static constexpr int MIN_POLL_INTERVAL = 60;     ///< Shortest delay returned
+    static constexpr int REFINE_THRESHOLD = 3600;    ///< Remaining seconds above which the rate is refined first
+    static constexpr int COMPLETION_MARGIN = 120;    ///< Seconds past the predicted finish for the final poll
+    static constexpr double FULL_PERCENT = 100.0;    ///< Battery level of a completed charge
+
+    /**
+     * @brief Session boundary crossed by a sample
+     */
+    enum class Transition {
+      NONE,     ///< Still charging or still idle
+      STARTED,  ///< Charging began
+      ENDED     ///< Charging stopped or completed
+    };
+
+    /**
+     * @brief Records a condition sample
+     * @param vin Vehicle identification number
+     * @param sample Parsed charge state
+     * @return Session boundary crossed by the sample, if any
+     */
+    Transition record(const std::string &vin, const ChargeSample &sample);
+
+    /**
+     * @brief Gets the current or most recent session
+     * @param vin Vehicle identification number
+     * @return Session, or nullopt if the vehicle was never seen charging
+     */
+    std::optional <ChargeSession> session(const std::string &vin) const;
+
+    /**
+     * @brief Checks if the vehicle is in a charge session
+     * @param vin Vehicle identification number
+     * @return True if the latest sample reported charging
+     */
+    bool is_charging(const std::string &vin) const;
+
+    /**
+     * @brief Computes the delay until the next condition query of a charging vehicle
+     * @param vin Vehicle identification number
+     * @param now Current time
+     * @return Seconds, or nullopt if the vehicle is not charging
+     */
+    std::optional<int> poll_delay(const std::string &vin, std::chrono::system_clock::time_point now) const;
+
+    /**
+     * @brief Forgets a vehicle's sessions
+     * @param vin Vehicle identification number
+     */
+    void reset(const std::string &vin);
+
+  private:
+    struct Track {
+      std::optional <ChargeSession> session;                 ///< Current or most recent session
+      bool active{false};                                    ///< Session still charging
+      double changed_percent{0.0};                           ///< Level at the last change
+      std::chrono::system_clock::time_point changed_at;      ///< Time of the last level change
+    };
+
+    static void _predict(ChargeSession &session, const ChargeSample &sample);
+
+    mutable std::mutex _mutex;              ///< Guards all state below
+    std::map <std::string, Track> _tracks;  ///< Per-vehicle charge state
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_CHARGE_TRACKER_HPP
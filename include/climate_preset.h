@@ -0,0 +1,90 @@
+#pragma once
+#ifndef SUBARULINK_CLIMATE_PRESET_HPP
+#define SUBARULINK_CLIMATE_PRESET_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+
+namespace subarulink {
+
+/**
+ * @brief Compiled representation of a STARLINK climate preset
+ *
+ * Wire values are decoded once into small enum codes when presets are fetched.
+ * Validation is then a bitset test per field and encoding back to the request
+ * body never re-parses JSON. Fields that are not modelled, or that carry a value
+ * outside the known set, are kept verbatim in @ref passthrough so a preset
+ * round-trips unchanged. Decoded fields that arrived as a JSON boolean or
+ * number rather than a string are encoded back with that type.
+ */
+  struct ClimatePreset {
+    enum class Mode : uint8_t { UNSET, DEFROST, FEET_DEFROST, FACE, FEET, SPLIT, AUTO };
+    enum class FanSpeed : uint8_t { UNSET, AUTO, LOW, MEDIUM, HIGH };
+    enum class HeatSeat : uint8_t { UNSET, OFF, LOW, MEDIUM, HIGH };
+    enum class Runtime : uint8_t { UNSET, MIN_5, MIN_10 };
+    enum class Toggle : uint8_t { UNSET, OFF, ON };
+    enum class Circulation : uint8_t { UNSET, OUTSIDE_AIR, RECIRCULATION };
+    enum class PresetType : uint8_t { UNSET, SUBARU, USER };
+    enum class VehicleType : uint8_t { UNSET, GAS, PHEV };
+    enum class StartConfiguration : uint8_t { UNSET, CLIMATE_ONLY, ENGINE };
+
+    std::string name;                                     ///< Preset display name
+    Mode mode{Mode::UNSET};                               ///< Front zone air mode
+    FanSpeed fan_speed{FanSpeed::UNSET};                  ///< Front zone fan speed
+    HeatSeat heat_seat_left{HeatSeat::UNSET};             ///< Driver seat heater level
+    HeatSeat heat_seat_right{HeatSeat::UNSET};            ///< Passenger seat heater level
+    Runtime runtime{Runtime::UNSET};                      ///< Engine run time
+    uint8_t temp_f{0};                                    ///< Front zone temperature in F (0 if unset)
+    uint8_t temp_c{0};                                    ///< Front zone temperature in C (0 if unset)
+    Toggle rear_defrost{Toggle::UNSET};                   ///< Heated rear window
+    Toggle rear_ac{Toggle::UNSET};                        ///< Air conditioning
+    Circulation recirculate{Circulation::UNSET};          ///< Outside air or recirculation
+    PresetType preset_type{PresetType::UNSET};            ///< Subaru-defined or user preset
+    VehicleType vehicle_type{VehicleType::UNSET};         ///< Gas or PHEV preset
+    StartConfiguration start_configuration{StartConfiguration::UNSET};  ///< Engine or climate-only start
+    Toggle can_edit{Toggle::UNSET};                       ///< Whether the preset is user editable
+    Toggle disabled{Toggle::UNSET};                       ///< Whether the preset is disabled
+    std::vector<std::pair<std::string, nlohmann::json>> passthrough;  ///< Unmodelled fields kept verbatim
+    uint32_t native_fields{0};                            ///< Bit per decoded field sent as a boolean or number
+
+    /**
+     * @brief Decodes a preset from its wire JSON object
+     * @param preset JSON preset object
+     * @return Decoded preset
+     */
+    static ClimatePreset from_json(const nlohmann::json &preset);
+
+    /**
+     * @brief Encodes the preset back to its wire JSON object
+     * @return JSON preset object
+     */
+    nlohmann::json to_json() const;
+
+    /**
+     * @brief Assigns a single wire field
+     * @param key Wire field name
+     * @param value Wire field value
+     * @return True if the field was decoded into a typed member, false if kept as passthrough
+     */
+    bool assign(const std::string &key, const nlohmann::json &value);
+
+    /**
+     * @brief Validates the preset against the allowed remote start options
+     * @throws SubaruException if a validated field holds a disallowed value
+     */
+    void validate() const;
+
+    /**
+     * @brief Checks if this is a user-defined preset
+     * @return True if preset type is userPreset
+     */
+    bool is_user_preset() const { return preset_type == PresetType::USER; }
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_CLIMATE_PRESET_HPP
@@ -0,0 +1,98 @@
+#pragma once
+#ifndef SUBARULINK_COMMAND_QUEUE_HPP
+#define SUBARULINK_COMMAND_QUEUE_HPP
+
+#include <string>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <functional>
+#include <mutex>
+
+#include "remote_command.h"
+#include "strand.h"
+
+namespace subarulink {
+
+/**
+ * @brief How queued commands of one vehicle interact
+ */
+  struct CommandRules {
+    /// Commands sharing a group supersede each other while queued; only the last one is sent
+    std::map <std::string, std::string> exclusive_group;
+    /// Stop command -> command it undoes; the stop drops its queued counterpart
+    std::map <std::string, std::string> cancels;
+  };
+
+/**
+ * @brief Serial queue of remote commands for one vehicle
+ *
+ * Commands are sent one at a time in submission order, so this library never
+ * races itself into ServiceAlreadyStarted. While a command waits:
+ * - an identical command joins it and shares its result,
+ * - a command in the same exclusive group replaces it (the last lock/unlock wins),
+ * - its stop command cancels it.
+ * A command that was already sent is never affected.
+ *
+ * Stop commands go ahead of every queued command and are sent right after the
+ * command in flight, so a stop for a running horn waits out the horn's own
+ * polling rather than racing it into ServiceAlreadyStarted. A stop is always
+ * sent, since the vehicle may have been started outside this library, except
+ * when it only dropped a queued counterpart and nothing this queue sent is
+ * running or in effect.
+ */
+  class CommandQueue {
+  public:
+    using Dispatch = std::function<RemoteCommand::Result(const std::shared_ptr <RemoteCommand> &command)>;
+    using Settled = std::function<void(const std::shared_ptr <RemoteCommand> &command, RemoteCommandState state)>;
+
+    /**
+     * @brief Constructs an empty queue
+     * @param dispatch Sends one command and waits for its outcome
+     * @param rules Collapsing and cancellation rules
+     * @param settled Called before the queue finishes a command without sending it
+     */
+    CommandQueue(Dispatch dispatch, CommandRules rules, Settled settled = nullptr);
+
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    /**
+     * @brief Queues a command; stop commands go ahead of the other queued commands
+     * @param command Command to send
+     * @return The command that will carry the outcome; an identical queued one if joined
+     */
+    std::shared_ptr <RemoteCommand> submit(std::shared_ptr <RemoteCommand> command);
+
+    /**
+     * @brief Removes a queued command that has not been sent yet and finishes it as cancelled
+     * @param command Command to remove
+     * @return True if the command was still queued
+     */
+    bool withdraw(const std::shared_ptr <RemoteCommand> &command);
+
+    /**
+     * @brief Gets the number of commands waiting to be sent
+     * @return Queued commands including stops, excluding the one in flight
+     */
+    size_t pending() const;
+
+  private:
+    void _dispatch_next();
+    void _settle(const std::shared_ptr <RemoteCommand> &command, RemoteCommandState state,
+                 RemoteCommand::Result result);
+
+    Dispatch _dispatch;                         ///< Sends one command
+    CommandRules _rules;                        ///< Collapsing rules
+    Settled _settled;                           ///< Notified of commands finished unsent
+    mutable std::mutex _mutex;                  ///< Guards the pending list, _running and _in_effect
+    std::deque <std::shared_ptr<RemoteCommand>> _pending;  ///< Commands not yet sent, oldest first
+    std::shared_ptr <RemoteCommand> _running;   ///< Queued command being sent
+    std::set <std::string> _in_effect;          ///< Commands that succeeded and have not been stopped since
+    Strand _strand;                             ///< Sends commands one at a time; destroyed first
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_COMMAND_QUEUE_HPP
@@ -10,15 +10,43 @@
 #include <chrono>
 #include <future>
 #include <mutex>
+#include <condition_variable>
+#include <cstdint>
 
 #include "cpr/cpr.h"
 #include "nlohmann/json.hpp"
 #include "exceptions.h"
+#include "rate_limiter.h"
 
 namespace subarulink {
 
   class Connection {
   public:
+    /**
+     * @brief Holds the account's vehicle selection for one VIN
+     *
+     * The server scopes vehicle requests to the vehicle last selected on the
+     * account session, so requests for different vehicles must not interleave.
+     * Lanes are granted in arrival order: any number of lanes for the selected
+     * VIN may be held at once, but once a lane for another VIN is waiting, later
+     * lanes queue behind it. A thread must therefore never wait for a second
+     * lane while holding one. Hold a lane only around selecting the vehicle
+     * and the one request that depends on it, so other vehicles on the account
+     * wait for at most that round trip.
+     */
+    class VehicleLane {
+    public:
+      VehicleLane(Connection& connection, const std::string& vin);
+      ~VehicleLane();
+
+      VehicleLane(const VehicleLane&) = delete;
+      VehicleLane& operator=(const VehicleLane&) = delete;
+
+    private:
+      Connection& _connection;
+    };
+
+
     // Constructor declaration only - implementation goes in .cpp
     Connection(const std::string& username,
                const std::string& password,
@@ -29,6 +57,8 @@ namespace subarulink {
     // Async methods - implementations in .cpp
     std::future<std::vector<nlohmann::json>> connect();
     std::future<bool> validate_session(const std::string& vin);
+    // Selects the vehicle without validating the session, unless it is already selected; hold its lane
+    std::future<bool> select_vehicle(const std::string& vin);
     std::future<bool> request_auth_code(const std::string& contact_method);
     std::future<bool> submit_auth_code(const std::string& code, bool make_permanent = true);
 
@@ -40,6 +70,14 @@ namespace subarulink {
     double get_session_age() const;
     void reset_session();
 
+    // Sends requests to base_url (scheme, host and API version) instead of STARLINK, e.g. a
+    // local stand-in; empty restores the default. Call before connect()
+    void set_base_url(const std::string& base_url);
+
+    // Caps the rate of every request sent for the account, logins and session checks included
+    void set_rate_limit(double requests_per_second, double burst = 1.0);
+    double get_rate_limit() const;
+
     // HTTP methods - implementations in .cpp
     std::future<nlohmann::json> get(const std::string& url,
                                     const std::map<std::string, std::string>& params = {});
@@ -55,6 +93,7 @@ namespace subarulink {
     std::string _device_name;
     std::string _country;
     std::string _current_vin;
+    std::string _base_url;
 
     bool _authenticated{false};
     bool _registered{false};
@@ -64,15 +103,34 @@ namespace subarulink {
     std::vector<nlohmann::json> _vehicles;
     std::map<std::string, std::string> _auth_contact_options;
     std::map<std::string, std::string> _headers;
+    RateLimiter _limiter;
 
+    // Requests run concurrently on pooled HTTP sessions that share the account cookies;
+    // _mutex only guards the pool and cookie map, never a request in flight
     std::mutex _mutex;
-    std::shared_ptr<cpr::Session> _session;
+    std::vector<std::shared_ptr<cpr::Session>> _idle_sessions;
+    std::map<std::string, std::string> _cookies;
+    uint64_t _session_generation{0};
+
+    // Vehicle selection lane; _current_vin is guarded by _mutex
+    std::mutex _lane_mutex;
+    std::condition_variable _lane_cv;
+    std::string _lane_vin;
+    size_t _lane_users{0};
+    uint64_t _lane_next_ticket{0};  // Ticket handed to the next lane to arrive
+    uint64_t _lane_serving{0};      // Ticket of the oldest lane still waiting
 
     // Private method declarations - implementations in .cpp
     std::future<bool> _authenticate(const std::string& vin = "");
     std::future<nlohmann::json> _select_vehicle(const std::string& vin);
     std::future<void> _get_vehicle_data();
     std::future<void> _get_contact_methods();
+    void _set_current_vin(const std::string& vin);
+    std::string _get_current_vin();
+
+    // Session pool helpers - implementations in .cpp
+    std::shared_ptr<cpr::Session> _acquire_session(uint64_t& generation);
+    void _release_session(std::shared_ptr<cpr::Session> session, uint64_t generation, const cpr::Cookies& cookies);
 
     // HTTP request helper - implementation in .cpp
     std::future<nlohmann::json> _make_request(
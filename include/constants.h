@@ -6,6 +6,7 @@
 #include <vector>
 #include <map>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 namespace subarulink {
@@ -39,6 +40,9 @@ namespace vehicle_fields {
     const std::string TIRE_PRESSURE_FR = "TIRE_PRESSURE_FR";
     const std::string TIRE_PRESSURE_RL = "TIRE_PRESSURE_RL";
     const std::string TIRE_PRESSURE_RR = "TIRE_PRESSURE_RR";
+    const std::string VEHICLE_STATE = "VEHICLE_STATE";
+    const std::string VEHICLE_STATE_IGNITION_ON = "IGNITION_ON";
+    const std::string VEHICLE_STATE_IGNITION_OFF = "IGNITION_OFF";
 }
 
 // Vehicle health status
@@ -99,26 +103,26 @@ namespace climate_control {
   const std::string RUNTIME_5_MIN = "5";
 
   struct Mode {
-    static const std::string DEFROST;
-    static const std::string FEET_DEFROST;
-    static const std::string FACE;
-    static const std::string FEET;
-    static const std::string SPLIT;
-    static const std::string AUTO;
+    static inline const std::string DEFROST = "DEFROST";
+    static inline const std::string FEET_DEFROST = "FEET_DEFROST";
+    static inline const std::string FACE = "FACE";
+    static inline const std::string FEET = "FEET";
+    static inline const std::string SPLIT = "SPLIT";
+    static inline const std::string AUTO = "AUTO";
   };
 
   struct HeatSeat {
-    static const std::string HIGH;
-    static const std::string MEDIUM;
-    static const std::string LOW;
-    static const std::string OFF;
+    static inline const std::string HIGH = "HIGH";
+    static inline const std::string MEDIUM = "MEDIUM";
+    static inline const std::string LOW = "LOW";
+    static inline const std::string OFF = "OFF";
   };
 
   struct FanSpeed {
-    static const std::string LOW;
-    static const std::string MEDIUM;
-    static const std::string HIGH;
-    static const std::string AUTO;
+    static inline const std::string LOW = "LOW";
+    static inline const std::string MEDIUM = "MEDIUM";
+    static inline const std::string HIGH = "HIGH";
+    static inline const std::string AUTO = "AUTO";
   };
 
   // Temperature controls
@@ -162,6 +166,10 @@ namespace climate_control {
   const std::string DISABLED_VALUE = "false";
   const std::string PRESET_TYPE = "presetType";
   const std::string PRESET_TYPE_USER = "userPreset";
+  const std::string PRESET_TYPE_SUBARU = "subaruPreset";
+  const std::string VEHICLE_TYPE = "vehicleType";
+  const std::string VEHICLE_TYPE_GAS = "gas";
+  const std::string VEHICLE_TYPE_PHEV = "phev";
   const std::string START_CONFIGURATION = "startConfiguration";
   const std::string START_CONFIGURATION_EV = "START_CLIMATE_CONTROL_ONLY_ALLOW_KEY_IN_IGNITION";
   const std::string START_CONFIGURATION_RES = "START_ENGINE_ALLOW_KEY_IN_IGNITION";
@@ -219,6 +227,15 @@ namespace door {
     const std::vector<std::string> VALID_DOORS = {ALL_DOORS, DRIVERS_DOOR, TAILGATE_DOOR};
 }
 
+// EV charge values
+namespace ev_charge {
+    const std::string CHARGING = "CHARGING";
+    const std::string CHARGING_STOPPED = "CHARGING_STOPPED";
+    const std::string LOCKED_CONNECTED = "LOCKED_CONNECTED";
+    const std::string UNLOCKED_CONNECTED = "UNLOCKED_CONNECTED";
+    const std::string DISCONNECTED = "DISCONNECTED";
+}
+
 // Error values
 namespace error_values {
     const std::string BAD_AVG_FUEL_CONSUMPTION = "16383";
@@ -227,7 +244,7 @@ namespace error_values {
     const std::string BAD_TIRE_PRESSURE = "32767";
     const double BAD_LONGITUDE = 180.0;
     const double BAD_LATITUDE = 90.0;
-    constexpr nullptr_t BAD_ODOMETER = nullptr;
+    constexpr std::nullptr_t BAD_ODOMETER = nullptr;
     const std::string UNKNOWN = "UNKNOWN";
     const std::string NOT_EQUIPPED = "NOT_EQUIPPED";
 }
@@ -235,6 +252,10 @@ namespace error_values {
 // Time intervals
 const int POLL_INTERVAL = 7200;
 const int FETCH_INTERVAL = 300;
+const int PRESET_INTERVAL = 86400;
+const int CONDITION_INTERVAL = 60;
+const int HEALTH_INTERVAL = 21600;
+const int LOCATION_INTERVAL = 300;
 
 // Vehicle information keys
 namespace vehicle_info {
@@ -282,6 +303,14 @@ const std::vector<std::string> RAW_API_FIELDS_TO_REDACT = {
     "zip"
 };
 
+// Request fields never written to logs
+const std::vector<std::string> CREDENTIAL_FIELDS_TO_REDACT = {
+    "loginUsername",
+    "password",
+    "passwordToken",
+    "pin"
+};
+
 } // namespace subarulink
 
 #endif // SUBARULINK_CONSTANTS_HPP
@@ -9,12 +9,68 @@
 #include <chrono>
 #include <future>
 #include <mutex>
+#include <atomic>
+#include <optional>
+#include <functional>
 
 #include "nlohmann/json.hpp"
+#include "constants.h"
+#include "bulk_operation.h"
+#include "change_log.h"
+#include "charge_tracker.h"
+#include "climate_preset.h"
+#include "command_queue.h"
+#include "remote_command.h"
 #include "connection.h"
+#include "latency_profile.h"
+#include "location_history.h"
+#include "metrics.h"
+#include "trace.h"
+#include "event_bus.h"
+#include "poll_policy.h"
+#include "poll_scheduler.h"
+#include "spatial_index.h"
+#include "status_poller.h"
+#include "strand.h"
+#include "timeseries_store.h"
 
 namespace subarulink {
 
+/**
+ * @brief Groups of vehicle data that can be fetched and aged independently
+ */
+  enum class FetchGroup : uint8_t {
+    NONE = 0,
+    STATUS = 1 << 0,     ///< vehicleStatus.json: odometer, fuel economy, tire pressure
+    CONDITION = 1 << 1,  ///< Condition query: doors, windows, EV state
+    HEALTH = 1 << 2,     ///< vehicleHealth.json trouble indicators
+    LOCATION = 1 << 3,   ///< Last reported location
+    PRESETS = 1 << 4,    ///< Climate presets
+    ALL = 0x1F
+  };
+
+  inline FetchGroup operator|(FetchGroup a, FetchGroup b) {
+    return static_cast<FetchGroup>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+  }
+
+  inline FetchGroup operator&(FetchGroup a, FetchGroup b) {
+    return static_cast<FetchGroup>(static_cast<uint8_t>(a) & static_cast<uint8_t>(b));
+  }
+
+  inline FetchGroup &operator|=(FetchGroup &a, FetchGroup b) {
+    return a = a | b;
+  }
+
+  /**
+   * @brief Checks if a group mask contains a group
+   * @param groups Group mask
+   * @param group Single group to test
+   * @return True if group is set in groups
+   */
+  inline bool has_group(FetchGroup groups, FetchGroup group) {
+    return group != FetchGroup::NONE && (groups & group) == group;
+  }
+
 /**
  * @brief Structure containing comprehensive vehicle information and status
  */
@@ -27,9 +83,20 @@ namespace subarulink {
     std::string subscription_status;     ///< Current subscription status
     std::map <std::string, nlohmann::json> vehicle_status;  ///< Current vehicle status information
     std::map <std::string, nlohmann::json> vehicle_health;  ///< Vehicle health information
-    std::vector <nlohmann::json> climate;  ///< Climate control presets
+    std::vector <ClimatePreset> climate;  ///< Climate control presets
     std::chrono::system_clock::time_point last_fetch;  ///< Timestamp of last data fetch
     std::chrono::system_clock::time_point last_update;  ///< Timestamp of last update
+    std::map <FetchGroup, std::chrono::system_clock::time_point> group_last_fetch;  ///< Last successful fetch per group
+    uint64_t version{0};  ///< Change log version this snapshot reflects
+  };
+
+/**
+ * @brief Cached vehicle data returned without waiting for the network
+ */
+  struct VehicleSnapshot {
+    VehicleInfo data;                   ///< Latest cached vehicle data
+    std::chrono::seconds age{std::chrono::seconds::max()};  ///< Time since the last status fetch, max if never fetched
+    bool refreshing{false};             ///< A background refresh is in flight
   };
 
 /**
@@ -220,6 +287,19 @@ namespace subarulink {
      */
     std::future <VehicleInfo> get_data(const std::string &vin);
 
+    /**
+     * @brief Gets cached vehicle data immediately, refreshing it in the background when stale
+     * @param vin Vehicle identification number
+     * @param max_staleness Block on the refresh only if the cache is older than this
+     * @return Latest snapshot with its age
+     * @throws SubaruException if VIN is invalid, or the blocking refresh fails
+     *
+     * Data older than the fetch interval starts one background refresh per
+     * vehicle; concurrent readers share it instead of starting their own.
+     */
+    VehicleSnapshot get_snapshot(const std::string &vin,
+                                 std::optional <std::chrono::seconds> max_staleness = std::nullopt);
+
     /**
      * @brief Gets raw API response data
      * @param vin Vehicle identification number
@@ -228,6 +308,69 @@ namespace subarulink {
      */
     nlohmann::json get_raw_data(const std::string &vin) const;
 
+    /**
+     * @brief Gets the ignition state reported with the last vehicle status
+     * @param vin Vehicle identification number
+     * @return Ignition state, or empty if the vehicle has not reported one
+     * @throws SubaruException if VIN is invalid
+     */
+    std::optional <VehicleState> get_vehicle_state(const std::string &vin) const;
+
+    /**
+     * @brief Gets the current change log version of a vehicle
+     * @param vin Vehicle identification number
+     * @return Version of the latest change, 0 if nothing changed yet
+     * @throws SubaruException if VIN is invalid
+     */
+    uint64_t get_version(const std::string &vin) const;
+
+    /**
+     * @brief Gets field changes recorded after a version
+     *
+     * Only the most recent changes are retained. If version is older than
+     * get_evicted_through, some changes after it are gone: truncated is set
+     * and the caller should resynchronize from get_data.
+     *
+     * @param vin Vehicle identification number
+     * @param version Last version the caller has processed
+     * @param truncated Optional; set to whether changes after version were evicted
+     * @return Field deltas in the order they were detected
+     * @throws SubaruException if VIN is invalid
+     */
+    std::vector <FieldDelta> get_changes_since(const std::string &vin, uint64_t version,
+                                               bool *truncated = nullptr) const;
+
+    /**
+     * @brief Gets the newest change log version that lost changes to the retention limit
+     * @param vin Vehicle identification number
+     * @return get_changes_since is complete for versions at least this; 0 if nothing was evicted
+     * @throws SubaruException if VIN is invalid
+     */
+    uint64_t get_evicted_through(const std::string &vin) const;
+
+    /**
+     * @brief Subscribes to vehicle change events
+     * @param types Mask of event types to receive
+     * @param callback Function invoked for each matching event
+     * @param vin Only receive events for this vehicle, or all vehicles if empty
+     * @return Id for unsubscribe
+     * @note Callbacks run on the event executor, never while vehicle state is locked
+     */
+    SubscriptionId subscribe(EventType types, EventCallback callback, const std::string &vin = "");
+
+    /**
+     * @brief Removes an event subscription
+     * @param id Id returned by subscribe
+     * @return True if the subscription existed
+     */
+    bool unsubscribe(SubscriptionId id);
+
+    /**
+     * @brief Sets the executor used to run event callbacks
+     * @param executor Executor receiving one job per callback, or nullptr for the built-in dispatch thread
+     */
+    void set_event_executor(Executor executor);
+
     /**
      * @brief Lists available climate control presets
      * @param vin Vehicle identification number
@@ -269,6 +412,21 @@ namespace subarulink {
     std::future<bool>
     update_user_climate_presets(const std::string &vin, const std::vector <nlohmann::json> &preset_data);
 
+    /**
+     * @brief Updates user climate presets from typed presets
+     * @param vin Vehicle identification number
+     * @param presets Vector of preset configurations
+     * @return Future containing success status
+     */
+    std::future<bool>
+    update_user_climate_presets(const std::string &vin, const std::vector <ClimatePreset> &presets);
+
+    /**
+     * @brief Refetches the account climate presets regardless of cache age
+     * @return Future containing success status
+     */
+    std::future<bool> refresh_climate_presets();
+
     // Data Update Methods
 
     /**
@@ -279,6 +437,19 @@ namespace subarulink {
      */
     std::future<bool> fetch(const std::string &vin, bool force = false);
 
+    /**
+     * @brief Fetches selected groups of vehicle data
+     *
+     * Only requested groups older than their interval (see set_group_interval)
+     * hit the network.
+     *
+     * @param vin Vehicle identification number
+     * @param groups Mask of groups to refresh
+     * @param force Fetch requested groups regardless of age
+     * @return Future containing true if any group was fetched and all fetched groups succeeded
+     */
+    std::future<bool> fetch(const std::string &vin, FetchGroup groups, bool force = false);
+
     /**
      * @brief Updates vehicle location
      * @param vin Vehicle identification number
@@ -315,6 +486,150 @@ namespace subarulink {
      */
     bool set_fetch_interval(int value);
 
+    /**
+     * @brief Saves the learned remote command completion times
+     * @param path Destination file
+     * @return True if written
+     */
+    bool save_latency_profiles(const std::string &path) const;
+
+    /**
+     * @brief Loads remote command completion times saved by an earlier run
+     * @param path Source file
+     * @return True if loaded
+     *
+     * Status polls for each command and telematics generation are scheduled
+     * around its learned completion time once enough samples exist.
+     */
+    bool load_latency_profiles(const std::string &path);
+
+    // Background Polling
+
+    /**
+     * @brief Starts polling every vehicle in the background
+     * @param include_updates Also send locate commands every update interval
+     *
+     * Each vehicle is fetched once per fetch interval (and located once per
+     * update interval) at a random phase, so the fleet's requests are spread
+     * evenly. Interval changes apply from each vehicle's next poll.
+     */
+    void start_polling(bool include_updates = false);
+
+    /**
+     * @brief Stops background polling and waits for running polls
+     */
+    void stop_polling();
+
+    /**
+     * @brief Suspends background polling for a vehicle
+     * @param vin Vehicle identification number
+     * @return True if background polling includes the vehicle
+     */
+    bool pause_polling(const std::string &vin);
+
+    /**
+     * @brief Resumes background polling for a vehicle
+     * @param vin Vehicle identification number
+     * @return True if background polling includes the vehicle
+     */
+    bool resume_polling(const std::string &vin);
+
+    /**
+     * @brief Checks if background polling is paused for a vehicle
+     * @param vin Vehicle identification number
+     * @return True if paused
+     */
+    bool is_polling_paused(const std::string &vin) const;
+
+    /**
+     * @brief Enables or disables adaptive background poll intervals
+     * @param enabled True to adapt each vehicle's interval to its activity
+     *
+     * Vehicles with the ignition on are polled at the active poll interval,
+     * vehicles whose data moved at the fetch interval, and each fetch that
+     * returns nothing new doubles a vehicle's interval up to a limit.
+     */
+    void set_adaptive_polling(bool enabled);
+
+    /**
+     * @brief Checks if adaptive background poll intervals are enabled
+     * @return True if enabled
+     */
+    bool get_adaptive_polling() const;
+
+    /**
+     * @brief Sets the background poll interval for vehicles with the ignition on
+     * @param value Interval in seconds, minimum 60
+     * @return True if value was accepted
+     */
+    bool set_active_poll_interval(int value);
+
+    /**
+     * @brief Gets the interval until a vehicle's next background fetch
+     * @param vin Vehicle identification number
+     * @return Interval in seconds
+     */
+    int get_poll_interval(const std::string &vin) const;
+
+    /**
+     * @brief Caps the rate of API requests sent by this controller
+     *
+     * Covers every request, including logins, session validation and
+     * vehicle selection.
+     *
+     * @param requests_per_second Sustained request rate, or 0 for no limit
+     * @param burst Requests allowed back to back
+     */
+    void set_request_rate_limit(double requests_per_second, double burst = 1.0);
+
+    /**
+     * @brief Gets the request rate cap
+     * @return Requests per second, 0 if unlimited
+     */
+    double get_request_rate_limit() const;
+
+    /**
+     * @brief Sends API requests to another server instead of STARLINK
+     *
+     * Meant for load tests and local stand-ins; call it before connect().
+     *
+     * @param base_url Scheme, host and API version path, e.g. http://127.0.0.1:8080/g2v30,
+     *                 or empty for STARLINK
+     */
+    void set_base_url(const std::string &base_url);
+
+    /**
+     * @brief Gets climate preset cache lifetime
+     * @return Preset cache lifetime in seconds
+     */
+    int get_preset_interval() const;
+
+    /**
+     * @brief Sets climate preset cache lifetime
+     * @param value New lifetime in seconds
+     * @return True if value was accepted
+     */
+    bool set_preset_interval(int value);
+
+    /**
+     * @brief Gets freshness interval of a fetch group
+     * @param group Single fetch group
+     * @return Interval in seconds
+     */
+    int get_group_interval(FetchGroup group) const;
+
+    /**
+     * @brief Sets freshness interval of a fetch group
+     *
+     * STATUS is the fetch interval and PRESETS the preset interval, so their
+     * minimums apply.
+     *
+     * @param group Single fetch group
+     * @param value New interval in seconds (minimum 60)
+     * @return True if value was accepted
+     */
+    bool set_group_interval(FetchGroup group, int value);
+
     // Time Related Methods
 
     /**
@@ -400,6 +715,319 @@ namespace subarulink {
      */
     std::future<bool> remote_start(const std::string &vin, const std::string &preset_name);
 
+    // Remote Command Handles
+
+    /**
+     * @brief Queues a lock and returns its handle
+     *
+     * The *_command methods return as soon as the command is queued. The
+     * handle reports queued/sent/polling/succeeded/failed/cancelled with
+     * timestamps and the serviceRequestId, and cancel() calls the matching
+     * cancel endpoint.
+     *
+     * @param vin Vehicle identification number
+     * @return Command handle
+     * @throws VehicleNotSupported without an active remote services subscription
+     */
+    CommandHandle lock_command(const std::string &vin);
+
+    /**
+     * @brief Queues an unlock and returns its handle
+     * @param vin Vehicle identification number
+     * @param door Door to unlock ("ALL_DOORS_CMD", "FRONT_LEFT_DOOR_CMD", or "TAILGATE_DOOR_CMD")
+     * @return Command handle
+     * @throws SubaruException if the door is invalid
+     */
+    CommandHandle unlock_command(const std::string &vin, const std::string &door = "ALL_DOORS_CMD");
+
+    /**
+     * @brief Queues exterior lights and returns their handle
+     * @param vin Vehicle identification number
+     * @return Command handle
+     */
+    CommandHandle lights_command(const std::string &vin);
+
+    /**
+     * @brief Queues horn and lights and returns their handle
+     * @param vin Vehicle identification number
+     * @return Command handle
+     */
+    CommandHandle horn_command(const std::string &vin);
+
+    /**
+     * @brief Queues a remote engine start and returns its handle
+     *
+     * The preset is saved as the quick start setting when the command reaches
+     * the front of the queue.
+     *
+     * @param vin Vehicle identification number
+     * @param preset_name Climate preset to use
+     * @return Command handle
+     * @throws VehicleNotSupported if remote start is not available
+     * @throws SubaruException if the preset is not found
+     */
+    CommandHandle remote_start_command(const std::string &vin, const std::string &preset_name);
+
+    // Fleet Methods
+
+    /**
+     * @brief Locks many vehicles
+     *
+     * Every bulk method runs at most options.max_parallel vehicles at once.
+     * Requests still share the account's rate limit (see set_request_rate_limit),
+     * and requests that depend on the vehicle selection take turns across the
+     * account's vehicles, so parallelism mostly overlaps status polling and
+     * per-vehicle work rather than those round trips.
+     *
+     * @param vins Vehicle identification numbers
+     * @param options Parallelism and progress callback
+     * @return Future containing the outcome per vehicle
+     */
+    std::future <BulkResult> bulk_lock(const std::vector <std::string> &vins,
+                                       const BulkOptions &options = BulkOptions());
+
+    /**
+     * @brief Unlocks many vehicles
+     * @param vins Vehicle identification numbers
+     * @param door Door to unlock on every vehicle
+     * @param options Parallelism and progress callback
+     * @return Future containing the outcome per vehicle
+     */
+    std::future <BulkResult> bulk_unlock(const std::vector <std::string> &vins,
+                                         const std::string &door = "ALL_DOORS_CMD",
+                                         const BulkOptions &options = BulkOptions());
+
+    /**
+     * @brief Activates exterior lights on many vehicles
+     * @param vins Vehicle identification numbers
+     * @param options Parallelism and progress callback
+     * @return Future containing the outcome per vehicle
+     */
+    std::future <BulkResult> bulk_lights(const std::vector <std::string> &vins,
+                                         const BulkOptions &options = BulkOptions());
+
+    /**
+     * @brief Updates the location of many vehicles
+     * @param vins Vehicle identification numbers
+     * @param force Update regardless of cache
+     * @param options Parallelism and progress callback
+     * @return Future containing the outcome per vehicle; without force, vehicles whose location
+     *         is still fresh are skipped and count as succeeded
+     */
+    std::future <BulkResult> bulk_update(const std::vector <std::string> &vins,
+                                         bool force = false,
+                                         const BulkOptions &options = BulkOptions());
+
+    /**
+     * @brief Fetches selected groups of data for many vehicles
+     * @param vins Vehicle identification numbers
+     * @param groups Mask of groups to refresh
+     * @param force Fetch regardless of age
+     * @param options Parallelism and progress callback
+     * @return Future containing the outcome per vehicle; without force, vehicles whose requested
+     *         groups are all fresh are skipped and count as succeeded
+     */
+    std::future <BulkResult> bulk_fetch(const std::vector <std::string> &vins,
+                                        FetchGroup groups = FetchGroup::ALL,
+                                        bool force = false,
+                                        const BulkOptions &options = BulkOptions());
+
+    // Fleet Location
+
+    /**
+     * @brief Finds vehicles near a point
+     *
+     * Location queries read a spatial index of the latest valid position of
+     * each vehicle, kept current by fetch and update; they send no requests.
+     *
+     * @param center Center point
+     * @param radius_m Radius in meters
+     * @return VINs, nearest first
+     */
+    std::vector <std::string> get_vehicles_within(const GeoPoint &center, double radius_m) const;
+
+    /**
+     * @brief Finds vehicles inside a rectangle
+     * @param south_west Lower-left corner
+     * @param north_east Upper-right corner
+     * @return VINs in sorted order
+     */
+    std::vector <std::string> get_vehicles_in_box(const GeoPoint &south_west, const GeoPoint &north_east) const;
+
+    /**
+     * @brief Finds vehicles inside a polygon
+     * @param vertices At least three vertices
+     * @return VINs in sorted order
+     */
+    std::vector <std::string> get_vehicles_in_polygon(const std::vector <GeoPoint> &vertices) const;
+
+    /**
+     * @brief Registers or replaces a geofence
+     *
+     * Location updates that cross a registered fence publish GEOFENCE events.
+     * Vehicles already inside when the fence is added raise no event.
+     *
+     * @param fence Fence to register
+     */
+    void add_geofence(const Geofence &fence);
+
+    /**
+     * @brief Removes a geofence
+     * @param id Fence identifier
+     * @return True if the fence existed
+     */
+    bool remove_geofence(const std::string &id);
+
+    /**
+     * @brief Gets every registered geofence
+     * @return Fences ordered by id
+     */
+    std::vector <Geofence> get_geofences() const;
+
+    /**
+     * @brief Finds vehicles inside a registered geofence
+     * @param id Fence identifier
+     * @return VINs in sorted order
+     */
+    std::vector <std::string> get_vehicles_in_geofence(const std::string &id) const;
+
+    /**
+     * @brief Gets the geofences a vehicle is inside
+     * @param vin Vehicle identification number
+     * @return Fence ids in sorted order
+     */
+    std::vector <std::string> get_geofences_containing(const std::string &vin) const;
+
+    /**
+     * @brief Enables or disables recording every valid location in memory
+     * @param enabled Whether fetch and update append positions to the history
+     * @param max_samples Positions kept per vehicle
+     */
+    void set_location_history(bool enabled, size_t max_samples = 100000);
+
+    /**
+     * @brief Checks whether locations are being recorded
+     * @return True if enabled
+     */
+    bool get_location_history() const;
+
+    /**
+     * @brief Gets recorded positions of a vehicle
+     * @param vin Vehicle identification number
+     * @param from Start of the range, inclusive
+     * @param to End of the range, inclusive
+     * @return Positions, oldest first
+     */
+    std::vector <LocationSample> get_location_trace(const std::string &vin,
+                                                    std::chrono::system_clock::time_point from,
+                                                    std::chrono::system_clock::time_point to) const;
+
+    /**
+     * @brief Gets an EV's current or most recent charge session
+     *
+     * Sessions are followed from the charge state of each condition query.
+     * With adaptive polling, a charging vehicle is polled around its predicted
+     * finish instead of at the fetch interval.
+     *
+     * @param vin Vehicle identification number
+     * @return Session with its derived charge rate, or nullopt if never seen charging
+     */
+    std::optional <ChargeSession> get_charge_session(const std::string &vin) const;
+
+    /**
+     * @brief Enables or disables recording numeric fields into a compressed time series store
+     *
+     * Odometer, average fuel consumption, tire pressures, EV range and charge
+     * level are appended as fetch parses them, without extra requests. Enabling again
+     * with the same directory only changes the retention; disabling releases
+     * the store after writing its open segments.
+     *
+     * @param enabled Whether fetch appends field values
+     * @param directory Segment file directory, empty to keep the history in memory
+     * @param retention Limits applied to every series
+     * @throws SubaruException if the directory cannot be created
+     */
+    void set_field_history(bool enabled, const std::string &directory = "",
+                           const TimeSeriesRetention &retention = {});
+
+    /**
+     * @brief Checks whether numeric fields are being recorded
+     * @return True if enabled
+     */
+    bool get_field_history() const;
+
+    /**
+     * @brief Gets recorded values of a numeric field
+     * @param vin Vehicle identification number
+     * @param field Field name, e.g. ODOMETER
+     * @param from Start of the range, inclusive
+     * @param to End of the range, inclusive
+     * @return Values, oldest first; empty if recording is disabled
+     */
+    std::vector <TimeSeriesPoint> get_field_series(const std::string &vin, const std::string &field,
+                                                   std::chrono::system_clock::time_point from,
+                                                   std::chrono::system_clock::time_point to) const;
+
+    /**
+     * @brief Gets recorded values of a numeric field aggregated into fixed-width buckets
+     * @param vin Vehicle identification number
+     * @param field Field name, e.g. TIRE_PRESSURE_FL
+     * @param from Start of the range and of the first bucket
+     * @param to End of the range, inclusive
+     * @param width Bucket width
+     * @return Non-empty buckets with min, max and average, oldest first
+     */
+    std::vector <TimeSeriesBucket> get_field_buckets(const std::string &vin, const std::string &field,
+                                                     std::chrono::system_clock::time_point from,
+                                                     std::chrono::system_clock::time_point to,
+                                                     std::chrono::seconds width) const;
+
+    /**
+     * @brief Writes the open segments of the field history to disk
+     */
+    void flush_field_history();
+
+    // Metrics
+
+    /**
+     * @brief Gets request and operation metrics
+     *
+     * Metrics are process-wide, so with several controllers the snapshot
+     * covers all of them.
+     *
+     * @return Latency histograms per endpoint and operation, response outcomes, retries,
+     *         session resets and vehicle switches
+     */
+    MetricsSnapshot metrics() const;
+
+    /**
+     * @brief Writes the metrics in the Prometheus text format
+     * @param path Destination file, replaced atomically
+     * @return True if written
+     */
+    bool write_metrics(const std::string &path) const;
+
+    // Tracing
+
+    /**
+     * @brief Starts or stops recording tracing spans
+     *
+     * Each public call starts a trace unless it is made inside an open
+     * TraceSpan, whose trace it then joins. Like metrics, tracing is
+     * process-wide.
+     *
+     * @param enabled True to record, off by default
+     */
+    void set_tracing(bool enabled);
+
+    /**
+     * @brief Writes recorded spans as Chrome trace-event JSON, viewable in Perfetto
+     * @param path Destination file
+     * @param trace_id Only spans of this trace, e.g. TraceSpan::trace_id(), or 0 for all
+     * @return True if written
+     */
+    bool write_trace(const std::string &path, uint64_t trace_id = 0) const;
+
     // PIN Management
 
     /**
@@ -416,22 +1044,63 @@ namespace subarulink {
     bool update_saved_pin(const std::string &new_pin);
 
   private:
+    friend class ParserBench;  ///< bench/parser_bench.cpp times the private parsers
+
+    /**
+     * @brief Account-level climate presets shared by every vehicle on the account
+     */
+    struct PresetCache {
+      std::vector <ClimatePreset> gas_presets;   ///< STARLINK presets for gas vehicles
+      std::vector <ClimatePreset> phev_presets;  ///< STARLINK presets for PHEV vehicles
+      std::vector <ClimatePreset> user_presets;  ///< User-defined presets
+      nlohmann::json raw_subaru_presets;         ///< Raw climatePresetSettings response
+      nlohmann::json raw_user_presets;           ///< Raw remoteEngineStartSettings response
+      std::chrono::system_clock::time_point fetched_at;  ///< Timestamp of last preset fetch
+      bool valid{false};                         ///< False until fetched or after invalidation
+      std::optional <size_t> quick_start_hash;   ///< Content hash of the server's quick start settings
+      std::chrono::system_clock::time_point quick_start_at;  ///< When quick_start_hash was saved or fetched
+    };
+
     std::unique_ptr <Connection> _connection;    ///< Connection handler
     std::string _country;                       ///< Country code
-    int _update_interval;                       ///< Update interval in seconds
-    int _fetch_interval;                        ///< Fetch interval in seconds
+    std::atomic<int> _update_interval;          ///< Update interval in seconds
+    std::atomic<int> _fetch_interval;           ///< Fetch interval in seconds
     std::map <std::string, VehicleInfo> _vehicles;  ///< Vehicle information cache
-    std::map <std::string, std::unique_ptr<std::mutex>> _vehicle_mutex;  ///< Per-vehicle mutex
+    std::map <std::string, std::unique_ptr<std::mutex>> _vehicle_mutex;  ///< Per-vehicle state mutex
     std::string _pin;                           ///< STARLINK security PIN
-    std::mutex _controller_mutex;               ///< Controller-wide mutex
     bool _pin_lockout;                          ///< PIN lockout status
     std::map <std::string, nlohmann::json> _raw_api_data;  ///< Raw API response cache
+    std::map <std::string, ChangeLog> _change_logs;      ///< Per-vehicle field change history
     std::string version;                        ///< API version
+    PresetCache _preset_cache;                  ///< Account-level climate preset cache
+    std::mutex _preset_mutex;                   ///< Guards _preset_cache and _preset_load, never held across a request
+    std::shared_future<void> _preset_load;      ///< Preset load in flight, joined by concurrent callers
+    std::chrono::steady_clock::time_point _preset_load_started;  ///< When _preset_load was sent
+    int _preset_interval;                       ///< Preset cache lifetime in seconds
+    std::map <FetchGroup, int> _group_intervals;  ///< Condition, health and location intervals in seconds
+    EventBus _events;                           ///< Change subscriptions
+    SpatialIndex _spatial_index;                ///< Latest valid positions and geofences
+    LocationHistory _location_history;          ///< Recorded positions per vehicle
+    std::atomic<bool> _record_locations{false};  ///< Whether positions are appended to the history
+    std::shared_ptr <TimeSeriesStore> _field_history;  ///< Recorded numeric fields, null when disabled
+    mutable std::mutex _field_history_mutex;    ///< Guards swapping _field_history
+    AdaptivePollPolicy _poll_policy;            ///< Per-vehicle activity for adaptive polling
+    ChargeTracker _charge_tracker;              ///< EV charge sessions and predicted finish times
+    std::atomic<bool> _adaptive_polling{false};  ///< Whether background intervals adapt to activity
+    LatencyProfiles _latency_profiles;          ///< Learned remote command completion times
+    StatusPoller _status_poller;                ///< Shared poller for outstanding remote commands
+    std::map <std::string, std::unique_ptr<CommandQueue>> _command_queues;  ///< Per-vehicle remote command queues
+    std::mutex _refresh_mutex;                  ///< Guards background refreshes
+    std::map <std::string, std::shared_future<bool>> _refreshes;  ///< Latest background refresh per vehicle
+    std::map <std::string, std::unique_ptr<Strand>> _strands;  ///< Per-vehicle serial executors for fetch and update
+    mutable std::mutex _scheduler_mutex;        ///< Guards scheduler creation
+    std::unique_ptr <PollScheduler> _scheduler;  ///< Background poller, destroyed first so polls finish early
 
     // Constants
     static constexpr int MAX_SESSION_AGE_MINS = 30;  ///< Maximum session age in minutes
     static constexpr int MAX_PRESETS = 4;            ///< Maximum number of climate presets
     static constexpr int PIN_LENGTH = 4;             ///< Required PIN length
+    static constexpr int POLL_SLACK_SECS = 5;        ///< Early tolerance for scheduled polls
 
     /**
      * @brief Makes GET request to API
@@ -467,90 +1136,322 @@ namespace subarulink {
     void _parse_vehicle(const nlohmann::json &vehicle);
 
     /**
-     * @brief Executes remote command with retry logic
+     * @brief Queues remote command behind the vehicle's other commands
      * @param vin Vehicle identification number
      * @param cmd Command to execute
      * @param poll_url Status polling endpoint
      * @param data Additional command data
-     * @return Future containing tuple of success status and response
+     * @param prepare Optional step run right before the command is sent, until it succeeds once
+     * @return Command carrying the outcome
+     * @throws SubaruException if VIN is invalid
      */
-    std::future <std::tuple<bool, nlohmann::json>> _remote_command(
+    std::shared_ptr <RemoteCommand> _remote_command(
         const std::string &vin,
         const std::string &cmd,
         const std::string &poll_url,
-        const nlohmann::json &data = nlohmann::json());
+        const nlohmann::json &data = nlohmann::json(),
+        std::function<void()> prepare = nullptr);
 
     /**
-     * @brief Executes vehicle actuation command
+     * @brief Executes remote command with retry logic, run by the vehicle's command queue
+     * @param command Command to send
+     * @return Tuple of success status and response
+     */
+    RemoteCommand::Result _run_remote_command(const std::shared_ptr <RemoteCommand> &command);
+
+    /**
+     * @brief Stops polling a sent command and calls its cancel endpoint, once
+     * @param command Command with a serviceRequestId
+     */
+    void _cancel_sent_command(const std::shared_ptr <RemoteCommand> &command);
+
+    /**
+     * @brief Cancels a queued or sent command
+     * @param command Command to cancel
+     * @return Future containing true if the command ended cancelled
+     */
+    std::future<bool> _cancel_command(const std::shared_ptr <RemoteCommand> &command);
+
+    /**
+     * @brief Wraps a command in a caller handle
+     * @param command Command to wrap
+     * @return Handle whose cancel calls _cancel_command
+     */
+    CommandHandle _handle(std::shared_ptr <RemoteCommand> command);
+
+    /**
+     * @brief Resolves the api_gen placeholder of an endpoint for a vehicle
+     * @param vin Vehicle identification number
+     * @param endpoint Endpoint that may contain api_gen
+     * @return Endpoint for the vehicle's telematics generation
+     */
+    std::string _command_url(const std::string &vin, const std::string &endpoint) const;
+
+    /**
+     * @brief Gets the status endpoint for horn and lights commands
+     * @param vin Vehicle identification number
+     * @return Status polling endpoint
+     */
+    std::string _horn_lights_poll_url(const std::string &vin) const;
+
+    /**
+     * @brief Queues vehicle actuation command
      * @param vin Vehicle identification number
      * @param cmd Command to execute
      * @param data Command parameters
      * @param poll_url Status polling endpoint
-     * @return Future containing tuple of success status and response
+     * @param prepare Optional step run right before the command is sent, until it succeeds once
+     * @return Command carrying the outcome
+     * @throws VehicleNotSupported without an active remote services subscription
      */
-    std::future <std::tuple<bool, nlohmann::json>> _actuate(
+    std::shared_ptr <RemoteCommand> _actuate(
         const std::string &vin,
         const std::string &cmd,
         const nlohmann::json &data = nlohmann::json(),
-        const std::string &poll_url = "/g2v30/remoteService/status.json");
+        const std::string &poll_url = "/g2v30/remoteService/status.json",
+        std::function<void()> prepare = nullptr);
 
     /**
      * @brief Retrieves vehicle status from API
      * @param vin Vehicle identification number
+     * @param session_validated Skip session validation because the caller just validated it; the vehicle
+     *        is reselected only if another vehicle took the selection since
      * @return Future containing JSON status data
      */
-    std::future <nlohmann::json> _get_vehicle_status(const std::string &vin);
+    std::future <nlohmann::json> _get_vehicle_status(const std::string &vin, bool session_validated = false);
 
     /**
      * @brief Updates vehicle status data
+     *
+     * Validates the session once, then issues the status, condition, health and
+     * location requests concurrently and merges each result as it arrives. Each
+     * request holds the vehicle's lane only for its own round trip, so fetches
+     * of other vehicles on the account interleave with it. Climate presets load
+     * independently of the vehicle selection.
+     *
      * @param vin Vehicle identification number
-     * @return Future containing success status
+     * @param groups Mask of groups to fetch
+     * @return Future containing mask of groups that were fetched successfully
      */
-    std::future<bool> _fetch_status(const std::string &vin);
+    std::future <FetchGroup> _fetch_status(const std::string &vin, FetchGroup groups = FetchGroup::ALL);
+
+    /**
+     * @brief Gets groups that apply to a vehicle's capabilities
+     * @param vin Vehicle identification number
+     * @return Mask of applicable groups
+     */
+    FetchGroup _available_groups(const std::string &vin) const;
+
+    /**
+     * @brief Selects requested groups that are older than their interval
+     * @param vin Vehicle identification number
+     * @param groups Mask of requested groups
+     * @param now Reference time
+     * @param force Treat every requested group as stale
+     * @return Mask of groups to fetch
+     */
+    FetchGroup _stale_groups(const std::string &vin, FetchGroup groups,
+                             std::chrono::system_clock::time_point now, bool force) const;
+
+    /**
+     * @brief Checks whether the location is within the update interval, as update judges it
+     * @param vin Vehicle identification number
+     * @return True if an unforced update would send nothing; false for an unknown VIN
+     */
+    bool _location_fresh(const std::string &vin) const;
+
+    /**
+     * @brief Checks whether every requested group is within its interval, as fetch judges it
+     * @param vin Vehicle identification number
+     * @param groups Mask of requested groups
+     * @return True if an unforced fetch would send nothing; false for an unknown VIN
+     */
+    bool _groups_fresh(const std::string &vin, FetchGroup groups) const;
 
     /**
      * @brief Updates vehicle location
      * @param vin Vehicle identification number
      * @param hard_poll Force real-time location update
+     * @param session_validated Skip session validation because the caller just validated it; the vehicle
+     *        is reselected only if another vehicle took the selection since
      * @return Future containing success status
      */
-    std::future<bool> _locate(const std::string &vin, bool hard_poll = false);
+    std::future<bool> _locate(const std::string &vin, bool hard_poll = false, bool session_validated = false);
 
     /**
-     * @brief Parses location data from API response
+     * @brief Parses location data from API response and merges it into the vehicle status
      * @param vin Vehicle identification number
      * @param result JSON location data
+     * @return Events to publish once the vehicle state mutex is released
+     * @note Caller must hold the vehicle state mutex
+     */
+    std::vector <VehicleEvent> _parse_location(const std::string &vin, const nlohmann::json &result);
+
+    /**
+     * @brief Feeds parsed EV condition data to the charge tracker
+     * @param vin Vehicle identification number
+     * @param condition Parsed condition fields
+     * @param time Vehicle-reported time of the condition data
+     * @param events Receives a CHARGE event when a session starts or ends
+     */
+    void _track_charge(const std::string &vin, const nlohmann::json &condition,
+                       std::chrono::system_clock::time_point time, std::vector <VehicleEvent> &events);
+
+    /**
+     * @brief Appends the recorded numeric fields of parsed data to the field history
+     * @param vin Vehicle identification number
+     * @param values Parsed fields
+     * @param time Vehicle-reported time of the values
+     */
+    void _record_field_history(const std::string &vin, const nlohmann::json &values,
+                               std::chrono::system_clock::time_point time);
+
+    /**
+     * @brief Merges parsed values into a vehicle field map, recording only changed fields
+     * @param target Field map to update
+     * @param values Parsed values keyed by field name
+     * @param source_time Time the vehicle reported the values
+     * @param deltas Receives one delta per changed field
+     */
+    static void _merge_fields(std::map <std::string, nlohmann::json> &target,
+                              const nlohmann::json &values,
+                              std::chrono::system_clock::time_point source_time,
+                              std::vector <FieldDelta> &deltas);
+
+    /**
+     * @brief Commits merged deltas to the vehicle change log
+     * @param vin Vehicle identification number
+     * @param deltas Changes detected by one merge
+     * @param kind Additional event type raised alongside FIELD_CHANGED, if any
+     * @return Events to publish once the vehicle state mutex is released
+     * @note Caller must hold the vehicle state mutex
+     */
+    std::vector <VehicleEvent> _commit_changes(const std::string &vin, std::vector <FieldDelta> deltas,
+                                               EventType kind = EventType::NONE);
+
+    /**
+     * @brief Runs one background poll
+     * @param vin Vehicle identification number
+     * @param kind Poll kind
+     */
+    void _scheduled_poll(const std::string &vin, PollKind kind);
+
+    /**
+     * @brief Starts a background refresh unless one is already running
+     * @param vin Vehicle identification number
+     * @return The running refresh
+     */
+    std::shared_future<bool> _revalidate(const std::string &vin);
+
+    /**
+     * @brief Copies a vehicle's cached data with its age
+     * @param vin Vehicle identification number
+     * @return Snapshot without the refreshing flag set
      */
-    void _parse_location(const std::string &vin, const nlohmann::json &result);
+    VehicleSnapshot _read_snapshot(const std::string &vin) const;
 
     /**
-     * @brief Polls for command completion status
+     * @brief Computes the interval until a vehicle's next background poll
+     * @param vin Vehicle identification number
+     * @param kind Poll kind
+     * @return Interval in seconds
+     */
+    int _poll_interval(const std::string &vin, PollKind kind) const;
+
+    /**
+     * @brief Feeds the outcome of a background fetch to the adaptive policy
+     * @param vin Vehicle identification number
+     * @param since Change log version before the fetch
+     */
+    void _observe_activity(const std::string &vin, uint64_t since);
+
+    /**
+     * @brief Publishes events to subscribers
+     * @param events Events returned by a merge
+     */
+    void _publish(const std::vector <VehicleEvent> &events);
+
+    /**
+     * @brief Records a remote command state transition and publishes it
+     * @param command Command that changed state
+     * @param state New command state
+     * @param req_id serviceRequestId, if assigned
+     */
+    void _publish_command_state(RemoteCommand &command, RemoteCommandState state, const std::string &req_id = "");
+
+    /**
+     * @brief Polls for command completion status on the shared status poller
      * @param vin Vehicle identification number
      * @param req_id Request ID to poll
      * @param poll_url Status polling endpoint
-     * @param attempts Maximum number of polling attempts
+     * @param schedule When to poll
      * @return Future containing tuple of success status and response
      */
     std::future <std::tuple<bool, nlohmann::json>> _wait_request_status(
         const std::string &vin,
         const std::string &req_id,
         const std::string &poll_url,
-        int attempts = 20);
+        const PollSchedule &schedule = PollSchedule());
 
     /**
-     * @brief Retrieves climate presets from API
+     * @brief Sends one remote service status request
+     * @param poll_url Status polling endpoint
+     * @param req_id serviceRequestId to query
+     * @return JSON response
+     * @throws InvalidPIN or SubaruException on API errors
+     */
+    nlohmann::json _poll_request_status(const std::string &poll_url, const std::string &req_id);
+
+    /**
+     * @brief Loads a vehicle's climate presets from the account preset cache
      * @param vin Vehicle identification number
+     * @param force Refetch the account presets regardless of cache age
      * @return Future containing success status
      */
-    std::future<bool> _fetch_climate_presets(const std::string &vin);
+    std::future<bool> _fetch_climate_presets(const std::string &vin, bool force = false);
 
     /**
-     * @brief Validates remote start parameters
+     * @brief Downloads the account's climate presets
+     * @return New cache contents, not yet installed
+     * @note Sends requests; must not be called with _preset_mutex held
+     */
+    PresetCache _download_climate_presets();
+
+    /**
+     * @brief Copies the cached presets matching a vehicle's type into its state
      * @param vin Vehicle identification number
-     * @param preset_data Preset configuration to validate
+     * @note Caller must hold _preset_mutex
+     */
+    void _apply_climate_presets(const std::string &vin);
+
+    /**
+     * @brief Saves a preset as the account's quick start settings unless the server already holds it
+     *
+     * Compares against the hash of the server's settings, fetching them first
+     * when no hash was saved or fetched within the preset refresh interval.
+     *
+     * @param preset_data Preset to start the engine with
+     * @throws SubaruException if the save fails
+     */
+    void _sync_quick_start_settings(const nlohmann::json &preset_data);
+
+    /**
+     * @brief Finds a cached climate preset by name
+     * @param vin Vehicle identification number
+     * @param preset_name Name of the preset to find
+     * @return The preset, or std::nullopt if no preset has that name
+     * @throws SubaruException if VIN is invalid
+     */
+    std::optional <ClimatePreset> _find_climate_preset(const std::string &vin, const std::string &preset_name) const;
+
+    /**
+     * @brief Validates remote start parameters and applies start configuration constants
+     * @param vin Vehicle identification number
+     * @param preset Preset configuration to validate
      * @return True if parameters are valid
+     * @throws SubaruException if a parameter holds an invalid value
      */
-    bool _validate_remote_start_params(const std::string &vin, const nlohmann::json &preset_data);
+    bool _validate_remote_start_params(const std::string &vin, ClimatePreset &preset);
 
     /**
      * @brief Checks if vehicle supports remote capabilities
@@ -559,6 +1460,13 @@ namespace subarulink {
      */
     bool _validate_remote_capability(const std::string &vin);
 
+    /**
+     * @brief Checks the feature list and cached status for power windows without fetching
+     * @param vin Vehicle identification number
+     * @return True if the vehicle has power windows as far as the cached data shows
+     */
+    bool _has_power_windows(const std::string &vin) const;
+
     /**
      * @brief Parses vehicle status from API response
      * @param js_resp JSON response data
@@ -594,23 +1502,20 @@ namespace subarulink {
      * @brief Makes query to remote service API
      * @param vin Vehicle identification number
      * @param cmd Command to execute
+     * @param session_validated Skip the first session validation because the caller just validated it; the
+     *        vehicle is reselected only if another vehicle took the selection since
      * @return Future containing JSON response
      */
-    std::future <nlohmann::json> _remote_query(const std::string &vin, const std::string &cmd);
+    std::future <nlohmann::json> _remote_query(const std::string &vin, const std::string &cmd,
+                                               bool session_validated = false);
 
     /**
      * @brief Executes remote command and handles retries
-     * @param vin Vehicle identification number
-     * @param cmd Command to execute
-     * @param data Command parameters
-     * @param poll_url Status polling endpoint
+     * @param command Command to send
      * @return Future containing tuple of retry flag, success status, and response
      */
     std::future <std::tuple<bool, bool, nlohmann::json>> _execute_remote_command(
-        const std::string &vin,
-        const std::string &cmd,
-        const nlohmann::json &data,
-        const std::string &poll_url);
+        const std::shared_ptr <RemoteCommand> &command);
 
     /**
      * @brief Checks if PIN is in lockout state
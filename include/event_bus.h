@@ -0,0 +1,140 @@
+#pragma once
+#ifndef SUBARULINK_EVENT_BUS_HPP
+#define SUBARULINK_EVENT_BUS_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+#include "change_log.h"
+
+namespace subarulink {
+
+/**
+ * @brief Kinds of vehicle events, usable as a subscription mask
+ */
+  enum class EventType : uint8_t {
+    NONE = 0,
+    FIELD_CHANGED = 1 << 0,     ///< One or more status or health fields changed
+    LOCATION_UPDATED = 1 << 1,  ///< A location update changed the reported position
+    HEALTH_TROUBLE = 1 << 2,    ///< A health trouble indicator changed
+    REMOTE_COMMAND = 1 << 3,    ///< A remote command changed state
+    GEOFENCE = 1 << 4,          ///< A location update entered or left a registered geofence
+    CHARGE = 1 << 5,            ///< An EV charge session started or ended
+    ALL = 0x3F
+  };
+
+  inline EventType operator|(EventType a, EventType b) {
+    return static_cast<EventType>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+  }
+
+  inline EventType operator&(EventType a, EventType b) {
+    return static_cast<EventType>(static_cast<uint8_t>(a) & static_cast<uint8_t>(b));
+  }
+
+/**
+ * @brief Lifecycle of a remote command
+ */
+  enum class RemoteCommandState : uint8_t {
+    QUEUED,     ///< Accepted by the library and waiting to be sent; re-entered from SENT on a retry
+    SENT,       ///< Posted to the execute endpoint
+    POLLING,    ///< Server assigned a serviceRequestId; polling for completion
+    SUCCEEDED,  ///< Vehicle reported success
+    FAILED,     ///< Vehicle or server reported failure
+    CANCELLED   ///< Cancelled before completion
+  };
+
+/**
+ * @brief Event delivered to subscribers
+ */
+  struct VehicleEvent {
+    EventType type{EventType::NONE};   ///< Event kind
+    std::string vin;                   ///< Vehicle the event refers to
+    uint64_t version{0};               ///< Change log version for field, location and health events
+    std::vector <FieldDelta> changes;  ///< Changed fields for field, location and health events
+    std::string command;               ///< Command endpoint for remote command events
+    RemoteCommandState command_state{RemoteCommandState::QUEUED};  ///< New state for remote command events
+    std::string service_request_id;    ///< serviceRequestId once assigned
+    std::string fence_id;              ///< Geofence crossed for geofence events
+    bool entered{false};               ///< True on geofence entry, false on exit
+    bool charging{false};              ///< True when a charge session started, false when it ended
+    std::chrono::system_clock::time_point time;  ///< Time the event was raised
+  };
+
+  using EventCallback = std::function<void(const VehicleEvent &)>;
+  using Executor = std::function<void(std::function<void()>)>;
+  using SubscriptionId = uint64_t;
+
+/**
+ * @brief Delivers vehicle events to subscribers on a configurable executor
+ *
+ * By default callbacks run in order on one dispatch thread owned by the bus.
+ * A custom executor receives one job per callback invocation.
+ */
+  class EventBus {
+  public:
+    EventBus();
+    ~EventBus();
+
+    EventBus(const EventBus &) = delete;
+    EventBus &operator=(const EventBus &) = delete;
+
+    /**
+     * @brief Registers a callback
+     * @param types Mask of event types to receive
+     * @param callback Function invoked per matching event
+     * @param vin Only receive events for this vehicle, or all vehicles if empty
+     * @return Id for unsubscribe
+     */
+    SubscriptionId subscribe(EventType types, EventCallback callback, const std::string &vin = "");
+
+    /**
+     * @brief Removes a subscription
+     * @param id Id returned by subscribe
+     * @return True if the subscription existed
+     */
+    bool unsubscribe(SubscriptionId id);
+
+    /**
+     * @brief Sets the executor used to run callbacks
+     * @param executor Executor, or nullptr for the built-in dispatch thread
+     */
+    void set_executor(Executor executor);
+
+    /**
+     * @brief Delivers an event to every matching subscriber
+     * @param event Event to deliver
+     */
+    void publish(const VehicleEvent &event);
+
+  private:
+    struct Subscription {
+      EventType types;
+      EventCallback callback;
+      std::string vin;
+    };
+
+    void _dispatch_loop();
+
+    std::mutex _mutex;                               ///< Guards subscriptions and executor
+    std::map <SubscriptionId, Subscription> _subscriptions;  ///< Active subscriptions
+    SubscriptionId _next_id{1};                      ///< Next subscription id
+    Executor _executor;                              ///< Custom executor, empty for dispatch thread
+
+    std::mutex _queue_mutex;                         ///< Guards the dispatch queue
+    std::condition_variable _queue_cv;               ///< Signals queued jobs or shutdown
+    std::deque <std::function<void()>> _queue;       ///< Jobs for the dispatch thread
+    bool _stopping{false};                           ///< Set on destruction
+    std::thread _dispatcher;                         ///< Built-in dispatch thread
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_EVENT_BUS_HPP
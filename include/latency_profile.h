@@ -0,0 +1,105 @@
+#pragma once
+#ifndef SUBARULINK_LATENCY_PROFILE_HPP
+#define SUBARULINK_LATENCY_PROFILE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <mutex>
+
+#include "nlohmann/json.hpp"
+#include "status_poller.h"
+
+namespace subarulink {
+
+/**
+ * @brief Learned completion times of remote commands
+ *
+ * Keeps the most recent completion times per profile key, typically the
+ * command endpoint and telematics generation. A command that timed out or was
+ * cancelled is kept as a censored sample: it only says the command took longer
+ * than that. Percentiles use the product-limit (Kaplan-Meier) estimate, so slow
+ * commands that never completed still push the tail out instead of dropping
+ * from the profile. Once a key has enough completed samples, @ref schedule
+ * starts polling just before the fast quartile completes, polls densely
+ * through the typical range and backs off after it. Keys without enough
+ * samples use the default fixed cadence.
+ */
+  class LatencyProfiles {
+  public:
+    static constexpr size_t MAX_SAMPLES = 64;   ///< Samples kept per key
+    static constexpr size_t MIN_SAMPLES = 5;    ///< Completed samples needed before the learned schedule is used
+
+    /**
+     * @brief Records a completion time, or a lower bound for one
+     * @param key Profile key
+     * @param elapsed Time from the execute call to the observed completion, or until polling stopped
+     * @param censored True if polling stopped before the command completed, e.g. on timeout or cancel
+     */
+    void record(const std::string &key, std::chrono::milliseconds elapsed, bool censored = false);
+
+    /**
+     * @brief Builds the poll schedule for a command
+     * @param key Profile key
+     * @return Learned schedule, or the default one without enough samples
+     */
+    PollSchedule schedule(const std::string &key) const;
+
+    /**
+     * @brief Gets a completion time percentile
+     * @param key Profile key
+     * @param percentile Percentile between 0 and 100
+     * @return Estimated completion time, at least the slowest sample if the percentile lies past
+     *         every completion; zero if the key has no samples
+     */
+    std::chrono::milliseconds percentile(const std::string &key, double percentile) const;
+
+    /**
+     * @brief Serializes every profile
+     * @return JSON object mapping keys to samples, oldest first: milliseconds for a completion,
+     *         {"censored": milliseconds} for a lower bound
+     */
+    nlohmann::json to_json() const;
+
+    /**
+     * @brief Replaces the profiles with serialized ones
+     * @param profiles JSON produced by to_json
+     */
+    void from_json(const nlohmann::json &profiles);
+
+    /**
+     * @brief Writes the profiles to a file
+     * @param path Destination file
+     * @return True if written
+     */
+    bool save(const std::string &path) const;
+
+    /**
+     * @brief Loads profiles from a file written by save
+     * @param path Source file
+     * @return True if the file was read and parsed
+     */
+    bool load(const std::string &path);
+
+  private:
+    struct Sample {
+      int64_t ms;                     ///< Completion time, or time polled without completing
+      bool censored;                  ///< The command had not completed after ms
+    };
+
+    struct Profile {
+      std::vector <Sample> samples;   ///< Samples, oldest overwritten first
+      size_t next{0};                 ///< Ring position of the next overwrite
+    };
+
+    static std::vector <Sample> _sorted(const Profile &profile);
+    static int64_t _at(const std::vector <Sample> &sorted, double percentile);
+
+    mutable std::mutex _mutex;                  ///< Guards profiles
+    std::map <std::string, Profile> _profiles;  ///< Samples per key
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_LATENCY_PROFILE_HPP
@@ -0,0 +1,140 @@
+#pragma once
+#ifndef SUBARULINK_LOCATION_HISTORY_HPP
+#define SUBARULINK_LOCATION_HISTORY_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <optional>
+#include <mutex>
+#include <cstdint>
+
+namespace subarulink {
+
+/**
+ * @brief One recorded vehicle position
+ */
+  struct LocationSample {
+    std::chrono::system_clock::time_point time;  ///< Vehicle-reported time, stored to the second
+    double latitude{0.0};                        ///< Degrees north, stored to 1e-6 degrees
+    double longitude{0.0};                       ///< Degrees east, stored to 1e-6 degrees
+    std::optional<int> heading;                  ///< Degrees clockwise from north, if reported
+  };
+
+/**
+ * @brief Per-vehicle ring of compactly encoded positions
+ *
+ * Samples are stored as fixed-point deltas from the previous sample, zigzag
+ * varint encoded, in blocks of BLOCK_SAMPLES. Each block keeps its time span
+ * so a range query decodes only the blocks it overlaps. A parked vehicle
+ * costs about 5 bytes per sample and a moving one typically under 10. Once a
+ * vehicle holds more than the sample limit its oldest block is dropped.
+ */
+  class LocationHistory {
+  public:
+    static constexpr size_t BLOCK_SAMPLES = 128;  ///< Samples per encoded block
+
+    /**
+     * @brief Constructs an empty history
+     * @param max_samples Samples kept per vehicle
+     */
+    explicit LocationHistory(size_t max_samples = 100000);
+
+    /**
+     * @brief Records a position
+     * @param vin Vehicle identification number
+     * @param sample Position to record
+     * @return False if the sample is not newer than the vehicle's latest one
+     */
+    bool append(const std::string &vin, const LocationSample &sample);
+
+    /**
+     * @brief Gets the positions recorded in a time range
+     * @param vin Vehicle identification number
+     * @param from Start of the range, inclusive
+     * @param to End of the range, inclusive
+     * @return Samples, oldest first
+     */
+    std::vector <LocationSample> range(const std::string &vin,
+                                       std::chrono::system_clock::time_point from,
+                                       std::chrono::system_clock::time_point to) const;
+
+    /**
+     * @brief Gets the latest recorded position
+     * @param vin Vehicle identification number
+     * @return Sample, or nullopt if none was recorded
+     */
+    std::optional <LocationSample> latest(const std::string &vin) const;
+
+    /**
+     * @brief Gets the number of samples kept for a vehicle
+     * @param vin Vehicle identification number
+     * @return Sample count
+     */
+    size_t size(const std::string &vin) const;
+
+    /**
+     * @brief Gets the memory held by encoded samples of every vehicle
+     * @return Bytes, including block bookkeeping
+     */
+    size_t memory_bytes() const;
+
+    /**
+     * @brief Changes the per-vehicle sample limit, dropping old blocks if needed
+     * @param max_samples Samples kept per vehicle, at least BLOCK_SAMPLES
+     */
+    void set_max_samples(size_t max_samples);
+
+    /**
+     * @brief Gets the per-vehicle sample limit
+     * @return Samples kept per vehicle
+     */
+    size_t get_max_samples() const;
+
+    /**
+     * @brief Forgets every sample of a vehicle
+     * @param vin Vehicle identification number
+     */
+    void clear(const std::string &vin);
+
+  private:
+    friend class LocationHistoryTest;  ///< tests/location_history_test.cpp checks the varint codec
+
+    /**
+     * @brief Fixed-point sample as encoded
+     */
+    struct Point {
+      int64_t time{0};      ///< Seconds since the epoch
+      int64_t latitude{0};  ///< Microdegrees
+      int64_t longitude{0}; ///< Microdegrees
+      int64_t heading{-1};  ///< Degrees, -1 if unknown
+    };
+
+    struct Block {
+      int64_t first_time{0};        ///< Time of the first sample
+      Point last;                   ///< Last sample, the base for the next delta
+      size_t count{0};              ///< Samples in the block
+      std::vector <uint8_t> bytes;  ///< Zigzag varint deltas, the first from a default Point
+    };
+
+    struct Series {
+      std::deque <Block> blocks;  ///< Oldest first
+      size_t samples{0};          ///< Samples across blocks
+    };
+
+    static Point _encode(const LocationSample &sample);
+    static LocationSample _decode(const Point &point);
+    static void _put(std::vector <uint8_t> &bytes, int64_t value);
+    static int64_t _get(const std::vector <uint8_t> &bytes, size_t &offset);
+    void _trim(Series &series) const;
+
+    mutable std::mutex _mutex;                ///< Guards everything below
+    size_t _max_samples;                      ///< Samples kept per vehicle
+    std::map <std::string, Series> _series;   ///< History per vehicle
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_LOCATION_HISTORY_HPP
@@ -0,0 +1,257 @@
+#pragma once
+#ifndef SUBARULINK_LOGGER_HPP
+#define SUBARULINK_LOGGER_HPP
+
+#include <string>
+#include <ostream>
+#include <streambuf>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * Lowest level compiled into the library: 0 trace, 1 debug, 2 info, 3 warn,
+ * 4 error, 5 off. Log statements below it are discarded at compile time,
+ * arguments included.
+ */
+#ifndef SUBARULINK_LOG_LEVEL
+#define SUBARULINK_LOG_LEVEL 1
+#endif
+
+#define SUBARULINK_LOG(level, ...)                                                  \
+  do {                                                                              \
+    if constexpr (static_cast<int>(level) >= SUBARULINK_LOG_LEVEL) {                \
+      auto &subarulink_logger_ = ::subarulink::Logger::instance();                  \
+      if (subarulink_logger_.enabled(level)) {                                      \
+        subarulink_logger_.write(level, __VA_ARGS__);                               \
+      }                                                                             \
+    }                                                                               \
+  } while (false)
+
+#define SUBARULINK_LOG_TRACE(...) SUBARULINK_LOG(::subarulink::LogLevel::TRACE, __VA_ARGS__)
+#define SUBARULINK_LOG_DEBUG(...) SUBARULINK_LOG(::subarulink::LogLevel::DEBUG, __VA_ARGS__)
+#define SUBARULINK_LOG_INFO(...) SUBARULINK_LOG(::subarulink::LogLevel::INFO, __VA_ARGS__)
+#define SUBARULINK_LOG_WARN(...) SUBARULINK_LOG(::subarulink::LogLevel::WARN, __VA_ARGS__)
+#define SUBARULINK_LOG_ERROR(...) SUBARULINK_LOG(::subarulink::LogLevel::ERROR, __VA_ARGS__)
+
+namespace subarulink {
+
+/**
+ * @brief Severity of a log record
+ */
+  enum class LogLevel : uint8_t {
+    TRACE = 0,  ///< Full payloads
+    DEBUG = 1,  ///< Request and parse steps
+    INFO = 2,   ///< Notable state changes
+    WARN = 3,   ///< Recoverable failures
+    ERROR = 4,  ///< Failures surfaced to the caller
+    OFF = 5     ///< Nothing
+  };
+
+/**
+ * @brief Gets the display name of a level
+ * @param level Log level
+ * @return Upper-case name, e.g. "DEBUG"
+ */
+  const char *log_level_name(LogLevel level);
+
+/**
+ * @brief One formatted log line
+ */
+  struct LogRecord {
+    static constexpr size_t MESSAGE_BYTES = 464;  ///< Longer messages are truncated with "..."
+
+    LogLevel level{LogLevel::INFO};               ///< Severity
+    uint32_t thread{0};                           ///< Small per-thread number, in order of first log
+    std::chrono::system_clock::time_point time;   ///< When the record was written
+    uint16_t length{0};                           ///< Bytes used in message
+    char message[MESSAGE_BYTES];                  ///< Not null-terminated
+
+    /**
+     * @brief Gets the message text
+     * @return Message, valid while the record is
+     */
+    std::string_view text() const { return {message, length}; }
+  };
+
+  using LogSink = std::function<void(const LogRecord &)>;
+
+/**
+ * @brief JSON value serialized with sensitive fields masked, only when logged
+ */
+  struct RedactedJson {
+    const nlohmann::json &value;  ///< Value to serialize
+    int indent;                   ///< dump() indent, -1 for one line
+  };
+
+/**
+ * @brief Wraps a JSON value for logging with RAW_API_FIELDS_TO_REDACT and credentials masked
+ * @param value Value to log; must outlive the log statement
+ * @param indent dump() indent, -1 for one line
+ * @return Streamable wrapper
+ */
+  inline RedactedJson redact(const nlohmann::json &value, int indent = -1) {
+    return {value, indent};
+  }
+
+/**
+ * @brief Masks a form or query field value if its name is sensitive
+ * @param key Field name
+ * @param value Field value
+ * @return The value, or a mask for credentials and RAW_API_FIELDS_TO_REDACT
+ */
+  const std::string &redact_field(const std::string &key, const std::string &value);
+
+/**
+ * @brief Copies a JSON value with sensitive fields masked at any depth
+ * @param value Value to copy
+ * @return Redacted copy
+ */
+  nlohmann::json redacted(const nlohmann::json &value);
+
+  std::ostream &operator<<(std::ostream &out, const RedactedJson &json);
+
+/**
+ * @brief Process-wide asynchronous logger
+ *
+ * Records are formatted in place into a fixed-size ring by the logging
+ * thread, only when their level is enabled, and written out by one
+ * background thread; a log call never blocks on I/O or a lock. When the ring
+ * is full new records are dropped and counted rather than waited for.
+ */
+  class Logger {
+  public:
+    static constexpr size_t CAPACITY = 4096;  ///< Records buffered before dropping, a power of two
+
+    /**
+     * @brief Gets the logger, starting its writer thread on first use
+     * @return Logger
+     */
+    static Logger &instance();
+
+    ~Logger();
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    /**
+     * @brief Checks whether a level is written at run time
+     * @param level Log level
+     * @return True if at or above the current level
+     */
+    bool enabled(LogLevel level) const {
+      return static_cast<uint8_t>(level) >= _level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sets the lowest level written; levels below SUBARULINK_LOG_LEVEL stay compiled out
+     * @param level Log level, INFO by default
+     */
+    void set_level(LogLevel level);
+
+    /**
+     * @brief Gets the lowest level written
+     * @return Log level
+     */
+    LogLevel get_level() const;
+
+    /**
+     * @brief Replaces where records go
+     * @param sink Called on the writer thread for each record; nullptr for standard output
+     */
+    void set_sink(LogSink sink);
+
+    /**
+     * @brief Waits until every record logged so far has been written
+     */
+    void flush();
+
+    /**
+     * @brief Gets the number of records dropped because the ring was full
+     * @return Dropped records since start
+     */
+    uint64_t dropped() const;
+
+    /**
+     * @brief Formats and queues a record; use the SUBARULINK_LOG_* macros instead
+     * @param level Log level
+     * @param args Values streamed into the message
+     */
+    template<typename... Args>
+    void write(LogLevel level, const Args &... args) {
+      auto *slot = _claim();
+      if (!slot) {
+        return;
+      }
+      auto &stream = _stream(slot->record);
+      (stream << ... << args);
+      _publish(slot, level, stream);
+    }
+
+  private:
+    struct Slot {
+      std::atomic<size_t> sequence{0};  ///< Ring position the slot is ready for
+      LogRecord record;                 ///< Record being written or read
+    };
+
+    /**
+     * @brief Ostream over a record's message buffer that truncates instead of growing
+     */
+    class RecordStream : public std::ostream {
+    public:
+      RecordStream();
+      void reset(LogRecord &record);
+      size_t length() const;
+      bool truncated() const;
+
+    private:
+      class Buffer : public std::streambuf {
+      public:
+        void reset(char *begin, size_t size);
+        size_t length() const;
+        bool truncated() const;
+
+      protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char *s, std::streamsize count) override;
+
+      private:
+        bool _truncated{false};
+      };
+
+      Buffer _buffer;
+    };
+
+    Logger();
+
+    Slot *_claim();
+    RecordStream &_stream(LogRecord &record);
+    void _publish(Slot *slot, LogLevel level, RecordStream &stream);
+    void _run();
+    static void _write_stdout(const LogRecord &record);
+
+    std::unique_ptr<Slot[]> _slots;                       ///< Ring storage
+    alignas(64) std::atomic<size_t> _head{0};             ///< Next position to claim
+    alignas(64) std::atomic<size_t> _written{0};          ///< Positions handed to the sink
+    std::atomic<uint64_t> _dropped{0};                    ///< Records lost to a full ring
+    std::atomic<uint8_t> _level;                          ///< Lowest level written
+    std::atomic<bool> _idle{false};                       ///< Writer is waiting for records
+    std::atomic<bool> _stopping{false};                   ///< Set by the destructor
+
+    std::mutex _mutex;                                    ///< Guards the sink and the waits below
+    std::condition_variable _wake;                        ///< Signals new records to an idle writer
+    std::condition_variable _progress;                    ///< Signals written records to flush()
+    LogSink _sink;                                        ///< Destination, empty for standard output
+    std::thread _thread;                                  ///< Writer thread
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_LOGGER_HPP
@@ -0,0 +1,240 @@
+#pragma once
+#ifndef SUBARULINK_METRICS_HPP
+#define SUBARULINK_METRICS_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <initializer_list>
+#include <cstdint>
+
+namespace subarulink {
+
+/**
+ * @brief Latency distribution of one endpoint or operation
+ */
+  struct LatencyStats {
+    uint64_t count{0};         ///< Recorded calls
+    double sum_seconds{0.0};   ///< Total time across calls
+    double max_seconds{0.0};   ///< Slowest call
+    std::vector <std::pair<double, uint64_t>> buckets;  ///< Upper bound in seconds and calls, non-empty buckets only
+
+    /**
+     * @brief Estimates a percentile from the buckets
+     * @param quantile Fraction between 0 and 1, e.g. 0.99
+     * @return Upper bound of the bucket holding the percentile, in seconds; within about 6%
+     */
+    double percentile(double quantile) const;
+  };
+
+/**
+ * @brief Responses with one HTTP status and errorCode from an endpoint
+ */
+  struct ResponseKey {
+    std::string endpoint;    ///< Request path, e.g. /validateSession.json
+    int status{0};           ///< HTTP status, 0 if no response arrived
+    std::string error_code;  ///< errorCode of an unsuccessful response, empty otherwise
+
+    bool operator<(const ResponseKey &other) const;
+  };
+
+/**
+ * @brief Point-in-time copy of every metric
+ */
+  struct MetricsSnapshot {
+    std::map <std::string, LatencyStats> requests;      ///< HTTP request latency per endpoint
+    std::map <ResponseKey, uint64_t> responses;         ///< Requests per endpoint and outcome
+    std::map <std::string, LatencyStats> operations;    ///< Controller operation latency per operation
+    std::map <std::string, uint64_t> operation_errors;  ///< Failed or throwing operations per operation
+    std::map <std::string, uint64_t> retries;           ///< Retried attempts per operation
+    uint64_t session_resets{0};                         ///< Sessions dropped and re-established
+    uint64_t vehicle_switches{0};                       ///< Successful selectVehicle calls
+    uint64_t reauthentications{0};                      ///< Logins after validateSession failed
+
+    /**
+     * @brief Formats the snapshot in the Prometheus text exposition format
+     * @return Metric families prefixed subarulink_
+     */
+    std::string prometheus() const;
+  };
+
+/**
+ * @brief Counted events without a latency
+ */
+  enum class MetricEvent : uint8_t {
+    RETRY,             ///< An operation tried again; labelled with the operation
+    SESSION_RESET,     ///< The HTTP session and cookies were dropped
+    VEHICLE_SWITCH,    ///< selectVehicle moved the account to another vehicle
+    REAUTHENTICATION   ///< The session had expired and the account logged in again
+  };
+
+/**
+ * @brief Process-wide request and operation metrics
+ *
+ * Threads are spread round-robin over a fixed set of shards, each holding its
+ * series in an open-addressed table of atomic cells. Recording finds its cell
+ * without a lock or an allocation, so a short-lived thread costs nothing
+ * beyond its shard assignment. The registry lock is only taken the first time
+ * a series is recorded in a shard, and by snapshot() and reset(). Latencies go
+ * into log-linear histograms with 16 sub-buckets per power of two
+ * microseconds, about 6% relative precision.
+ */
+  class Metrics {
+  public:
+    /**
+     * @brief Gets the process-wide metrics
+     * @return Metrics
+     */
+    static Metrics &instance();
+
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    /**
+     * @brief Records one HTTP request
+     * @param endpoint Request path
+     * @param status HTTP status, 0 if no response arrived
+     * @param error_code errorCode of an unsuccessful response, empty otherwise
+     * @param latency Time from issuing the request to parsing its response
+     */
+    void record_request(const std::string &endpoint, int status, const std::string &error_code,
+                        std::chrono::steady_clock::duration latency);
+
+    /**
+     * @brief Records one Controller operation
+     * @param operation Operation name, e.g. fetch
+     * @param success False if it failed or threw
+     * @param latency Time the operation took
+     */
+    void record_operation(const std::string &operation, bool success, std::chrono::steady_clock::duration latency);
+
+    /**
+     * @brief Counts an event
+     * @param event Event kind
+     * @param label Operation for RETRY, ignored otherwise
+     */
+    void count(MetricEvent event, const std::string &label = "");
+
+    /**
+     * @brief Copies every metric
+     * @return Snapshot
+     */
+    MetricsSnapshot snapshot() const;
+
+    /**
+     * @brief Writes a Prometheus text snapshot, replacing the file atomically
+     * @param path Destination, e.g. for the node_exporter textfile collector
+     * @return True if written
+     */
+    bool write_prometheus(const std::string &path) const;
+
+    /**
+     * @brief Zeroes every metric
+     */
+    void reset();
+
+  private:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int MAX_EXPONENT = 40;   ///< Latencies above 2^40 us (12 days) share the last bucket
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+    static constexpr size_t SHARDS = 8;      ///< Sets of counters that threads are spread over
+    static constexpr size_t SLOTS = 1024;    ///< Series per shard, a power of two; further series are dropped
+
+    enum class Family : uint8_t {
+      REQUEST,
+      RESPONSE,
+      OPERATION,
+      OPERATION_ERROR,
+      RETRY,
+      SESSION_RESET,
+      VEHICLE_SWITCH,
+      REAUTHENTICATION
+    };
+
+    /**
+     * @brief One series in one shard, on its own cache line
+     */
+    struct alignas(64) Cell {
+      std::string key;                  ///< Family byte and labels joined by a separator; fixed once published
+      std::atomic<uint64_t> count{0};
+      std::atomic<uint64_t> sum_us{0};
+      std::atomic<uint64_t> max_us{0};
+      std::unique_ptr<std::atomic<uint64_t>[]> buckets;  ///< Only for latency families
+    };
+
+    /**
+     * @brief Plain totals of a series, for exited threads and snapshots
+     */
+    struct Totals {
+      uint64_t count{0};
+      uint64_t sum_us{0};
+      uint64_t max_us{0};
+      std::vector <uint64_t> buckets;
+
+      void add(const Cell &cell);
+    };
+
+    /**
+     * @brief Series table of the threads assigned to one shard
+     */
+    struct Shard {
+      std::atomic<Cell *> slots[SLOTS];  ///< Probed from the key hash; a slot never changes once set
+    };
+
+    Metrics();
+
+    Cell &_cell(Family family, std::initializer_list<std::string_view> labels, bool histogram);
+    Cell &_register(Shard &shard, size_t hash, Family family, std::initializer_list<std::string_view> labels,
+                    bool histogram);
+    static void _add(Cell &cell, uint64_t amount);
+    static void _observe(Cell &cell, std::chrono::steady_clock::duration latency);
+    static size_t _bucket(uint64_t micros);
+    static double _bucket_upper_seconds(size_t index);
+    static LatencyStats _latency(const Totals &totals);
+
+    Shard _shards[SHARDS];                        ///< Series tables, read without a lock
+    std::atomic<size_t> _next_shard{0};           ///< Shard for the next thread to record
+    mutable std::mutex _mutex;                    ///< Guards the registry below and slot insertions
+    std::vector <std::unique_ptr<Cell>> _cells;   ///< Every published cell, in registration order
+    std::unique_ptr<Cell> _overflow;              ///< Absorbs series that find their shard full; never reported
+  };
+
+/**
+ * @brief Records a Controller operation's latency and outcome when it goes out of scope
+ */
+  class OperationTimer {
+  public:
+    /**
+     * @brief Starts timing
+     * @param operation Operation name
+     */
+    explicit OperationTimer(std::string operation);
+
+    /**
+     * @brief Records the operation, as failed unless set_success(true) was called
+     */
+    ~OperationTimer();
+
+    OperationTimer(const OperationTimer &) = delete;
+    OperationTimer &operator=(const OperationTimer &) = delete;
+
+    /**
+     * @brief Sets the outcome recorded on destruction
+     * @param success Whether the operation succeeded
+     */
+    void set_success(bool success = true);
+
+  private:
+    std::string _operation;
+    std::chrono::steady_clock::time_point _started;
+    bool _success{false};
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_METRICS_HPP
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef SUBARULINK_POLL_POLICY_HPP
+#define SUBARULINK_POLL_POLICY_HPP
+
+#include <string>
+#include <map>
+#include <chrono>
+#include <mutex>
+
+namespace subarulink {
+
+/**
+ * @brief What one fetch revealed about a vehicle's activity
+ */
+  struct PollObservation {
+    bool ignition_on{false};     ///< Vehicle reported IGNITION_ON
+    bool source_moved{false};    ///< The vehicle's own update timestamp advanced
+    bool data_changed{false};    ///< Any other field changed
+  };
+
+/**
+ * @brief Adapts each vehicle's poll interval to how active it is
+ *
+ * A vehicle with its ignition on is polled at the active interval. A vehicle
+ * whose data or update timestamp moved is polled at the base interval. Every
+ * fetch that returns nothing new doubles the interval, up to the backoff
+ * limit, so parked vehicles consume a fraction of the request budget.
+ */
+  class AdaptivePollPolicy {
+  public:
+    static constexpr int DEFAULT_ACTIVE_INTERVAL = 60;      ///< Seconds between polls while the ignition is on
+    static constexpr int DEFAULT_MAX_BACKOFF_FACTOR = 16;   ///< Largest multiple of the base interval
+
+    /**
+     * @brief Constructs a policy
+     * @param active_interval Seconds between polls while the ignition is on
+     * @param max_backoff_factor Largest multiple of the base interval for idle vehicles
+     */
+    explicit AdaptivePollPolicy(int active_interval = DEFAULT_ACTIVE_INTERVAL,
+                                int max_backoff_factor = DEFAULT_MAX_BACKOFF_FACTOR);
+
+    /**
+     * @brief Records the outcome of a fetch
+     * @param vin Vehicle identification number
+     * @param observation What the fetch revealed
+     */
+    void record(const std::string &vin, const PollObservation &observation);
+
+    /**
+     * @brief Computes the interval until the vehicle's next poll
+     * @param vin Vehicle identification number
+     * @param base_interval Configured interval in seconds
+     * @return Interval in seconds
+     */
+    int interval(const std::string &vin, int base_interval) const;
+
+    /**
+     * @brief Forgets a vehicle's history so it is polled at the base interval again
+     * @param vin Vehicle identification number
+     */
+    void reset(const std::string &vin);
+
+    /**
+     * @brief Gets the active interval
+     * @return Seconds between polls while the ignition is on
+     */
+    int get_active_interval() const;
+
+    /**
+     * @brief Sets the active interval
+     * @param value Seconds between polls while the ignition is on, minimum 60
+     * @return True if value was accepted
+     */
+    bool set_active_interval(int value);
+
+    /**
+     * @brief Sets the backoff limit
+     * @param value Largest multiple of the base interval, at least 1
+     * @return True if value was accepted
+     */
+    bool set_max_backoff_factor(int value);
+
+  private:
+    struct Activity {
+      bool ignition_on{false};  ///< Ignition state at the last fetch
+      int idle_polls{0};        ///< Consecutive fetches with nothing new
+    };
+
+    mutable std::mutex _mutex;              ///< Guards all state below
+    int _active_interval;                   ///< Seconds between polls while the ignition is on
+    int _max_backoff_factor;                ///< Largest multiple of the base interval
+    std::map <std::string, Activity> _activity;  ///< Per-vehicle activity
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_POLL_POLICY_HPP
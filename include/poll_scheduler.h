@@ -0,0 +1,172 @@
+#pragma once
+#ifndef SUBARULINK_POLL_SCHEDULER_HPP
+#define SUBARULINK_POLL_SCHEDULER_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <random>
+#include <cstdint>
+
+namespace subarulink {
+
+/**
+ * @brief Kinds of scheduled polls
+ */
+  enum class PollKind : uint8_t {
+    FETCH = 0,   ///< Status, condition, health and location queries
+    UPDATE = 1   ///< Locate command that wakes the vehicle
+  };
+
+/**
+ * @brief Background scheduler that polls many vehicles from one thread
+ *
+ * Due times are kept in a min-heap, so the thread sleeps until the earliest
+ * poll instead of scanning every vehicle. First polls are spread uniformly
+ * over one interval so a fleet never fires at once, and later polls keep that
+ * phase. Intervals are looked up each time a poll is rescheduled, so changes
+ * take effect on the next cycle. Polls run asynchronously, at most
+ * @ref get_max_in_flight at a time, and a vehicle is never polled twice
+ * concurrently for the same kind.
+ */
+  class PollScheduler {
+  public:
+    using Job = std::function<void(const std::string &vin, PollKind kind)>;
+    using IntervalFunction = std::function<int(const std::string &vin, PollKind kind)>;
+
+    static constexpr size_t DEFAULT_MAX_IN_FLIGHT = 8;  ///< Default concurrent poll limit
+
+    /**
+     * @brief Constructs a stopped scheduler
+     * @param job Work run for each due poll
+     * @param interval Returns the current interval in seconds for a vehicle and poll kind
+     * @param max_in_flight Maximum polls running at once
+     * @note The interval function runs on the scheduler's lock and must not call back into it
+     */
+    PollScheduler(Job job, IntervalFunction interval, size_t max_in_flight = DEFAULT_MAX_IN_FLIGHT);
+    ~PollScheduler();
+
+    PollScheduler(const PollScheduler &) = delete;
+    PollScheduler &operator=(const PollScheduler &) = delete;
+
+    /**
+     * @brief Schedules a vehicle with a random phase within one interval
+     * @param vin Vehicle identification number
+     * @param kind Poll kind
+     */
+    void add(const std::string &vin, PollKind kind);
+
+    /**
+     * @brief Stops scheduling every poll kind of a vehicle
+     * @param vin Vehicle identification number
+     */
+    void remove(const std::string &vin);
+
+    /**
+     * @brief Suspends polls for a vehicle until resumed
+     * @param vin Vehicle identification number
+     * @return True if the vehicle is scheduled
+     */
+    bool pause(const std::string &vin);
+
+    /**
+     * @brief Resumes polls for a paused vehicle, spread over the next interval
+     * @param vin Vehicle identification number
+     * @return True if the vehicle is scheduled
+     */
+    bool resume(const std::string &vin);
+
+    /**
+     * @brief Checks if polls for a vehicle are paused
+     * @param vin Vehicle identification number
+     * @return True if paused
+     */
+    bool is_paused(const std::string &vin) const;
+
+    /**
+     * @brief Moves a vehicle's next poll to now
+     * @param vin Vehicle identification number
+     * @param kind Poll kind
+     */
+    void poll_now(const std::string &vin, PollKind kind);
+
+    /**
+     * @brief Starts the scheduler thread
+     */
+    void start();
+
+    /**
+     * @brief Stops the scheduler thread and waits for running polls
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the scheduler thread is running
+     * @return True if running
+     */
+    bool is_running() const;
+
+    /**
+     * @brief Gets the concurrent poll limit
+     * @return Maximum polls running at once
+     */
+    size_t get_max_in_flight() const;
+
+    /**
+     * @brief Sets the concurrent poll limit
+     * @param value New limit, at least 1
+     * @return True if value was accepted
+     */
+    bool set_max_in_flight(size_t value);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t KIND_COUNT = 2;
+
+    struct Entry {
+      Clock::time_point due;  ///< When the poll is due
+      std::string vin;        ///< Vehicle to poll
+      PollKind kind;          ///< Poll kind
+      uint64_t generation;    ///< Slot generation at insertion; stale entries are dropped
+
+      bool operator>(const Entry &other) const { return due > other.due; }
+    };
+
+    struct Slot {
+      bool registered[KIND_COUNT]{false, false};  ///< Kinds scheduled for this vehicle
+      bool in_flight[KIND_COUNT]{false, false};   ///< Kinds currently running
+      uint64_t generation[KIND_COUNT]{0, 0};      ///< Bumped when the pending entry is replaced
+      bool paused{false};                         ///< Paused by the caller
+    };
+
+    void _run();
+    void _push(const std::string &vin, PollKind kind, Clock::time_point due);
+    Clock::duration _jitter(const std::string &vin, PollKind kind);
+    Clock::duration _interval(const std::string &vin, PollKind kind) const;
+    void _reap();
+
+    Job _job;                                   ///< Work run per poll
+    IntervalFunction _interval_function;        ///< Interval lookup
+    size_t _max_in_flight;                      ///< Concurrent poll limit
+
+    mutable std::mutex _mutex;                  ///< Guards all state below
+    std::condition_variable _cv;                ///< Signals schedule changes, completions and stop
+    std::priority_queue <Entry, std::vector<Entry>, std::greater<Entry>> _queue;  ///< Pending polls by due time
+    std::map <std::string, Slot> _slots;        ///< Per-vehicle scheduling state
+    std::vector <std::future<void>> _running;   ///< Polls in progress
+    size_t _in_flight{0};                       ///< Polls not yet finished
+    std::mt19937 _random;                       ///< Phase jitter source
+    bool _stopping{false};                      ///< Set by stop
+    std::thread _thread;                        ///< Scheduler thread
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_POLL_SCHEDULER_HPP
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef SUBARULINK_RATE_LIMITER_HPP
+#define SUBARULINK_RATE_LIMITER_HPP
+
+#include <chrono>
+#include <mutex>
+
+namespace subarulink {
+
+/**
+ * @brief Token bucket limiting the rate of API requests
+ *
+ * Tokens refill continuously at the configured rate up to the burst size and
+ * each request takes one. A rate of zero disables the limit.
+ */
+  class RateLimiter {
+  public:
+    /**
+     * @brief Constructs a limiter
+     * @param rate Requests per second, or 0 for unlimited
+     * @param burst Maximum requests allowed back to back
+     */
+    explicit RateLimiter(double rate = 0.0, double burst = 1.0);
+
+    /**
+     * @brief Changes the limit, keeping at most the new burst in the bucket
+     * @param rate Requests per second, or 0 for unlimited
+     * @param burst Maximum requests allowed back to back, at least 1
+     */
+    void set_rate(double rate, double burst = 1.0);
+
+    /**
+     * @brief Gets the configured rate
+     * @return Requests per second, 0 if unlimited
+     */
+    double get_rate() const;
+
+    /**
+     * @brief Waits until a request may be sent
+     */
+    void acquire();
+
+    /**
+     * @brief Takes a token if one is available without waiting
+     * @return True if a request may be sent now
+     */
+    bool try_acquire();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Adds tokens earned since the last refill
+     * @note Caller must hold the mutex
+     */
+    void _refill(Clock::time_point now);
+
+    mutable std::mutex _mutex;    ///< Guards the bucket
+    double _rate;                 ///< Tokens per second
+    double _burst;                ///< Bucket capacity
+    double _tokens;               ///< Tokens currently available
+    Clock::time_point _last;      ///< Last refill time
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_RATE_LIMITER_HPP
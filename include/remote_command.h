@@ -0,0 +1,234 @@
+#pragma once
+#ifndef SUBARULINK_REMOTE_COMMAND_HPP
+#define SUBARULINK_REMOTE_COMMAND_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <tuple>
+
+#include "nlohmann/json.hpp"
+#include "event_bus.h"
+#include "trace.h"
+
+namespace subarulink {
+
+/**
+ * @brief Checks whether a command state is final
+ * @param state Command state
+ * @return True for SUCCEEDED, FAILED and CANCELLED
+ */
+  bool is_final(RemoteCommandState state);
+
+/**
+ * @brief Shared state of one remote command
+ *
+ * Created when the command is queued and updated as it is sent, polled and
+ * finished. When the server asks for a retry because the vehicle is busy with
+ * another command, the state goes from SENT back to QUEUED and the command is
+ * sent again, so QUEUED and SENT may repeat. Once final, further transitions
+ * are ignored.
+ */
+  class RemoteCommand {
+  public:
+    using Result = std::tuple<bool, nlohmann::json>;
+
+    static inline const std::string SUPERSEDED = "CommandSuperseded";  ///< errorCode of a replaced command
+    static inline const std::string CANCELLED = "CommandCancelled";    ///< errorCode of a cancelled command
+
+    /**
+     * @brief One recorded state change
+     */
+    struct Transition {
+      RemoteCommandState state;                     ///< State entered
+      std::chrono::system_clock::time_point time;   ///< When it was entered
+    };
+
+    /**
+     * @brief Constructs a queued command
+     * @param vin Vehicle identification number
+     * @param command Command endpoint
+     * @param poll_url Status polling endpoint
+     * @param data Request body
+     * @param prepare Optional step run right before the command is sent, until it succeeds once
+     */
+    RemoteCommand(std::string vin, std::string command, std::string poll_url, nlohmann::json data,
+                  std::function<void()> prepare = nullptr);
+
+    const std::string &vin() const { return _vin; }
+    const std::string &command() const { return _command; }
+    const std::string &poll_url() const { return _poll_url; }
+    const nlohmann::json &data() const { return _data; }
+    const TraceContext &trace_context() const { return _trace_context; }
+    std::chrono::steady_clock::time_point queued_at() const { return _queued_at; }
+
+    /**
+     * @brief Gets the current state
+     * @return Latest state
+     */
+    RemoteCommandState state() const;
+
+    /**
+     * @brief Gets every state entered so far
+     * @return Transitions, oldest first; a retried command lists QUEUED and SENT once per attempt
+     */
+    std::vector <Transition> history() const;
+
+    /**
+     * @brief Gets the serviceRequestId assigned by the execute call
+     * @return Request id, empty until the command is accepted
+     */
+    std::string service_request_id() const;
+
+    /**
+     * @brief Gets the outcome
+     * @return Future containing success status and the final response
+     */
+    std::shared_future <Result> result() const { return _result; }
+
+    /**
+     * @brief Checks whether cancel was requested
+     * @return True after request_cancel succeeded
+     */
+    bool cancel_requested() const;
+
+    /**
+     * @brief Records a state change
+     * @param state New state
+     * @param req_id serviceRequestId to record, if known
+     * @return False if the command was already final
+     */
+    bool transition(RemoteCommandState state, const std::string &req_id = "");
+
+    /**
+     * @brief Marks the command for cancellation
+     *
+     * The first request runs the callback set by on_cancel, if any.
+     *
+     * @return False if the command was already final
+     */
+    bool request_cancel();
+
+    /**
+     * @brief Sets a callback that interrupts a wait when cancel is requested
+     *
+     * The callback runs under the command's lock, right away if cancel was
+     * already requested, so once on_cancel(nullptr) returns it is no longer
+     * running. It must not call back into the command.
+     *
+     * @param callback Callback, or nullptr to clear it
+     */
+    void on_cancel(std::function<void()> callback);
+
+    /**
+     * @brief Claims the server-side cancel
+     * @return True for the first caller only
+     */
+    bool begin_server_cancel();
+
+    /**
+     * @brief Runs the prepare step unless it already succeeded
+     *
+     * A step that throws runs again on the next send.
+     */
+    void prepare();
+
+    /**
+     * @brief Sets the outcome unless already set
+     * @param result Success status and the final response
+     */
+    void complete(Result result);
+
+    /**
+     * @brief Sets a failure outcome unless already set
+     * @param error Exception to rethrow from result
+     */
+    void fail(std::exception_ptr error);
+
+  private:
+    const std::string _vin;                 ///< Vehicle identification number
+    const std::string _command;             ///< Command endpoint
+    const std::string _poll_url;            ///< Status polling endpoint
+    const nlohmann::json _data;             ///< Request body
+    std::function<void()> _prepare;         ///< Step run before the first successful send
+    const TraceContext _trace_context;      ///< Span of the call that queued the command
+    const std::chrono::steady_clock::time_point _queued_at;  ///< When the command was queued
+    mutable std::mutex _mutex;              ///< Guards everything below
+    std::vector <Transition> _history;      ///< States entered, oldest first
+    std::string _req_id;                    ///< serviceRequestId
+    bool _cancel_requested{false};          ///< Set by request_cancel
+    bool _server_cancel{false};             ///< Set once the cancel endpoint is claimed
+    bool _prepared{false};                  ///< Set once prepare succeeded
+    std::function<void()> _on_cancel;       ///< Interrupts a wait on cancel
+    bool _completed{false};                 ///< Set once the outcome is set
+    std::promise <Result> _promise;         ///< Completed with the outcome
+    std::shared_future <Result> _result;    ///< Outcome shared with handles
+  };
+
+/**
+ * @brief Caller's view of a remote command
+ *
+ * Returned by the *_command methods of Controller. Copies share the same
+ * command; dropping every handle does not cancel it.
+ */
+  class CommandHandle {
+  public:
+    using Canceller = std::function<std::future<bool>(const std::shared_ptr <RemoteCommand> &)>;
+
+    CommandHandle() = default;
+
+    /**
+     * @brief Wraps a command
+     * @param command Shared command state
+     * @param canceller Cancels the command
+     */
+    CommandHandle(std::shared_ptr <RemoteCommand> command, Canceller canceller);
+
+    /**
+     * @brief Checks whether the handle refers to a command
+     * @return False for a default-constructed handle
+     */
+    bool valid() const { return static_cast<bool>(_command); }
+
+    const std::string &vin() const { return _command->vin(); }
+    const std::string &command() const { return _command->command(); }
+    RemoteCommandState state() const { return _command->state(); }
+    std::vector <RemoteCommand::Transition> history() const { return _command->history(); }
+    std::string service_request_id() const { return _command->service_request_id(); }
+    bool done() const { return is_final(_command->state()); }
+
+    /**
+     * @brief Gets the outcome with the final response
+     * @return Future containing success status and the final response
+     */
+    std::shared_future <RemoteCommand::Result> response() const { return _command->result(); }
+
+    /**
+     * @brief Waits for the outcome
+     * @return True if the command succeeded
+     * @throws SubaruException or a subclass if the command could not be sent
+     */
+    bool wait() const;
+
+    /**
+     * @brief Cancels the command
+     *
+     * A queued command is dropped without being sent. A sent command stops
+     * polling right away and the matching cancel endpoint is called.
+     *
+     * @return Future containing true if the command ended cancelled
+     */
+    std::future<bool> cancel() const;
+
+  private:
+    std::shared_ptr <RemoteCommand> _command;  ///< Shared command state
+    Canceller _canceller;                     ///< Cancels the command
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_REMOTE_COMMAND_HPP
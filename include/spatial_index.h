@@ -0,0 +1,209 @@
+#pragma once
+#ifndef SUBARULINK_SPATIAL_INDEX_HPP
+#define SUBARULINK_SPATIAL_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <cstdint>
+
+namespace subarulink {
+
+/**
+ * @brief WGS84 position in degrees
+ */
+  struct GeoPoint {
+    double latitude{0.0};   ///< Degrees north
+    double longitude{0.0};  ///< Degrees east
+  };
+
+/**
+ * @brief Great-circle distance between two points
+ * @param a First point
+ * @param b Second point
+ * @return Distance in meters
+ */
+  double distance_meters(const GeoPoint &a, const GeoPoint &b);
+
+/**
+ * @brief Area evaluated locally against vehicle positions
+ *
+ * Boxes and polygons do not wrap across the antimeridian.
+ */
+  struct Geofence {
+    enum class Shape : uint8_t {
+      CIRCLE,   ///< center and radius_m
+      BOX,      ///< south_west and north_east corners
+      POLYGON   ///< vertices, implicitly closed
+    };
+
+    std::string id;                    ///< Caller-chosen identifier
+    Shape shape{Shape::CIRCLE};        ///< Shape kind
+    GeoPoint center;                   ///< Circle center
+    double radius_m{0.0};              ///< Circle radius in meters
+    GeoPoint south_west;               ///< Box corner, also the bounds of every shape
+    GeoPoint north_east;               ///< Box corner, also the bounds of every shape
+    std::vector <GeoPoint> vertices;   ///< Polygon vertices
+
+    /**
+     * @brief Builds a circular fence
+     * @param id Fence identifier
+     * @param center Center point
+     * @param radius_m Radius in meters
+     * @return Fence
+     */
+    static Geofence circle(const std::string &id, const GeoPoint &center, double radius_m);
+
+    /**
+     * @brief Builds a rectangular fence
+     * @param id Fence identifier
+     * @param south_west Lower-left corner
+     * @param north_east Upper-right corner
+     * @return Fence
+     */
+    static Geofence box(const std::string &id, const GeoPoint &south_west, const GeoPoint &north_east);
+
+    /**
+     * @brief Builds a polygonal fence
+     * @param id Fence identifier
+     * @param vertices At least three vertices
+     * @return Fence
+     * @throws std::invalid_argument with fewer than three vertices
+     */
+    static Geofence polygon(const std::string &id, const std::vector <GeoPoint> &vertices);
+
+    /**
+     * @brief Checks whether a point lies inside the fence
+     * @param point Position to test
+     * @return True if inside or on the boundary
+     */
+    bool contains(const GeoPoint &point) const;
+  };
+
+/**
+ * @brief Latest vehicle positions bucketed into geohash cells, with geofences
+ *
+ * Each position lives in the cell of its geohash at the configured precision,
+ * so area queries only test vehicles in the cells the area overlaps. Updates
+ * move a vehicle between cells and report the fences it entered or left.
+ */
+  class SpatialIndex {
+  public:
+    /**
+     * @brief Fence boundary crossed by a location update
+     */
+    struct Crossing {
+      std::string fence_id;  ///< Fence crossed
+      bool entered;          ///< True on entry, false on exit
+    };
+
+    /**
+     * @brief Constructs an empty index
+     * @param precision Geohash length of a cell, 1 to 12; 5 is about 4.9 km
+     */
+    explicit SpatialIndex(int precision = 5);
+
+    /**
+     * @brief Moves a vehicle to a new position
+     * @param vin Vehicle identification number
+     * @param position Latest valid position
+     * @return Fences entered or left, empty on the first position of a vehicle
+     */
+    std::vector <Crossing> update(const std::string &vin, const GeoPoint &position);
+
+    /**
+     * @brief Forgets a vehicle
+     * @param vin Vehicle identification number
+     * @return True if the vehicle was indexed
+     */
+    bool remove(const std::string &vin);
+
+    /**
+     * @brief Gets a vehicle's indexed position
+     * @param vin Vehicle identification number
+     * @return Position, or nullopt if never indexed
+     */
+    std::optional <GeoPoint> position(const std::string &vin) const;
+
+    /**
+     * @brief Finds vehicles within a distance of a point
+     * @param center Center point
+     * @param radius_m Radius in meters
+     * @return VINs, nearest first
+     */
+    std::vector <std::string> within_radius(const GeoPoint &center, double radius_m) const;
+
+    /**
+     * @brief Finds vehicles inside a rectangle
+     * @param south_west Lower-left corner
+     * @param north_east Upper-right corner
+     * @return VINs in sorted order
+     */
+    std::vector <std::string> within_box(const GeoPoint &south_west, const GeoPoint &north_east) const;
+
+    /**
+     * @brief Finds vehicles inside a polygon
+     * @param vertices At least three vertices
+     * @return VINs in sorted order
+     */
+    std::vector <std::string> within_polygon(const std::vector <GeoPoint> &vertices) const;
+
+    /**
+     * @brief Registers or replaces a fence
+     *
+     * Vehicles already inside become members without a crossing.
+     *
+     * @param fence Fence to register
+     */
+    void add_fence(const Geofence &fence);
+
+    /**
+     * @brief Removes a fence
+     * @param id Fence identifier
+     * @return True if the fence existed
+     */
+    bool remove_fence(const std::string &id);
+
+    /**
+     * @brief Gets every registered fence
+     * @return Fences ordered by id
+     */
+    std::vector <Geofence> fences() const;
+
+    /**
+     * @brief Finds vehicles inside a registered fence
+     * @param id Fence identifier
+     * @return VINs in sorted order, empty for an unknown fence
+     */
+    std::vector <std::string> members(const std::string &id) const;
+
+    /**
+     * @brief Gets the fences a vehicle is inside
+     * @param vin Vehicle identification number
+     * @return Fence ids in sorted order
+     */
+    std::vector <std::string> fences_containing(const std::string &vin) const;
+
+  private:
+    using CellKey = uint64_t;
+
+    CellKey _cell(const GeoPoint &point) const;
+    std::vector <std::string> _candidates(const GeoPoint &south_west, const GeoPoint &north_east) const;
+    std::set <std::string> _fences_at(const GeoPoint &point) const;
+
+    int _lat_bits;                                            ///< Latitude bits of a cell key
+    int _lon_bits;                                            ///< Longitude bits of a cell key
+    mutable std::mutex _mutex;                                ///< Guards everything below
+    std::unordered_map <std::string, GeoPoint> _positions;    ///< Latest position per vehicle
+    std::unordered_map <CellKey, std::set<std::string>> _cells;  ///< Vehicles per occupied cell
+    std::map <std::string, Geofence> _fences;                 ///< Registered fences
+    std::map <std::string, std::set<std::string>> _inside;    ///< Fences each vehicle is inside
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_SPATIAL_INDEX_HPP
@@ -0,0 +1,156 @@
+#pragma once
+#ifndef SUBARULINK_STATUS_POLLER_HPP
+#define SUBARULINK_STATUS_POLLER_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+#include <tuple>
+
+#include "nlohmann/json.hpp"
+
+namespace subarulink {
+
+/**
+ * @brief When to poll one remote command
+ *
+ * The default is the fixed cadence STARLINK commands were always polled at:
+ * right away, then once a second for 20 attempts.
+ */
+  struct PollSchedule {
+    std::chrono::milliseconds first_delay{0};        ///< Delay before the first poll
+    std::chrono::milliseconds interval{1000};        ///< Delay after the first poll
+    double backoff{1.0};                             ///< Interval multiplier after each further poll
+    std::chrono::milliseconds max_interval{1000};    ///< Upper bound for the grown interval
+    int attempts{20};                                ///< Polls before giving up
+  };
+
+/**
+ * @brief Polls the status of every outstanding remote command from one timer loop
+ *
+ * Commands register their serviceRequestId and receive a future. A single
+ * thread sleeps until the next poll is due, batches every poll due at that
+ * moment by vehicle and hands the batches to a fixed pool of workers, so a
+ * fleet-wide command costs the same threads as one. A vehicle's polls never
+ * overlap, even when its batches fall due back to back. Each poll hands its
+ * response back through a completion queue, so the loop applies responses as
+ * they arrive and a slow poll only holds up its own vehicle's batch. Each
+ * future completes once the service reports SUCCESS or FAILED or its
+ * attempts run out.
+ */
+  class StatusPoller {
+  public:
+    using Result = std::tuple<bool, nlohmann::json>;
+    using PollFunction = std::function<nlohmann::json(const std::string &poll_url, const std::string &req_id)>;
+
+    static constexpr size_t DEFAULT_WORKERS = 4;  ///< Polls in flight at once by default
+
+    /**
+     * @brief Constructs an idle poller
+     * @param poll Sends one status request and returns the parsed response
+     * @param workers Threads sending polls, started with the first request
+     */
+    explicit StatusPoller(PollFunction poll, size_t workers = DEFAULT_WORKERS);
+    ~StatusPoller();
+
+    StatusPoller(const StatusPoller &) = delete;
+    StatusPoller &operator=(const StatusPoller &) = delete;
+
+    /**
+     * @brief Starts polling a service request
+     * @param vin Vehicle the command was sent to
+     * @param req_id serviceRequestId returned by the execute call
+     * @param poll_url Status polling endpoint
+     * @param schedule When to poll
+     * @return Future containing success status and the final response
+     */
+    std::future <Result> watch(const std::string &vin,
+                               const std::string &req_id,
+                               const std::string &poll_url,
+                               const PollSchedule &schedule = PollSchedule());
+
+    /**
+     * @brief Stops polling a service request
+     *
+     * Its future completes with a CommandCancelled response right away, even
+     * while a poll for it is in flight; that poll's response is discarded.
+     *
+     * @param req_id serviceRequestId passed to watch
+     * @return True if the request was being polled
+     */
+    bool cancel(const std::string &req_id);
+
+    /**
+     * @brief Gets the number of commands being polled
+     * @return Outstanding commands
+     */
+    size_t pending() const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+      std::string vin;                     ///< Vehicle the command was sent to
+      std::string req_id;                  ///< serviceRequestId
+      std::string poll_url;                ///< Status polling endpoint
+      int attempts_left;                   ///< Polls remaining
+      PollSchedule schedule;               ///< Poll timing
+      std::chrono::milliseconds interval;  ///< Delay before the next poll
+      Clock::time_point due;               ///< Next poll time
+      std::promise <Result> promise;       ///< Completed on a final state
+      nlohmann::json response;             ///< Response of the last poll
+      std::exception_ptr error;            ///< Error of the last poll
+      bool cancelled{false};               ///< Cancelled while its poll was in flight
+    };
+
+    void _run();
+
+    /**
+     * @brief Sends the polls of queued batches until the poller stops
+     *
+     * Each poll stores its outcome in the request and queues it on _completed.
+     */
+    void _work();
+
+    /**
+     * @brief Finds the oldest batch whose vehicle has no batch in flight
+     *
+     * Must be called with _mutex held.
+     */
+    std::deque<std::vector<Request *>>::iterator _next_batch();
+
+    /**
+     * @brief Applies the outcome of a finished poll to its request
+     * @return True if the request is finished
+     */
+    static bool _handle(Request &request);
+
+    static void _cancel(Request &request);
+
+    PollFunction _poll;                             ///< Sends one status request
+    size_t _worker_count;                           ///< Size of the worker pool
+    mutable std::mutex _mutex;                      ///< Guards requests and thread state
+    std::condition_variable _cv;                    ///< Signals new requests, finished polls and stop
+    std::condition_variable _work_cv;               ///< Signals queued batches and stop
+    std::vector <std::unique_ptr<Request>> _requests;  ///< Commands waiting for their next poll
+    std::vector <std::unique_ptr<Request>> _in_flight; ///< Commands with a poll queued or in flight
+    std::deque <std::vector<Request *>> _batches;   ///< Due polls grouped by vehicle, oldest first
+    std::set <std::string> _polling;                ///< Vehicles with a batch in flight
+    std::vector <Request *> _completed;             ///< In-flight requests whose poll returned
+    bool _stopping{false};                          ///< Set on destruction
+    std::thread _thread;                            ///< Timer loop, started with the first request
+    std::vector <std::thread> _workers;             ///< Send polls, started with the loop
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_STATUS_POLLER_HPP
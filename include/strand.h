@@ -0,0 +1,58 @@
+#pragma once
+#ifndef SUBARULINK_STRAND_HPP
+#define SUBARULINK_STRAND_HPP
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace subarulink {
+
+/**
+ * @brief Serial executor that runs posted tasks one at a time, in order
+ *
+ * Each vehicle owns a strand, so everything that mutates one vehicle is
+ * serialized without a lock shared across vehicles. No thread is kept while
+ * the strand is idle; posting to an idle strand starts a worker that drains
+ * the queue and exits.
+ *
+ * @note A task must not wait on another task posted to the same strand.
+ */
+  class Strand {
+  public:
+    Strand() = default;
+    ~Strand();
+
+    Strand(const Strand &) = delete;
+    Strand &operator=(const Strand &) = delete;
+
+    /**
+     * @brief Queues a task behind every task already posted
+     * @param task Callable taking no arguments
+     * @return Future for the task's result or exception
+     */
+    template<typename F>
+    std::future<std::invoke_result_t<F>> post(F task) {
+      using Result = std::invoke_result_t<F>;
+      auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+      auto result = packaged->get_future();
+      _enqueue([packaged]() { (*packaged)(); });
+      return result;
+    }
+
+  private:
+    void _enqueue(std::function<void()> job);
+    void _drain();
+
+    std::mutex _mutex;                          ///< Guards the queue and worker state
+    std::deque <std::function<void()>> _jobs;   ///< Tasks waiting to run
+    bool _draining{false};                      ///< A worker is running
+    std::future<void> _worker;                  ///< Current or last worker
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_STRAND_HPP
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef SUBARULINK_TASK_GRAPH_HPP
+#define SUBARULINK_TASK_GRAPH_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <future>
+
+namespace subarulink {
+
+/**
+ * @brief Small dependency graph of asynchronous tasks
+ *
+ * Each task starts as soon as the tasks it depends on have finished, so
+ * independent requests run concurrently while ordered steps stay ordered.
+ * A task whose dependency failed is not run and reports the same failure.
+ */
+  class TaskGraph {
+  public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Adds a task to the graph
+     * @param name Unique task name
+     * @param task Work to run
+     * @param depends_on Names of previously added tasks that must finish first
+     * @throws SubaruException if the name is taken or a dependency is unknown
+     */
+    void add(const std::string &name, Task task, const std::vector <std::string> &depends_on = {});
+
+    /**
+     * @brief Runs every task and waits for all of them to finish
+     * @throws The first failure in insertion order, after all tasks have finished
+     */
+    void run();
+
+  private:
+    struct Node {
+      std::string name;                       ///< Task name
+      Task task;                              ///< Work to run
+      std::vector <size_t> dependencies;      ///< Indexes of prerequisite nodes
+      std::shared_future<void> done;          ///< Completion of this node
+    };
+
+    std::vector <Node> _nodes;                ///< Nodes in insertion order
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_TASK_GRAPH_HPP
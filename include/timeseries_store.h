@@ -0,0 +1,199 @@
+#pragma once
+#ifndef SUBARULINK_TIMESERIES_STORE_HPP
+#define SUBARULINK_TIMESERIES_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <mutex>
+#include <cstdint>
+
+namespace subarulink {
+
+/**
+ * @brief One recorded value of a numeric field
+ */
+  struct TimeSeriesPoint {
+    std::chrono::system_clock::time_point time;  ///< Vehicle-reported time, stored to the second
+    double value{0.0};                           ///< Field value
+  };
+
+/**
+ * @brief Aggregate of the points falling in one downsampling bucket
+ */
+  struct TimeSeriesBucket {
+    std::chrono::system_clock::time_point start;  ///< Start of the bucket
+    size_t count{0};                              ///< Points in the bucket
+    double min{0.0};                              ///< Smallest value
+    double max{0.0};                              ///< Largest value
+    double avg{0.0};                              ///< Mean value
+  };
+
+/**
+ * @brief How much of each series is kept
+ *
+ * Whole segments are dropped once every point in them is outside a limit, so
+ * a series may briefly hold up to SEGMENT_POINTS more than asked for.
+ */
+  struct TimeSeriesRetention {
+    std::chrono::seconds max_age{0};  ///< Age relative to the series' newest point, 0 for no limit
+    size_t max_points{0};             ///< Points per series, 0 for no limit
+  };
+
+/**
+ * @brief Gorilla-compressed history of numeric fields, per vehicle and field
+ *
+ * Timestamps are stored as delta-of-delta and values as the XOR with the
+ * previous value, bit packed into segments of SEGMENT_POINTS. A field polled
+ * at a steady interval with an unchanged value costs about 2 bits per point.
+ *
+ * With a directory, each full segment is written to
+ * `<directory>/<vin>/<field>/<first time>.seg` and mapped read-only while a
+ * query scans it, so sealed history costs no heap, holds no mappings between
+ * queries and survives a restart. Only the open segment of each series is kept
+ * in memory; flush() or destruction seals it. Segment files use the host byte
+ * order.
+ */
+  class TimeSeriesStore {
+  public:
+    static constexpr size_t SEGMENT_POINTS = 1024;  ///< Points per sealed segment
+
+    /**
+     * @brief Constructs a store, loading any segments already in the directory
+     * @param directory Segment file directory, empty to keep everything in memory
+     * @throws SubaruException if the directory cannot be created
+     */
+    explicit TimeSeriesStore(const std::string &directory = "");
+
+    /**
+     * @brief Seals open segments to disk when backed by a directory
+     */
+    ~TimeSeriesStore();
+
+    TimeSeriesStore(const TimeSeriesStore &) = delete;
+    TimeSeriesStore &operator=(const TimeSeriesStore &) = delete;
+
+    /**
+     * @brief Records a value
+     * @param vin Vehicle identification number
+     * @param field Field name, e.g. ODOMETER
+     * @param time Vehicle-reported time of the value
+     * @param value Value to record
+     * @return False if the time is not newer than the series' latest point
+     */
+    bool append(const std::string &vin, const std::string &field,
+                std::chrono::system_clock::time_point time, double value);
+
+    /**
+     * @brief Gets the points recorded in a time range
+     * @param vin Vehicle identification number
+     * @param field Field name
+     * @param from Start of the range, inclusive
+     * @param to End of the range, inclusive
+     * @return Points, oldest first
+     */
+    std::vector <TimeSeriesPoint> range(const std::string &vin, const std::string &field,
+                                        std::chrono::system_clock::time_point from,
+                                        std::chrono::system_clock::time_point to) const;
+
+    /**
+     * @brief Aggregates the points in a time range into fixed-width buckets
+     * @param vin Vehicle identification number
+     * @param field Field name
+     * @param from Start of the range and of the first bucket
+     * @param to End of the range, inclusive
+     * @param width Bucket width, at least one second
+     * @return Non-empty buckets, oldest first
+     */
+    std::vector <TimeSeriesBucket> downsample(const std::string &vin, const std::string &field,
+                                              std::chrono::system_clock::time_point from,
+                                              std::chrono::system_clock::time_point to,
+                                              std::chrono::seconds width) const;
+
+    /**
+     * @brief Gets the fields recorded for a vehicle
+     * @param vin Vehicle identification number
+     * @return Field names in sorted order
+     */
+    std::vector <std::string> fields(const std::string &vin) const;
+
+    /**
+     * @brief Gets the number of points kept in a series
+     * @param vin Vehicle identification number
+     * @param field Field name
+     * @return Point count
+     */
+    size_t size(const std::string &vin, const std::string &field) const;
+
+    /**
+     * @brief Changes the retention limits, dropping old segments if needed
+     * @param retention Limits applied to every series
+     */
+    void set_retention(const TimeSeriesRetention &retention);
+
+    /**
+     * @brief Gets the retention limits
+     * @return Limits applied to every series
+     */
+    TimeSeriesRetention get_retention() const;
+
+    /**
+     * @brief Seals every open segment, writing it to disk when backed by a directory
+     */
+    void flush();
+
+    /**
+     * @brief Gets the heap memory held by encoded points
+     * @return Bytes, excluding segments written to files
+     */
+    size_t memory_bytes() const;
+
+    /**
+     * @brief Gets the segment file directory
+     * @return Directory, empty for an in-memory store
+     */
+    const std::string &directory() const;
+
+  private:
+    struct Segment {
+      int64_t first_time{0};                     ///< Seconds since the epoch of the first point
+      int64_t last_time{0};                      ///< Seconds since the epoch of the last point
+      size_t count{0};                           ///< Points in the segment
+      size_t bits{0};                            ///< Encoded length in bits
+      std::vector <uint8_t> bytes;               ///< Encoded points, empty once written to a file
+      std::string path;                          ///< Segment file path, empty if in memory
+    };
+
+    /**
+     * @brief Encoder state of a series' open segment
+     */
+    struct Series {
+      std::deque <Segment> sealed;   ///< Oldest first
+      Segment open;                  ///< Segment being appended to
+      int64_t delta{0};              ///< Last timestamp delta of the open segment
+      uint64_t value_bits{0};        ///< Last value of the open segment
+      int leading{-1};               ///< Leading zeros of the last XOR window, -1 if none
+      int trailing{0};               ///< Trailing zeros of the last XOR window
+      size_t points{0};              ///< Points across segments
+    };
+
+    using SeriesKey = std::pair<std::string, std::string>;
+
+    template<typename Visitor>
+    static void _scan(const Segment &segment, int64_t first, int64_t last, Visitor visit);
+    void _seal(const SeriesKey &key, Series &series) const;
+    void _trim(Series &series) const;
+    static void _drop(Segment &segment);
+    void _load();
+
+    std::string _directory;                    ///< Segment file directory, empty for memory only
+    mutable std::mutex _mutex;                 ///< Guards everything below
+    TimeSeriesRetention _retention;            ///< Limits applied to every series
+    std::map <SeriesKey, Series> _series;      ///< History per vehicle and field
+  };
+
+} // namespace subarulink
+
+#endif // SUBARULINK_TIMESERIES_STORE_HPP
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef SUBARULINK_TIMESTAMP_HPP
+#define SUBARULINK_TIMESTAMP_HPP
+
+#include <string>
+#include <chrono>
+#include <optional>
+
+namespace subarulink {
+
+/**
+ * @brief Parses a timestamp reported by the STARLINK API
+ *
+ * Accepts every format listed in api_constants.h, e.g.
+ * "2020-04-25T23:35:55.000+0000", "2020-04-25T23:35:55+0000",
+ * "2020-04-25T23:35+0000" and "2020-04-25T23:35:55Z".
+ *
+ * @param value Timestamp string
+ * @return UTC time point, or std::nullopt if the string is not a known format
+ */
+  std::optional <std::chrono::system_clock::time_point> parse_api_timestamp(const std::string &value);
+
+} // namespace subarulink
+
+#endif // SUBARULINK_TIMESTAMP_HPP
@@ -0,0 +1,211 @@
+#pragma once
+#ifndef SUBARULINK_TRACE_HPP
+#define SUBARULINK_TRACE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace subarulink {
+
+/**
+ * @brief Identifies the span work on the current thread belongs to
+ */
+  struct TraceContext {
+    uint64_t trace_id{0};  ///< Shared by every span of one operation, 0 outside any trace
+    uint64_t span_id{0};   ///< Innermost open span
+  };
+
+/**
+ * @brief One finished span
+ */
+  struct TraceEvent {
+    std::string name;                                ///< What ran, e.g. Connection::_make_request
+    std::string detail;                              ///< Optional argument such as the endpoint
+    uint64_t trace_id{0};                            ///< Operation the span belongs to
+    uint64_t span_id{0};                             ///< Unique span id
+    uint64_t parent_id{0};                           ///< Enclosing span, 0 for a root
+    uint32_t thread{0};                              ///< Small per-thread number
+    std::chrono::steady_clock::time_point queued;    ///< When the work was handed to another thread, if it was
+    std::chrono::steady_clock::time_point start;     ///< When the span opened
+    std::chrono::steady_clock::duration duration{};  ///< How long it stayed open
+  };
+
+/**
+ * @brief Process-wide span recorder
+ *
+ * Spans are only recorded while tracing is enabled; otherwise opening one
+ * costs a relaxed load. Finished spans go into a buffer owned by the thread
+ * that ran them and are collected when exported, so threads never contend
+ * with each other while recording.
+ */
+  class Tracer {
+  public:
+    static constexpr size_t MAX_EVENTS = 1 << 20;  ///< Spans kept before new ones are dropped
+
+    /**
+     * @brief Gets the process-wide tracer
+     * @return Tracer
+     */
+    static Tracer &instance();
+
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+    /**
+     * @brief Starts or stops recording spans
+     * @param enabled True to record, off by default
+     */
+    void set_enabled(bool enabled);
+
+    /**
+     * @brief Checks whether spans are recorded
+     * @return True if enabled
+     */
+    bool enabled() const {
+      return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the context of the current thread
+     * @return Innermost open span, or an empty context
+     */
+    static TraceContext current();
+
+    /**
+     * @brief Collects finished spans
+     * @param trace_id Only spans of this trace, or 0 for all
+     * @return Spans ordered by start time
+     */
+    std::vector <TraceEvent> events(uint64_t trace_id = 0) const;
+
+    /**
+     * @brief Formats finished spans as Chrome trace-event JSON, viewable in Perfetto
+     *
+     * Spans are complete ("X") events; a span started on another thread than
+     * its parent is linked to it by a flow arrow from the handoff.
+     *
+     * @param trace_id Only spans of this trace, or 0 for all
+     * @return JSON document
+     */
+    std::string chrome_trace(uint64_t trace_id = 0) const;
+
+    /**
+     * @brief Writes chrome_trace() to a file
+     * @param path Destination file
+     * @param trace_id Only spans of this trace, or 0 for all
+     * @return True if written
+     */
+    bool write_chrome_trace(const std::string &path, uint64_t trace_id = 0) const;
+
+    /**
+     * @brief Discards every finished span
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of spans dropped because MAX_EVENTS were held
+     * @return Dropped spans since start
+     */
+    uint64_t dropped() const;
+
+  private:
+    friend class TraceSpan;
+    struct Buffer;
+
+    Tracer();
+
+    void _record(TraceEvent &&event);
+    uint64_t _next_id();
+
+    std::atomic<bool> _enabled{false};                 ///< Spans are recorded
+    std::atomic<uint64_t> _ids{0};                     ///< Last trace or span id handed out
+    std::atomic<size_t> _size{0};                      ///< Spans held across all buffers
+    std::atomic<uint64_t> _dropped{0};                 ///< Spans lost to MAX_EVENTS
+    std::chrono::steady_clock::time_point _epoch;      ///< Zero of exported timestamps
+
+    mutable std::mutex _mutex;                         ///< Guards the registry below
+    std::vector<Buffer *> _buffers;                    ///< Buffers of live threads
+    std::vector <TraceEvent> _retired;                 ///< Spans of exited threads
+  };
+
+/**
+ * @brief Records the time until it is ended or goes out of scope
+ *
+ * While open it is the current span of its thread, so spans opened inside it
+ * become its children. A span opened outside any trace starts a new one.
+ */
+  class TraceSpan {
+  public:
+    /**
+     * @brief Opens a child of the current span
+     * @param name Span name
+     * @param detail Optional argument shown with the span
+     */
+    explicit TraceSpan(std::string_view name, std::string_view detail = {});
+
+    /**
+     * @brief Opens a child of a span from another thread
+     * @param name Span name
+     * @param parent Context captured where the work was handed off
+     * @param queued When it was handed off, to show the wait; default if unknown
+     */
+    TraceSpan(std::string_view name, const TraceContext &parent,
+              std::chrono::steady_clock::time_point queued = {});
+
+    /**
+     * @brief Ends the span if still open
+     */
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    /**
+     * @brief Ends the span before the end of its scope
+     */
+    void end();
+
+    /**
+     * @brief Gets the trace the span belongs to
+     * @return Trace id, 0 if tracing was disabled when it opened
+     */
+    uint64_t trace_id() const { return _event.trace_id; }
+
+  private:
+    void _open(std::string_view name, std::string_view detail, const TraceContext &parent,
+               std::chrono::steady_clock::time_point queued);
+
+    bool _active{false};
+    TraceContext _previous;
+    TraceEvent _event;
+  };
+
+/**
+ * @brief Wraps a task so it runs in a span that continues the caller's trace
+ *
+ * Use it for work handed to another thread, e.g.
+ * std::async(std::launch::async, traced("name", [this]() { ... })).
+ *
+ * @param name Span name
+ * @param task Callable taking no arguments
+ * @return Callable returning what task returns
+ */
+  template<typename F>
+  auto traced(std::string name, F task) {
+    auto context = Tracer::current();
+    auto queued = Tracer::instance().enabled() ? std::chrono::steady_clock::now()
+                                               : std::chrono::steady_clock::time_point{};
+    return [name = std::move(name), context, queued, task = std::move(task)]() mutable {
+      TraceSpan span(name, context, queued);
+      return task();
+    };
+  }
+
+} // namespace subarulink
+
+#endif // SUBARULINK_TRACE_HPP
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <set>
+
+#include "bulk_operation.h"
+#include "trace.h"
+
+namespace subarulink {
+
+  std::vector<std::string> BulkResult::failed_vins() const {
+    std::vector<std::string> vins;
+    for (const auto &[vin, outcome]: outcomes) {
+      if (!outcome.success) {
+        vins.push_back(vin);
+      }
+    }
+    return vins;
+  }
+
+  BulkResult run_bulk(const std::vector<std::string> &vins,
+                      const std::function<BulkStatus(const std::string &)> &operation,
+                      const BulkOptions &options) {
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<std::string> unique;
+    std::set<std::string> seen;
+    for (const auto &vin: vins) {
+      if (seen.insert(vin).second) {
+        unique.push_back(vin);
+      }
+    }
+
+    BulkResult result;
+    std::mutex result_mutex;
+    std::atomic<size_t> next{0};
+
+    auto worker = [&]() {
+      for (size_t i = next++; i < unique.size(); i = next++) {
+        const auto &vin = unique[i];
+        auto vin_started = std::chrono::steady_clock::now();
+
+        BulkOutcome outcome;
+        try {
+          auto status = operation(vin);
+          outcome.success = status != BulkStatus::FAILED;
+          outcome.skipped = status == BulkStatus::SKIPPED;
+        } catch (const std::exception &e) {
+          outcome.error = e.what();
+        }
+        outcome.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - vin_started);
+
+        // Progress is reported under the lock so callbacks see a consistent count and never overlap
+        std::lock_guard<std::mutex> lock(result_mutex);
+        (outcome.success ? result.succeeded : result.failed)++;
+        if (outcome.skipped) {
+          result.skipped++;
+        }
+        result.outcomes[vin] = outcome;
+        if (options.on_progress) {
+          try {
+            options.on_progress(vin, outcome, result.outcomes.size(), unique.size());
+          } catch (...) {
+            // A failing callback must not abandon the remaining vehicles
+          }
+        }
+      }
+    };
+
+    auto workers = std::min(std::max<size_t>(options.max_parallel, 1), unique.size());
+    std::vector<std::future<void>> running;
+    for (size_t i = 1; i < workers; ++i) {
+      running.push_back(std::async(std::launch::async, traced("bulk_worker", worker)));
+    }
+    if (workers > 0) {
+      worker();
+    }
+    for (auto &future: running) {
+      future.get();
+    }
+
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started);
+    return result;
+  }
+
+  BulkResult run_bulk(const std::vector<std::string> &vins,
+                      const std::function<bool(const std::string &)> &operation,
+                      const BulkOptions &options) {
+    return run_bulk(vins, [&operation](const std::string &vin) {
+      return operation(vin) ? BulkStatus::SUCCEEDED : BulkStatus::FAILED;
+    }, options);
+  }
+
+} // namespace subarulink
@@ -0,0 +1,74 @@
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+
+#include "change_log.h"
+#include "exceptions.h"
+
+namespace subarulink {
+
+  namespace {
+
+    struct FieldRegistry {
+      std::mutex mutex;
+      std::unordered_map<std::string, FieldId> ids;
+      std::deque<std::string> names;  // deque keeps references stable as it grows
+    };
+
+    FieldRegistry &registry() {
+      static FieldRegistry instance;
+      return instance;
+    }
+
+  } // namespace
+
+  FieldId field_id(const std::string &name) {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.ids.find(name);
+    if (it != reg.ids.end()) {
+      return it->second;
+    }
+    auto id = static_cast<FieldId>(reg.names.size());
+    reg.names.push_back(name);
+    reg.ids.emplace(name, id);
+    return id;
+  }
+
+  const std::string &field_name(FieldId id) {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (id >= reg.names.size()) {
+      throw SubaruException("Unknown field id: " + std::to_string(id));
+    }
+    return reg.names[id];
+  }
+
+  ChangeLog::ChangeLog(size_t capacity) : _capacity(std::max<size_t>(capacity, 1)) {}
+
+  uint64_t ChangeLog::commit(std::vector <FieldDelta> deltas) {
+    if (deltas.empty()) {
+      return _version;
+    }
+
+    ++_version;
+    for (auto &delta: deltas) {
+      delta.version = _version;
+      _deltas.push_back(std::move(delta));
+    }
+
+    while (_deltas.size() > _capacity) {
+      _evicted_version = _deltas.front().version;
+      _deltas.pop_front();
+    }
+    return _version;
+  }
+
+  std::vector <FieldDelta> ChangeLog::since(uint64_t version) const {
+    // Versions are ascending, so binary search for the first newer delta
+    auto first = std::upper_bound(_deltas.begin(), _deltas.end(), version,
+                                  [](uint64_t v, const FieldDelta &delta) { return v < delta.version; });
+    return std::vector<FieldDelta>(first, _deltas.end());
+  }
+
+} // namespace subarulink
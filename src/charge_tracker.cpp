@@ -0,0 +1,126 @@
+#include <algorithm>
+
+#include "charge_tracker.h"
+
+namespace subarulink {
+
+  namespace {
+    // Weight of the newest rate; older samples still count so one noisy step does not swing the prediction
+    constexpr double RATE_SMOOTHING = 0.5;
+
+    double hours_between(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) {
+      return std::chrono::duration<double, std::ratio<3600>>(to - from).count();
+    }
+  }
+
+  ChargeTracker::Transition ChargeTracker::record(const std::string &vin, const ChargeSample &sample) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &track = _tracks[vin];
+
+    if (!sample.charging) {
+      if (!track.active) {
+        return Transition::NONE;
+      }
+      auto &session = *track.session;
+      if (sample.state_of_charge) {
+        session.percent = *sample.state_of_charge;
+      }
+      session.ended = sample.time;
+      session.updated = sample.time;
+      session.completed = session.percent >= FULL_PERCENT;
+      session.predicted_full.reset();
+      track.active = false;
+      return Transition::ENDED;
+    }
+
+    if (!track.active) {
+      ChargeSession session;
+      session.started = sample.time;
+      session.start_percent = sample.state_of_charge.value_or(0.0);
+      session.percent = session.start_percent;
+      session.updated = sample.time;
+      _predict(session, sample);
+      track.session = session;
+      track.active = true;
+      track.changed_percent = session.percent;
+      track.changed_at = sample.time;
+      return Transition::STARTED;
+    }
+
+    auto &session = *track.session;
+    if (sample.time <= session.updated) {
+      // The vehicle has not reported since the last query
+      return Transition::NONE;
+    }
+    session.updated = sample.time;
+
+    if (sample.state_of_charge && *sample.state_of_charge > track.changed_percent) {
+      auto hours = hours_between(track.changed_at, sample.time);
+      if (hours > 0) {
+        auto rate = (*sample.state_of_charge - track.changed_percent) / hours;
+        session.rate = session.rate ? RATE_SMOOTHING * rate + (1 - RATE_SMOOTHING) * *session.rate : rate;
+      }
+      track.changed_percent = *sample.state_of_charge;
+      track.changed_at = sample.time;
+    }
+    if (sample.state_of_charge) {
+      session.percent = *sample.state_of_charge;
+    }
+    _predict(session, sample);
+    return Transition::NONE;
+  }
+
+  std::optional<ChargeSession> ChargeTracker::session(const std::string &vin) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _tracks.find(vin);
+    return it == _tracks.end() ? std::nullopt : it->second.session;
+  }
+
+  bool ChargeTracker::is_charging(const std::string &vin) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _tracks.find(vin);
+    return it != _tracks.end() && it->second.active;
+  }
+
+  std::optional<int> ChargeTracker::poll_delay(const std::string &vin,
+                                               std::chrono::system_clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _tracks.find(vin);
+    if (it == _tracks.end() || !it->second.active) {
+      return std::nullopt;
+    }
+
+    const auto &session = *it->second.session;
+    if (!session.predicted_full) {
+      return PROBE_INTERVAL;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::seconds>(*session.predicted_full - now).count();
+    if (remaining > REFINE_THRESHOLD) {
+      return static_cast<int>(std::min<long long>(remaining / 2, 24LL * 3600));
+    }
+    if (remaining >= 0) {
+      return static_cast<int>(std::max<long long>(remaining + COMPLETION_MARGIN, MIN_POLL_INTERVAL));
+    }
+    // Overdue, typically slowing near full; back off with how late it is instead of polling every minute
+    return static_cast<int>(std::clamp<long long>(-remaining, MIN_POLL_INTERVAL, PROBE_INTERVAL));
+  }
+
+  void ChargeTracker::reset(const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tracks.erase(vin);
+  }
+
+  void ChargeTracker::_predict(ChargeSession &session, const ChargeSample &sample) {
+    if (session.rate && *session.rate > 0) {
+      auto hours = (FULL_PERCENT - std::min(session.percent, FULL_PERCENT)) / *session.rate;
+      session.predicted_full = session.updated + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::duration<double, std::ratio<3600>>(hours));
+    } else if (sample.full_at) {
+      session.predicted_full = sample.full_at;
+    } else {
+      session.predicted_full.reset();
+    }
+  }
+
+} // namespace subarulink
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <unordered_map>
+
+#include "climate_preset.h"
+#include "constants.h"
+#include "exceptions.h"
+
+namespace subarulink {
+
+  namespace {
+
+    // Wire fields understood by ClimatePreset, used to index the tables below
+    enum class Field : uint8_t {
+      NAME,
+      MODE,
+      FAN_SPEED,
+      HEAT_SEAT_LEFT,
+      HEAT_SEAT_RIGHT,
+      RUNTIME,
+      TEMP_F,
+      TEMP_C,
+      REAR_DEFROST,
+      REAR_AC,
+      RECIRCULATE,
+      PRESET_TYPE,
+      VEHICLE_TYPE,
+      START_CONFIGURATION,
+      CAN_EDIT,
+      DISABLED,
+      COUNT
+    };
+
+    constexpr size_t FIELD_COUNT = static_cast<size_t>(Field::COUNT);
+    using ValueMask = std::bitset<128>;
+
+    struct FieldTables {
+      std::unordered_map<std::string, Field> by_key;
+      std::array<std::string, FIELD_COUNT> keys;
+      // Code -> wire string; index 0 is the unset code
+      std::array<std::vector<std::string>, FIELD_COUNT> vocabulary;
+    };
+
+    // Built on first use so the climate_control statics are initialized by then
+    const FieldTables &tables() {
+      static const FieldTables t = []() {
+        using namespace climate_control;
+        FieldTables t;
+        const std::vector<std::string> toggle = {"", "false", "true"};
+
+        auto add = [&t](Field field, const std::string &key, std::vector<std::string> vocab) {
+          t.by_key.emplace(key, field);
+          t.keys[static_cast<size_t>(field)] = key;
+          t.vocabulary[static_cast<size_t>(field)] = std::move(vocab);
+        };
+
+        add(Field::NAME, PRESET_NAME, {});
+        add(Field::MODE, MODE, {"", Mode::DEFROST, Mode::FEET_DEFROST, Mode::FACE, Mode::FEET, Mode::SPLIT, Mode::AUTO});
+        add(Field::FAN_SPEED, FAN_SPEED, {"", FanSpeed::AUTO, FanSpeed::LOW, FanSpeed::MEDIUM, FanSpeed::HIGH});
+        add(Field::HEAT_SEAT_LEFT, HEAT_SEAT_LEFT, {"", HeatSeat::OFF, HeatSeat::LOW, HeatSeat::MEDIUM, HeatSeat::HIGH});
+        add(Field::HEAT_SEAT_RIGHT, HEAT_SEAT_RIGHT, {"", HeatSeat::OFF, HeatSeat::LOW, HeatSeat::MEDIUM, HeatSeat::HIGH});
+        add(Field::RUNTIME, RUNTIME, {"", RUNTIME_5_MIN, RUNTIME_10_MIN});
+        add(Field::TEMP_F, TEMP_F, {});
+        add(Field::TEMP_C, TEMP_C, {});
+        add(Field::REAR_DEFROST, REAR_DEFROST, {"", REAR_DEFROST_OFF, REAR_DEFROST_ON});
+        add(Field::REAR_AC, REAR_AC, {"", REAR_AC_OFF, REAR_AC_ON});
+        add(Field::RECIRCULATE, RECIRCULATE, {"", RECIRCULATE_OFF, RECIRCULATE_ON});
+        add(Field::PRESET_TYPE, PRESET_TYPE, {"", PRESET_TYPE_SUBARU, PRESET_TYPE_USER});
+        add(Field::VEHICLE_TYPE, VEHICLE_TYPE, {"", VEHICLE_TYPE_GAS, VEHICLE_TYPE_PHEV});
+        add(Field::START_CONFIGURATION, START_CONFIGURATION, {"", START_CONFIGURATION_EV, START_CONFIGURATION_RES});
+        add(Field::CAN_EDIT, CAN_EDIT, toggle);
+        add(Field::DISABLED, DISABLED, toggle);
+        return t;
+      }();
+      return t;
+    }
+
+    bool is_temperature(Field field) {
+      return field == Field::TEMP_F || field == Field::TEMP_C;
+    }
+
+    // Returns the code for a wire value, or 0 if the value is not recognized
+    uint8_t decode(Field field, const nlohmann::json &value) {
+      if (is_temperature(field)) {
+        int degrees = 0;
+        if (value.is_number_integer()) {
+          degrees = value.get<int>();
+        } else if (value.is_string()) {
+          const auto &s = value.get_ref<const std::string &>();
+          if (s.empty() || s.size() > 3) {
+            return 0;
+          }
+          for (char c: s) {
+            if (c < '0' || c > '9') {
+              return 0;
+            }
+            degrees = degrees * 10 + (c - '0');
+          }
+        }
+        return (degrees > 0 && degrees < 128) ? static_cast<uint8_t>(degrees) : 0;
+      }
+
+      const auto &vocab = tables().vocabulary[static_cast<size_t>(field)];
+      if (value.is_boolean() && vocab.size() == 3 && vocab[1] == "false") {
+        return value.get<bool>() ? 2 : 1;
+      }
+      if (value.is_number_integer()) {
+        // e.g. runTimeMinutes sent as 10 rather than "10"
+        return decode(field, std::to_string(value.get<int64_t>()));
+      }
+      if (!value.is_string()) {
+        return 0;
+      }
+      const auto &s = value.get_ref<const std::string &>();
+      for (size_t code = 1; code < vocab.size(); ++code) {
+        if (vocab[code] == s) {
+          return static_cast<uint8_t>(code);
+        }
+      }
+      return 0;
+    }
+
+    std::string encode(Field field, uint8_t code) {
+      if (is_temperature(field)) {
+        return std::to_string(code);
+      }
+      return tables().vocabulary[static_cast<size_t>(field)][code];
+    }
+
+    // Encodes with the JSON type the field arrived with; besides strings, decode only accepts booleans and integers
+    nlohmann::json encode(Field field, uint8_t code, bool native) {
+      auto s = encode(field, code);
+      if (!native) {
+        return s;
+      }
+      if (s == "true" || s == "false") {
+        return s == "true";
+      }
+      return std::stoi(s);
+    }
+
+    uint32_t field_bit(Field field) {
+      static_assert(FIELD_COUNT <= 32, "native_fields holds one bit per field");
+      return uint32_t(1) << static_cast<size_t>(field);
+    }
+
+    uint8_t get_code(const ClimatePreset &p, Field field) {
+      switch (field) {
+        case Field::MODE: return static_cast<uint8_t>(p.mode);
+        case Field::FAN_SPEED: return static_cast<uint8_t>(p.fan_speed);
+        case Field::HEAT_SEAT_LEFT: return static_cast<uint8_t>(p.heat_seat_left);
+        case Field::HEAT_SEAT_RIGHT: return static_cast<uint8_t>(p.heat_seat_right);
+        case Field::RUNTIME: return static_cast<uint8_t>(p.runtime);
+        case Field::TEMP_F: return p.temp_f;
+        case Field::TEMP_C: return p.temp_c;
+        case Field::REAR_DEFROST: return static_cast<uint8_t>(p.rear_defrost);
+        case Field::REAR_AC: return static_cast<uint8_t>(p.rear_ac);
+        case Field::RECIRCULATE: return static_cast<uint8_t>(p.recirculate);
+        case Field::PRESET_TYPE: return static_cast<uint8_t>(p.preset_type);
+        case Field::VEHICLE_TYPE: return static_cast<uint8_t>(p.vehicle_type);
+        case Field::START_CONFIGURATION: return static_cast<uint8_t>(p.start_configuration);
+        case Field::CAN_EDIT: return static_cast<uint8_t>(p.can_edit);
+        case Field::DISABLED: return static_cast<uint8_t>(p.disabled);
+        default: return 0;
+      }
+    }
+
+    void set_code(ClimatePreset &p, Field field, uint8_t code) {
+      switch (field) {
+        case Field::MODE: p.mode = static_cast<ClimatePreset::Mode>(code); break;
+        case Field::FAN_SPEED: p.fan_speed = static_cast<ClimatePreset::FanSpeed>(code); break;
+        case Field::HEAT_SEAT_LEFT: p.heat_seat_left = static_cast<ClimatePreset::HeatSeat>(code); break;
+        case Field::HEAT_SEAT_RIGHT: p.heat_seat_right = static_cast<ClimatePreset::HeatSeat>(code); break;
+        case Field::RUNTIME: p.runtime = static_cast<ClimatePreset::Runtime>(code); break;
+        case Field::TEMP_F: p.temp_f = code; break;
+        case Field::TEMP_C: p.temp_c = code; break;
+        case Field::REAR_DEFROST: p.rear_defrost = static_cast<ClimatePreset::Toggle>(code); break;
+        case Field::REAR_AC: p.rear_ac = static_cast<ClimatePreset::Toggle>(code); break;
+        case Field::RECIRCULATE: p.recirculate = static_cast<ClimatePreset::Circulation>(code); break;
+        case Field::PRESET_TYPE: p.preset_type = static_cast<ClimatePreset::PresetType>(code); break;
+        case Field::VEHICLE_TYPE: p.vehicle_type = static_cast<ClimatePreset::VehicleType>(code); break;
+        case Field::START_CONFIGURATION:
+          p.start_configuration = static_cast<ClimatePreset::StartConfiguration>(code);
+          break;
+        case Field::CAN_EDIT: p.can_edit = static_cast<ClimatePreset::Toggle>(code); break;
+        case Field::DISABLED: p.disabled = static_cast<ClimatePreset::Toggle>(code); break;
+        default: break;
+      }
+    }
+
+    struct AllowedValues {
+      std::bitset<FIELD_COUNT> validated;
+      std::array<ValueMask, FIELD_COUNT> masks;
+    };
+
+    // Allowed-value bitsets precomputed from climate_control::VALID_CLIMATE_OPTIONS
+    const AllowedValues &allowed_values() {
+      static const AllowedValues allowed = []() {
+        AllowedValues a;
+        for (const auto &[key, values]: climate_control::VALID_CLIMATE_OPTIONS) {
+          auto it = tables().by_key.find(key);
+          if (it == tables().by_key.end()) {
+            continue;
+          }
+          auto index = static_cast<size_t>(it->second);
+          a.validated.set(index);
+          for (const auto &value: values) {
+            if (auto code = decode(it->second, value)) {
+              a.masks[index].set(code);
+            }
+          }
+        }
+        return a;
+      }();
+      return allowed;
+    }
+
+  } // namespace
+
+  ClimatePreset ClimatePreset::from_json(const nlohmann::json &preset) {
+    ClimatePreset result;
+    for (const auto &[key, value]: preset.items()) {
+      result.assign(key, value);
+    }
+    return result;
+  }
+
+  bool ClimatePreset::assign(const std::string &key, const nlohmann::json &value) {
+    auto existing = std::find_if(passthrough.begin(), passthrough.end(),
+                                 [&key](const auto &entry) { return entry.first == key; });
+
+    auto it = tables().by_key.find(key);
+    if (it != tables().by_key.end()) {
+      bool decoded = false;
+      if (it->second == Field::NAME) {
+        if (value.is_string()) {
+          name = value.get<std::string>();
+          decoded = true;
+        }
+      } else if (auto code = decode(it->second, value)) {
+        set_code(*this, it->second, code);
+        decoded = true;
+      }
+
+      if (decoded && !value.is_string()) {
+        native_fields |= field_bit(it->second);
+      } else {
+        native_fields &= ~field_bit(it->second);
+      }
+
+      if (decoded) {
+        if (existing != passthrough.end()) {
+          passthrough.erase(existing);
+        }
+        return true;
+      }
+
+      // Keep the raw value only; a stale typed value would otherwise be encoded too
+      if (it->second == Field::NAME) {
+        name.clear();
+      } else {
+        set_code(*this, it->second, 0);
+      }
+    }
+
+    if (existing != passthrough.end()) {
+      existing->second = value;
+    } else {
+      passthrough.emplace_back(key, value);
+    }
+    return false;
+  }
+
+  nlohmann::json ClimatePreset::to_json() const {
+    nlohmann::json preset = nlohmann::json::object();
+    if (!name.empty()) {
+      preset[climate_control::PRESET_NAME] = name;
+    }
+
+    for (size_t i = 1; i < FIELD_COUNT; ++i) {
+      auto field = static_cast<Field>(i);
+      if (auto code = get_code(*this, field)) {
+        preset[tables().keys[i]] = encode(field, code, native_fields & field_bit(field));
+      }
+    }
+
+    for (const auto &[key, value]: passthrough) {
+      preset[key] = value;
+    }
+    return preset;
+  }
+
+  void ClimatePreset::validate() const {
+    const auto &allowed = allowed_values();
+
+    for (size_t i = 1; i < FIELD_COUNT; ++i) {
+      auto field = static_cast<Field>(i);
+      auto code = get_code(*this, field);
+      if (code && allowed.validated.test(i) && !allowed.masks[i].test(code)) {
+        throw SubaruException("Invalid value for " + tables().keys[i] + ": " +
+                              nlohmann::json(encode(field, code)).dump());
+      }
+    }
+
+    // Validated fields only land in passthrough when their value was not recognized
+    for (const auto &[key, value]: passthrough) {
+      auto it = tables().by_key.find(key);
+      if (it != tables().by_key.end() && allowed.validated.test(static_cast<size_t>(it->second))) {
+        throw SubaruException("Invalid value for " + key + ": " + value.dump());
+      }
+    }
+  }
+
+} // namespace subarulink
@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include "command_queue.h"
+
+namespace subarulink {
+
+  CommandQueue::CommandQueue(Dispatch dispatch, CommandRules rules, Settled settled)
+      : _dispatch(std::move(dispatch)),
+        _rules(std::move(rules)),
+        _settled(std::move(settled)) {}
+
+  std::shared_ptr<RemoteCommand> CommandQueue::submit(std::shared_ptr<RemoteCommand> command) {
+    std::vector<std::shared_ptr<RemoteCommand>> dropped;
+    std::string drop_reason;
+    bool nothing_to_stop = false;
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      auto cancels = _rules.cancels.find(command->command());
+      if (cancels != _rules.cancels.end()) {
+        const std::string &undoes = cancels->second;
+        for (auto it = _pending.begin(); it != _pending.end();) {
+          if ((*it)->command() == undoes) {
+            dropped.push_back(*it);
+            it = _pending.erase(it);
+          } else {
+            ++it;
+          }
+        }
+        drop_reason = RemoteCommand::CANCELLED;
+
+        // The vehicle may have been started by the app or the key fob, so a stop is only skipped
+        // when it just dropped a queued counterpart and nothing this queue sent is left to undo
+        bool running = _running && _running->command() == undoes;
+        nothing_to_stop = !dropped.empty() && !running && !_in_effect.count(undoes);
+      }
+
+      auto same = std::find_if(_pending.begin(), _pending.end(), [&command](const auto &queued) {
+        return queued->command() == command->command() &&
+               queued->poll_url() == command->poll_url() &&
+               queued->data() == command->data();
+      });
+      if (!nothing_to_stop && same != _pending.end()) {
+        command = *same;
+      } else if (cancels != _rules.cancels.end()) {
+        if (!nothing_to_stop) {
+          // Stops go ahead of other queued commands, right behind the one in flight
+          auto first = std::find_if(_pending.begin(), _pending.end(), [this](const auto &queued) {
+            return !_rules.cancels.count(queued->command());
+          });
+          _pending.insert(first, command);
+          _strand.post([this]() { _dispatch_next(); });
+        }
+      } else {
+        auto group = _rules.exclusive_group.find(command->command());
+        if (group != _rules.exclusive_group.end()) {
+          for (auto it = _pending.begin(); it != _pending.end();) {
+            auto other = _rules.exclusive_group.find((*it)->command());
+            if (other != _rules.exclusive_group.end() && other->second == group->second) {
+              dropped.push_back(*it);
+              it = _pending.erase(it);
+            } else {
+              ++it;
+            }
+          }
+          drop_reason = RemoteCommand::SUPERSEDED;
+        }
+
+        _pending.push_back(command);
+        _strand.post([this]() { _dispatch_next(); });
+      }
+    }
+
+    nlohmann::json response = {{"success", false}, {"errorCode", drop_reason}};
+    for (const auto &queued: dropped) {
+      _settle(queued, RemoteCommandState::CANCELLED, std::make_tuple(false, response));
+    }
+    if (nothing_to_stop) {
+      _settle(command, RemoteCommandState::SUCCEEDED, std::make_tuple(true, nlohmann::json{{"success", true}}));
+    }
+    return command;
+  }
+
+  bool CommandQueue::withdraw(const std::shared_ptr<RemoteCommand> &command) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto it = std::find(_pending.begin(), _pending.end(), command);
+      if (it == _pending.end()) {
+        return false;
+      }
+      _pending.erase(it);
+    }
+
+    _settle(command, RemoteCommandState::CANCELLED,
+            std::make_tuple(false, nlohmann::json{{"success", false}, {"errorCode", RemoteCommand::CANCELLED}}));
+    return true;
+  }
+
+  size_t CommandQueue::pending() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending.size();
+  }
+
+  void CommandQueue::_dispatch_next() {
+    std::shared_ptr<RemoteCommand> command;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      // Dropped commands leave their dispatch job behind; it finds nothing to send
+      if (_pending.empty()) {
+        return;
+      }
+      command = std::move(_pending.front());
+      _pending.pop_front();
+      _running = command;
+    }
+
+    RemoteCommand::Result result;
+    try {
+      result = _dispatch(command);
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running.reset();
+      }
+      command->fail(std::current_exception());
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      // Remember what took effect so a later stop knows there is something to undo
+      if (std::get<0>(result)) {
+        auto cancels = _rules.cancels.find(command->command());
+        if (cancels != _rules.cancels.end()) {
+          _in_effect.erase(cancels->second);
+        } else {
+          _in_effect.insert(command->command());
+        }
+      }
+      _running.reset();
+    }
+    command->complete(std::move(result));
+  }
+
+  void CommandQueue::_settle(const std::shared_ptr<RemoteCommand> &command, RemoteCommandState state,
+                             RemoteCommand::Result result) {
+    if (_settled) {
+      _settled(command, state);
+    }
+    command->transition(state);
+    command->complete(std::move(result));
+  }
+
+} // namespace subarulink
@@ -1,10 +1,12 @@
 #include <chrono>
 #include <thread>
 #include <algorithm>
-#include <iostream>
 
 #include "connection.h"
 #include "exceptions.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
 
 namespace subarulink {
 
@@ -28,8 +30,6 @@ namespace subarulink {
         _registered(false),
         _session_login_time(0.0) {
 
-    _session = std::make_shared<cpr::Session>();
-
     // Create API_MOBILE_APP map
     std::map<std::string, std::string> API_MOBILE_APP = {
         {"USA", "com.subaru.telematics.app.remote"},
@@ -46,12 +46,10 @@ namespace subarulink {
         {"Accept-Encoding", "gzip, deflate"},
         {"Accept", "*/*"}
     };
-
-    _session->SetHeader(cpr::Header(_headers.begin(), _headers.end()));
   }
 
   std::future<std::vector<nlohmann::json>> Connection::connect() {
-    return std::async(std::launch::async, [this]() {
+    return std::async(std::launch::async, traced("Connection::connect", [this]() {
       auto auth_result = _authenticate().get();
       if (!auth_result) {
         throw SubaruException("Authentication failed");
@@ -64,17 +62,17 @@ namespace subarulink {
       }
 
       return _vehicles;
-    });
+    }));
   }
 
   std::future<bool> Connection::_authenticate(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Connection::_authenticate", [this, vin]() {
       if (_username.empty() || _password.empty() || _device_id.empty()) {
         throw IncompleteCredentials("Connection requires email, password and device id.");
       }
 
-      std::cout << "Debug: Starting authentication flow" << std::endl;
-      std::cout << "Debug: device_id being used: " << _device_id << std::endl;
+      SUBARULINK_LOG_DEBUG("Starting authentication flow");
+      SUBARULINK_LOG_DEBUG("device_id being used: ", _device_id);
 
       // Create form data
       std::map<std::string, std::string> form_data = {
@@ -90,15 +88,15 @@ namespace subarulink {
 
       try {
         std::string endpoint = "https://" + API_SERVER.at(_country) + API_VERSION + "/login.json";
-        std::cout << "Debug: Making authentication request to: " << endpoint << std::endl;
+        SUBARULINK_LOG_DEBUG("Making authentication request to: ", endpoint);
 
         auto response = _make_request("/login.json", "POST", _headers, {}, form_data, nlohmann::json()).get();
-        std::cout << "Debug: Full response received: " << response.dump(2) << std::endl;
+        SUBARULINK_LOG_TRACE("Full response received: ", redact(response, 2));
 
         if (response["success"].get<bool>()) {
-          std::cout << "Debug: Authentication successful" << std::endl;
+          SUBARULINK_LOG_INFO("Authentication successful");
           _authenticated = true;
-          _session_login_time = std::chrono::system_clock::now().time_since_epoch().count() / 1000.0;
+          _session_login_time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
           _registered = response["data"]["deviceRegistered"].get<bool>();
 
           _list_of_vins.clear();
@@ -107,13 +105,13 @@ namespace subarulink {
               _list_of_vins.push_back(vehicle["vin"].get<std::string>());
             }
           }
-          _current_vin = "";
+          _set_current_vin("");
           return true;
         }
 
         if (response.contains("errorCode")) {
           std::string error = response["errorCode"].get<std::string>();
-          std::cout << "Debug: Authentication failed with error: " << error << std::endl;
+          SUBARULINK_LOG_WARN("Authentication failed with error: ", error);
 
           if (error == "InvalidAccount" || error == "InvalidCredentials") {
             throw InvalidCredentials(error);
@@ -123,30 +121,40 @@ namespace subarulink {
 
         throw SubaruException("Unexpected response format");
       } catch (const std::exception& e) {
-        std::cout << "Debug: Error during authentication: " << e.what() << std::endl;
+        SUBARULINK_LOG_WARN("Error during authentication: ", e.what());
         throw;
       }
-    });
+    }));
   }
 
   std::future<bool> Connection::validate_session(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Connection::validate_session", [this, vin]() {
       auto response = _make_request("/validateSession.json", "GET").get();
 
       if (response["success"].get<bool>()) {
-        if (vin != _current_vin) {
+        if (vin != _get_current_vin()) {
           return _select_vehicle(vin).get().contains("success");
         }
         return true;
       }
 
+      Metrics::instance().count(MetricEvent::REAUTHENTICATION);
       _authenticate(vin).get();
       return _select_vehicle(vin).get().contains("success");
-    });
+    }));
+  }
+
+  std::future<bool> Connection::select_vehicle(const std::string& vin) {
+    return std::async(std::launch::async, traced("Connection::select_vehicle", [this, vin]() {
+      if (vin == _get_current_vin()) {
+        return true;
+      }
+      return _select_vehicle(vin).get().contains("success");
+    }));
   }
 
   std::future<nlohmann::json> Connection::_select_vehicle(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Connection::_select_vehicle", [this, vin]() {
       std::map<std::string, std::string> params = {
           {"vin", vin},
           {"_", std::to_string(std::time(nullptr))}
@@ -155,7 +163,8 @@ namespace subarulink {
       auto response = get("/selectVehicle.json", params).get();
 
       if (response["success"].get<bool>()) {
-        _current_vin = vin;
+        _set_current_vin(vin);
+        Metrics::instance().count(MetricEvent::VEHICLE_SWITCH);
         return response["data"];
       }
 
@@ -166,16 +175,16 @@ namespace subarulink {
 
       reset_session();
       throw SubaruException("Failed to switch vehicle: " + response["errorCode"].get<std::string>());
-    });
+    }));
   }
 
   std::future<bool> Connection::request_auth_code(const std::string& contact_method) {
-    return std::async(std::launch::async, [this, contact_method]() {
+    return std::async(std::launch::async, traced("Connection::request_auth_code", [this, contact_method]() {
       if (_auth_contact_options.find(contact_method) == _auth_contact_options.end()) {
         return false;
       }
 
-      std::cout << "Debug: Requesting 2FA code" << std::endl;
+      SUBARULINK_LOG_DEBUG("Requesting 2FA code");
 
       std::map<std::string, std::string> form_data = {
           {"contactMethod", contact_method},
@@ -184,11 +193,11 @@ namespace subarulink {
 
       auto response = _make_request("/twoStepAuthSendVerification.json", "POST", {}, {}, form_data, nlohmann::json()).get();
       return response.contains("success") && response["success"].get<bool>();
-    });
+    }));
   }
 
   std::future<bool> Connection::submit_auth_code(const std::string& code, bool make_permanent) {
-    return std::async(std::launch::async, [this, code, make_permanent]() {
+    return std::async(std::launch::async, traced("Connection::submit_auth_code", [this, code, make_permanent]() {
       if (code.length() != 6 || !std::all_of(code.begin(), code.end(), ::isdigit)) {
         return false;
       }
@@ -209,16 +218,16 @@ namespace subarulink {
         while (!_registered) {
           std::this_thread::sleep_for(std::chrono::seconds(3));
           _authenticate().get();
-          _current_vin = "";
+          _set_current_vin("");
         }
         return true;
       }
       return false;
-    });
+    }));
   }
 
   std::future<void> Connection::_get_vehicle_data() {
-    return std::async(std::launch::async, [this]() {
+    return std::async(std::launch::async, traced("Connection::_get_vehicle_data", [this]() {
       for (const auto& vin : _list_of_vins) {
         std::map<std::string, std::string> params = {
             {"vin", vin},
@@ -227,23 +236,22 @@ namespace subarulink {
 
         auto response = get("/selectVehicle.json", params).get();
         _vehicles.push_back(response["data"]);
-        _current_vin = vin;
+        _set_current_vin(vin);
       }
-    });
+    }));
   }
 
   std::future<void> Connection::_get_contact_methods() {
-    return std::async(std::launch::async, [this]() {
+    return std::async(std::launch::async, traced("Connection::_get_contact_methods", [this]() {
       auto response = _make_request("/twoStepAuthContacts.json", "POST").get();
       if (response.contains("data")) {
         _auth_contact_options = response["data"].get<std::map<std::string, std::string>>();
 
-        std::cout << "Debug: Available 2FA contact methods:" << std::endl;
         for (const auto& [method, contact] : _auth_contact_options) {
-          std::cout << "  " << method << ": " << contact << std::endl;
+          SUBARULINK_LOG_DEBUG("2FA contact method ", method, ": ", contact);
         }
       }
-    });
+    }));
   }
 
   std::future<nlohmann::json> Connection::_make_request(
@@ -255,25 +263,30 @@ namespace subarulink {
       const nlohmann::json& json_data,
       const std::string& baseurl) {
 
-    return std::async(std::launch::async, [this, url, method, headers, params, data, json_data, baseurl]() {
-      std::string base = baseurl.empty() ?
-                         "https://" + API_SERVER.at(_country) + API_VERSION : baseurl;
+    return std::async(std::launch::async, traced("Connection::_make_request", [this, url, method, headers, params, data, json_data, baseurl]() {
+      std::string base = !baseurl.empty() ? baseurl :
+                         !_base_url.empty() ? _base_url : "https://" + API_SERVER.at(_country) + API_VERSION;
       std::string endpoint = base + url;
 
-      std::cout << "Debug: Making request to: " << endpoint << std::endl;
-      std::cout << "Debug: Method: " << method << std::endl;
+      SUBARULINK_LOG_DEBUG(method, " ", endpoint);
 
-      std::lock_guard<std::mutex> lock(_mutex);
-      _session->SetUrl(cpr::Url{endpoint});
+      TraceSpan limit_span("rate_limit");
+      _limiter.acquire();
+      limit_span.end();
 
-      // Handle parameters
-      if (!params.empty()) {
-        cpr::Parameters parameters;
-        for (const auto& param : params) {
-          parameters.Add({param.first, param.second});
-        }
-        _session->SetParameters(parameters);
+      auto started = std::chrono::steady_clock::now();
+      uint64_t generation = 0;
+      TraceSpan acquire_span("acquire_session");
+      auto session = _acquire_session(generation);
+      acquire_span.end();
+      session->SetUrl(cpr::Url{endpoint});
+
+      // Pooled sessions keep settings from their previous request, so always reset them
+      cpr::Parameters parameters;
+      for (const auto& param : params) {
+        parameters.Add({param.first, param.second});
       }
+      session->SetParameters(parameters);
 
       // Handle headers
       if (!headers.empty()) {
@@ -281,7 +294,9 @@ namespace subarulink {
         for (const auto& h : headers) {
           header.insert({h.first, h.second});
         }
-        _session->SetHeader(header);
+        session->SetHeader(header);
+      } else {
+        session->SetHeader(cpr::Header(_headers.begin(), _headers.end()));
       }
 
       cpr::Response response;
@@ -292,69 +307,178 @@ namespace subarulink {
             pairs.push_back({d.first, d.second});
           }
           cpr::Payload payload(pairs.begin(), pairs.end());
-          _session->SetPayload(payload);
+          session->SetPayload(payload);
 
-          std::cout << "Debug: Setting form data:" << std::endl;
           for (const auto& pair : pairs) {
-            std::cout << "  " << pair.key << ": " << pair.value << std::endl;
+            SUBARULINK_LOG_TRACE("Form field ", pair.key, ": ", redact_field(pair.key, pair.value));
           }
         }
         else if (!json_data.empty()) {
-          _session->SetBody(cpr::Body{json_data.dump()});
-          std::cout << "Debug: Setting JSON body: " << json_data.dump() << std::endl;
+          session->SetBody(cpr::Body{json_data.dump()});
+          SUBARULINK_LOG_TRACE("Setting JSON body: ", redact(json_data));
+        } else {
+          session->SetBody(cpr::Body{""});
         }
 
-        response = _session->Post();
+        TraceSpan http_span(method, url);
+        response = session->Post();
       } else {
-        response = _session->Get();
+        TraceSpan http_span(method, url);
+        response = session->Get();
       }
 
-      std::cout << "Debug: Response status: " << response.status_code << std::endl;
-      std::cout << "Debug: Response text: " << response.text.substr(0, 200) << "..." << std::endl;
+      _release_session(session, generation, response.cookies);
+
+      SUBARULINK_LOG_DEBUG("Response status: ", response.status_code);
 
-      if (response.status_code > 299) {
-        throw SubaruException("HTTP " + std::to_string(response.status_code) + ": " + response.text);
+      auto status = static_cast<int>(response.status_code);
+      if (status > 299) {
+        Metrics::instance().record_request(url, status, "", std::chrono::steady_clock::now() - started);
+        throw SubaruException("HTTP " + std::to_string(status) + ": " + response.text);
       }
 
-      auto js_resp = nlohmann::json::parse(response.text);
+      TraceSpan parse_span("parse");
+      nlohmann::json js_resp;
+      try {
+        js_resp = nlohmann::json::parse(response.text);
+      } catch (const nlohmann::json::parse_error&) {
+        Metrics::instance().record_request(url, status, "InvalidResponse", std::chrono::steady_clock::now() - started);
+        throw;
+      }
+      parse_span.end();
+      SUBARULINK_LOG_TRACE("Response: ", redact(js_resp));
+
+      std::string error_code;
+      if (js_resp.contains("errorCode") && js_resp["errorCode"].is_string()) {
+        error_code = js_resp["errorCode"].get<std::string>();
+      }
+      Metrics::instance().record_request(url, status, error_code, std::chrono::steady_clock::now() - started);
+
       if (!js_resp.contains("success") && !js_resp.contains("serviceType")) {
         throw SubaruException("Unexpected response: " + response.text);
       }
 
       return js_resp;
-    });
+    }));
   }
 
   std::future<nlohmann::json> Connection::get(const std::string& url,
                                               const std::map<std::string, std::string>& params) {
-    return std::async(std::launch::async, [this, url, params]() {
+    return std::async(std::launch::async, traced("Connection::get", [this, url, params]() {
       if (!_authenticated) {
         return nlohmann::json{};
       }
       return _make_request(url, "GET", _headers, params).get();
-    });
+    }));
   }
 
   std::future<nlohmann::json> Connection::post(const std::string& url,
                                                const std::map<std::string, std::string>& params,
                                                const nlohmann::json& json_data) {
-    return std::async(std::launch::async, [this, url, params, json_data]() {
+    return std::async(std::launch::async, traced("Connection::post", [this, url, params, json_data]() {
       if (!_authenticated) {
         return nlohmann::json{};
       }
       return _make_request(url, "POST", _headers, params, {}, json_data).get();
-    });
+    }));
+  }
+
+  std::shared_ptr<cpr::Session> Connection::_acquire_session(uint64_t& generation) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    generation = _session_generation;
+
+    std::shared_ptr<cpr::Session> session;
+    if (!_idle_sessions.empty()) {
+      session = _idle_sessions.back();
+      _idle_sessions.pop_back();
+    } else {
+      session = std::make_shared<cpr::Session>();
+    }
+
+    // Setting cookies explicitly replaces the session's own jar with the account cookies
+    cpr::Cookies cookies{false};
+    for (const auto& [name, value] : _cookies) {
+      cookies.push_back(cpr::Cookie{name, value});
+    }
+    session->SetCookies(cookies);
+    return session;
+  }
+
+  void Connection::_release_session(std::shared_ptr<cpr::Session> session,
+                                    uint64_t generation,
+                                    const cpr::Cookies& cookies) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (generation != _session_generation) {
+      // The session was reset while this request was in flight; drop its connection and cookies
+      return;
+    }
+
+    for (const auto& cookie : cookies) {
+      _cookies[cookie.GetName()] = cookie.GetValue();
+    }
+    _idle_sessions.push_back(std::move(session));
   }
 
   double Connection::get_session_age() const {
-    auto current_time = std::chrono::system_clock::now().time_since_epoch().count() / 1000.0;
+    // Both in seconds since the epoch
+    auto current_time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
     return (current_time - _session_login_time) / 60.0;
   }
 
+  Connection::VehicleLane::VehicleLane(Connection& connection, const std::string& vin)
+      : _connection(connection) {
+    std::unique_lock<std::mutex> lock(_connection._lane_mutex);
+    // Take a ticket so lanes are admitted in arrival order and a busy vehicle
+    // cannot keep extending its lane past another vehicle's waiting request
+    const uint64_t ticket = _connection._lane_next_ticket++;
+    _connection._lane_cv.wait(lock, [this, &vin, ticket]() {
+      return ticket == _connection._lane_serving &&
+             (_connection._lane_users == 0 || _connection._lane_vin == vin);
+    });
+    _connection._lane_vin = vin;
+    ++_connection._lane_users;
+    ++_connection._lane_serving;
+    lock.unlock();
+    // The next ticket may be for the same VIN and can be admitted alongside us
+    _connection._lane_cv.notify_all();
+  }
+
+  Connection::VehicleLane::~VehicleLane() {
+    {
+      std::lock_guard<std::mutex> lock(_connection._lane_mutex);
+      --_connection._lane_users;
+    }
+    _connection._lane_cv.notify_all();
+  }
+
+  void Connection::_set_current_vin(const std::string& vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _current_vin = vin;
+  }
+
+  std::string Connection::_get_current_vin() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _current_vin;
+  }
+
+  void Connection::set_base_url(const std::string& base_url) {
+    _base_url = base_url;
+  }
+
+  void Connection::set_rate_limit(double requests_per_second, double burst) {
+    _limiter.set_rate(requests_per_second, burst);
+  }
+
+  double Connection::get_rate_limit() const {
+    return _limiter.get_rate();
+  }
+
   void Connection::reset_session() {
+    Metrics::instance().count(MetricEvent::SESSION_RESET);
     std::lock_guard<std::mutex> lock(_mutex);
-    _session = std::make_shared<cpr::Session>();
-    _session->SetHeader(cpr::Header(_headers.begin(), _headers.end()));
+    _idle_sessions.clear();
+    _cookies.clear();
+    ++_session_generation;
   }
 
 } // namespace subarulink
\ No newline at end of file
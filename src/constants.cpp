@@ -5,25 +5,9 @@ namespace subarulink {
 // Climate control static member definitions
   namespace climate_control {
 
-// Mode definitions
-    const std::string Mode::DEFROST = "DEFROST";
-    const std::string Mode::FEET_DEFROST = "FEET_DEFROST";
-    const std::string Mode::FACE = "FACE";
-    const std::string Mode::FEET = "FEET";
-    const std::string Mode::SPLIT = "SPLIT";
-    const std::string Mode::AUTO = "AUTO";
-
-// HeatSeat definitions
-    const std::string HeatSeat::HIGH = "HIGH";
-    const std::string HeatSeat::MEDIUM = "MEDIUM";
-    const std::string HeatSeat::LOW = "LOW";
-    const std::string HeatSeat::OFF = "OFF";
-
-// FanSpeed definitions
-    const std::string FanSpeed::LOW = "LOW";
-    const std::string FanSpeed::MEDIUM = "MEDIUM";
-    const std::string FanSpeed::HIGH = "HIGH";
-    const std::string FanSpeed::AUTO = "AUTO";
+// Mode, HeatSeat and FanSpeed members are defined inline in the header so that
+// VALID_CLIMATE_OPTIONS can be built during static initialization of any
+// translation unit without depending on this file being initialized first.
 
 // Constants for temp ranges (already defined in header as constexpr/const)
 // const int TEMP_F_MAX = 85;
@@ -1,13 +1,100 @@
 #include <chrono>
+#include <cmath>
+#include <optional>
 #include <thread>
 
 #include "controller.h"
+#include "task_graph.h"
+#include "timestamp.h"
 #include "api_constants.h"
 #include "exceptions.h"
 #include "constants.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
 
 namespace subarulink {
 
+  namespace {
+    const FetchGroup FETCH_GROUPS[] = {
+        FetchGroup::STATUS,
+        FetchGroup::CONDITION,
+        FetchGroup::HEALTH,
+        FetchGroup::LOCATION,
+        FetchGroup::PRESETS
+    };
+
+    // Vehicle-reported time of parsed data, falling back to now if absent or unparseable
+    std::chrono::system_clock::time_point source_time(const nlohmann::json& values, const std::string& key) {
+      auto it = values.find(key);
+      if (it != values.end() && it->is_string()) {
+        if (auto parsed = parse_api_timestamp(it->get<std::string>())) {
+          return *parsed;
+        }
+      }
+      return std::chrono::system_clock::now();
+    }
+
+    // Content hash of quick start settings; json objects are key-ordered, so equal settings hash equally
+    size_t quick_start_hash(const nlohmann::json& settings) {
+      return std::hash<nlohmann::json>{}(settings);
+    }
+
+    // Hash of the settings in a fetch response, whose data may be the settings or a string encoding them
+    std::optional<size_t> fetched_quick_start_hash(const nlohmann::json& response) {
+      if (!response.value("success", false) || !response.contains("data")) {
+        return std::nullopt;
+      }
+      const auto& data = response["data"];
+      if (data.is_object()) {
+        return quick_start_hash(data);
+      }
+      if (data.is_string()) {
+        auto parsed = nlohmann::json::parse(data.get<std::string>(), nullptr, false);
+        if (parsed.is_object()) {
+          return quick_start_hash(parsed);
+        }
+      }
+      return std::nullopt;
+    }
+
+    // Lock and unlock supersede each other while queued; a stop drops its queued start and is sent after a running one
+    CommandRules command_rules() {
+      CommandRules rules;
+      rules.exclusive_group = {
+          {api::API_LOCK, "doors"},
+          {api::API_UNLOCK, "doors"}
+      };
+      rules.cancels = {
+          {api::API_HORN_LIGHTS_STOP, api::API_HORN_LIGHTS},
+          {api::API_LIGHTS_STOP, api::API_LIGHTS},
+          {api::API_G2_REMOTE_ENGINE_STOP, api::API_G2_REMOTE_ENGINE_START}
+      };
+      return rules;
+    }
+
+    // Numeric fields overwritten on every fetch whose history is worth keeping
+    const std::string HISTORY_FIELDS[] = {
+        vehicle_fields::ODOMETER,
+        vehicle_fields::AVG_FUEL_CONSUMPTION,
+        vehicle_fields::TIRE_PRESSURE_FL,
+        vehicle_fields::TIRE_PRESSURE_FR,
+        vehicle_fields::TIRE_PRESSURE_RL,
+        vehicle_fields::TIRE_PRESSURE_RR,
+        vehicle_fields::EV_DISTANCE_TO_EMPTY,
+        vehicle_fields::EV_STATE_OF_CHARGE_PERCENT
+    };
+
+    // Endpoints that cancel a sent command before the vehicle acts on it
+    const std::map<std::string, std::string> CANCEL_ENDPOINTS = {
+        {api::API_LOCK, api::API_LOCK_CANCEL},
+        {api::API_UNLOCK, api::API_UNLOCK_CANCEL},
+        {api::API_HORN_LIGHTS, api::API_HORN_LIGHTS_CANCEL},
+        {api::API_LIGHTS, api::API_LIGHTS_CANCEL},
+        {api::API_G2_REMOTE_ENGINE_START, api::API_G2_REMOTE_ENGINE_START_CANCEL}
+    };
+  }
+
   Controller::Controller(const std::string& username,
                          const std::string& password,
                          const std::string& device_id,
@@ -20,19 +107,28 @@ namespace subarulink {
         _country(country),
         _update_interval(update_interval),
         _fetch_interval(fetch_interval),
-        _pin_lockout(false) {
+        _pin_lockout(false),
+        _preset_interval(PRESET_INTERVAL),
+        _group_intervals{{FetchGroup::CONDITION, CONDITION_INTERVAL},
+                         {FetchGroup::HEALTH, HEALTH_INTERVAL},
+                         {FetchGroup::LOCATION, LOCATION_INTERVAL}},
+        _status_poller([this](const std::string& poll_url, const std::string& req_id) {
+          return _poll_request_status(poll_url, req_id);
+        }) {
 
     _connection = std::make_unique<Connection>(username, password, device_id, device_name, country);
   }
 
   std::future<bool> Controller::connect() {
-    return std::async(std::launch::async, [this]() {
+    return std::async(std::launch::async, traced("Controller::connect", [this]() {
+      OperationTimer timer("connect");
       auto vehicles = _connection->connect().get();
       for (const auto &vehicle: vehicles) {
         _parse_vehicle(vehicle);
       }
+      timer.set_success(!vehicles.empty());
       return !vehicles.empty();
-    });
+    }));
   }
 
   bool Controller::device_registered() const {
@@ -117,25 +213,10 @@ namespace subarulink {
   }
 
   std::future<bool> Controller::has_power_windows(const std::string &vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      auto it = _vehicles.find(vin);
-      if (it != _vehicles.end()) {
-        // Check if vehicle has explicit power window feature
-        for (const auto &feature: api::API_FEATURE_WINDOWS_LIST) {
-          if (std::find(it->second.vehicle_features.begin(),
-                        it->second.vehicle_features.end(),
-                        feature) != it->second.vehicle_features.end()) {
-            return true;
-          }
-        }
-
-        // Check for sunroof which implies power windows
-        for (const auto &feature: api::API_FEATURE_MOONROOF_LIST) {
-          if (std::find(it->second.vehicle_features.begin(),
-                        it->second.vehicle_features.end(),
-                        feature) != it->second.vehicle_features.end()) {
-            return true;
-          }
+    return std::async(std::launch::async, traced("Controller::has_power_windows", [this, vin]() {
+      if (_vehicles.find(vin) != _vehicles.end()) {
+        if (_has_power_windows(vin)) {
+          return true;
         }
 
         // Check G2 vehicles that might have windows without announcing feature
@@ -146,7 +227,39 @@ namespace subarulink {
         }
       }
       return false;
-    });
+    }));
+  }
+
+  bool Controller::_has_power_windows(const std::string &vin) const {
+    auto it = _vehicles.find(vin);
+    if (it == _vehicles.end()) {
+      return false;
+    }
+
+    // Check if vehicle has explicit power window feature
+    for (const auto &feature: api::API_FEATURE_WINDOWS_LIST) {
+      if (std::find(it->second.vehicle_features.begin(),
+                    it->second.vehicle_features.end(),
+                    feature) != it->second.vehicle_features.end()) {
+        return true;
+      }
+    }
+
+    // Check for sunroof which implies power windows
+    for (const auto &feature: api::API_FEATURE_MOONROOF_LIST) {
+      if (std::find(it->second.vehicle_features.begin(),
+                    it->second.vehicle_features.end(),
+                    feature) != it->second.vehicle_features.end()) {
+        return true;
+      }
+    }
+
+    // G2 vehicles that announce neither are judged by the cached status, never by fetching it
+    if (get_api_gen(vin) == api::API_FEATURE_G2_TELEMATICS) {
+      std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+      return !it->second.vehicle_status.empty();
+    }
+    return false;
   }
 
   bool Controller::has_sunroof(const std::string &vin) const {
@@ -165,7 +278,7 @@ namespace subarulink {
   }
 
   std::future<bool> Controller::has_lock_status(const std::string &vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Controller::has_lock_status", [this, vin]() {
       auto it = _vehicles.find(vin);
       if (it != _vehicles.end()) {
         // Check for explicit lock status feature
@@ -186,7 +299,7 @@ namespace subarulink {
         }
       }
       return false;
-    });
+    }));
   }
 
   bool Controller::has_tpms(const std::string &vin) const {
@@ -251,19 +364,68 @@ namespace subarulink {
   // Data Retrieval Methods
 
   std::future<VehicleInfo> Controller::get_data(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Controller::get_data", [this, vin]() {
       auto it = _vehicles.find(vin);
       if (it != _vehicles.end()) {
-        std::cout << "Debug: Found vehicle, checking status..." << std::endl;
-        if (it->second.vehicle_status.empty()) {
-          std::cout << "Debug: Vehicle status empty, fetching..." << std::endl;
+        SUBARULINK_LOG_DEBUG("Found vehicle, checking status...");
+        bool empty;
+        {
+          std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+          empty = it->second.vehicle_status.empty();
+        }
+        if (empty) {
+          SUBARULINK_LOG_DEBUG("Vehicle status empty, fetching...");
           fetch(vin).get();
         }
-        std::cout << "Debug: Returning vehicle data" << std::endl;
+        SUBARULINK_LOG_DEBUG("Returning vehicle data");
+        std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
         return it->second;
       }
       throw SubaruException("Invalid VIN");
-    });
+    }));
+  }
+
+  VehicleSnapshot Controller::get_snapshot(const std::string& vin, std::optional<std::chrono::seconds> max_staleness) {
+    _validate_vin(vin);
+    auto snapshot = _read_snapshot(vin);
+
+    if (snapshot.age.count() <= _fetch_interval) {
+      return snapshot;
+    }
+
+    auto refresh = _revalidate(vin);
+    if (max_staleness && snapshot.age > *max_staleness) {
+      refresh.get();
+      return _read_snapshot(vin);
+    }
+
+    snapshot.refreshing = refresh.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    return snapshot;
+  }
+
+  std::shared_future<bool> Controller::_revalidate(const std::string& vin) {
+    std::lock_guard<std::mutex> lock(_refresh_mutex);
+    auto it = _refreshes.find(vin);
+    if (it != _refreshes.end() && it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return it->second;
+    }
+
+    SUBARULINK_LOG_DEBUG("Starting background refresh for VIN: ", vin);
+    auto refresh = fetch(vin).share();
+    _refreshes[vin] = refresh;
+    return refresh;
+  }
+
+  VehicleSnapshot Controller::_read_snapshot(const std::string& vin) const {
+    VehicleSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+    snapshot.data = _vehicles.at(vin);
+
+    auto last = snapshot.data.group_last_fetch.find(FetchGroup::STATUS);
+    if (last != snapshot.data.group_last_fetch.end()) {
+      snapshot.age = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now() - last->second);
+    }
+    return snapshot;
   }
 
   nlohmann::json Controller::get_raw_data(const std::string &vin) const {
@@ -274,161 +436,260 @@ namespace subarulink {
     throw SubaruException("Invalid VIN");
   }
 
+  uint64_t Controller::get_version(const std::string &vin) const {
+    auto it = _change_logs.find(vin);
+    if (it != _change_logs.end()) {
+      std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+      return it->second.version();
+    }
+    throw SubaruException("Invalid VIN");
+  }
+
+  std::vector <FieldDelta> Controller::get_changes_since(const std::string &vin, uint64_t version,
+                                                        bool *truncated) const {
+    auto it = _change_logs.find(vin);
+    if (it != _change_logs.end()) {
+      std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+      // Checked under the same lock as the read, so a concurrent eviction cannot slip between them
+      if (truncated) {
+        *truncated = version < it->second.evicted_through();
+      }
+      return it->second.since(version);
+    }
+    throw SubaruException("Invalid VIN");
+  }
+
+  uint64_t Controller::get_evicted_through(const std::string &vin) const {
+    auto it = _change_logs.find(vin);
+    if (it != _change_logs.end()) {
+      std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+      return it->second.evicted_through();
+    }
+    throw SubaruException("Invalid VIN");
+  }
+  SubscriptionId Controller::subscribe(EventType types, EventCallback callback, const std::string &vin) {
+    if (!vin.empty()) {
+      _validate_vin(vin);
+    }
+    return _events.subscribe(types, std::move(callback), vin);
+  }
+
+  bool Controller::unsubscribe(SubscriptionId id) {
+    return _events.unsubscribe(id);
+  }
+
+  void Controller::set_event_executor(Executor executor) {
+    _events.set_executor(std::move(executor));
+  }
+
+
   std::future <std::vector<std::string>> Controller::list_climate_preset_names(const std::string &vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Controller::list_climate_preset_names", [this, vin]() {
       auto it = _vehicles.find(vin);
       if (it != _vehicles.end()) {
         std::vector <std::string> names;
         for (const auto &preset: it->second.climate) {
-          names.push_back(preset["name"].get<std::string>());
+          names.push_back(preset.name);
         }
         return names;
       }
       throw SubaruException("Invalid VIN");
-    });
+    }));
   }
 
   std::future <nlohmann::json>
   Controller::get_climate_preset_by_name(const std::string &vin, const std::string &preset_name) {
-    return std::async(std::launch::async, [this, vin, preset_name]() {
-      auto it = _vehicles.find(vin);
-      if (it != _vehicles.end()) {
-        for (const auto &preset: it->second.climate) {
-          if (preset["name"] == preset_name) {
-            return preset;
-          }
-        }
-        return nlohmann::json(nullptr);
+    return std::async(std::launch::async, traced("Controller::get_climate_preset_by_name", [this, vin, preset_name]() {
+      auto preset = _find_climate_preset(vin, preset_name);
+      if (preset) {
+        return preset->to_json();
       }
-      throw SubaruException("Invalid VIN");
-    });
+      return nlohmann::json(nullptr);
+    }));
   }
 
   std::future <std::vector<nlohmann::json>> Controller::get_user_climate_preset_data(const std::string &vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Controller::get_user_climate_preset_data", [this, vin]() {
       auto it = _vehicles.find(vin);
       if (it != _vehicles.end()) {
         std::vector <nlohmann::json> user_presets;
         for (const auto &preset: it->second.climate) {
-          if (preset["presetType"] == "userPreset") {
-            user_presets.push_back(preset);
+          if (preset.is_user_preset()) {
+            user_presets.push_back(preset.to_json());
           }
         }
         return user_presets;
       }
       throw SubaruException("Invalid VIN");
-    });
+    }));
   }
 
   std::future<bool> Controller::delete_climate_preset_by_name(const std::string &vin, const std::string &preset_name) {
-    return std::async(std::launch::async, [this, vin, preset_name]() {
-      auto preset = get_climate_preset_by_name(vin, preset_name).get();
-      if (!preset.is_null() && preset["presetType"] == "userPreset") {
-        auto user_presets = get_user_climate_preset_data(vin).get();
-        auto it = std::find_if(user_presets.begin(), user_presets.end(),
-                               [&preset_name](const nlohmann::json &p) {
-                                 return p["name"] == preset_name;
-                               });
-        if (it != user_presets.end()) {
-          user_presets.erase(it);
-          return update_user_climate_presets(vin, user_presets).get();
+    return std::async(std::launch::async, traced("Controller::delete_climate_preset_by_name", [this, vin, preset_name]() {
+      auto it = _vehicles.find(vin);
+      if (it == _vehicles.end()) {
+        throw SubaruException("Invalid VIN");
+      }
+
+      std::vector <ClimatePreset> user_presets;
+      bool found = false;
+      for (const auto &preset: it->second.climate) {
+        if (!preset.is_user_preset()) {
+          continue;
         }
+        if (!found && preset.name == preset_name) {
+          found = true;
+        } else {
+          user_presets.push_back(preset);
+        }
+      }
+
+      if (found) {
+        return update_user_climate_presets(vin, user_presets).get();
       }
       throw SubaruException("User preset '" + preset_name + "' not found");
-    });
+    }));
   }
 
   std::future<bool> Controller::update_user_climate_presets(const std::string &vin,
                                                             const std::vector <nlohmann::json> &preset_data) {
-    return std::async(std::launch::async, [this, vin, preset_data]() {
+    std::vector <ClimatePreset> presets;
+    presets.reserve(preset_data.size());
+    for (const auto &preset: preset_data) {
+      presets.push_back(ClimatePreset::from_json(preset));
+    }
+    return update_user_climate_presets(vin, presets);
+  }
+
+  std::future<bool> Controller::update_user_climate_presets(const std::string &vin,
+                                                            const std::vector <ClimatePreset> &presets) {
+    return std::async(std::launch::async, traced("Controller::update_user_climate_presets", [this, vin, presets = presets]() mutable {
       if (!_validate_remote_capability(vin)) {
         throw VehicleNotSupported(
             "Active STARLINK Security Plus subscription and remote start capable vehicle required.");
       }
 
-      if (preset_data.size() > MAX_PRESETS) {
+      if (presets.size() > MAX_PRESETS) {
         throw SubaruException("Maximum of 4 climate presets allowed");
       }
 
-      for (const auto &preset: preset_data) {
+      nlohmann::json preset_data = nlohmann::json::array();
+      for (auto &preset: presets) {
         if (!_validate_remote_start_params(vin, preset)) {
           throw SubaruException("Invalid climate preset parameters");
         }
+        preset_data.push_back(preset.to_json());
       }
 
       auto response = _post(api::API_G2_SAVE_RES_SETTINGS, {}, preset_data).get();
       if (response["success"].get<bool>()) {
-        return _fetch_climate_presets(vin).get();
+        return _fetch_climate_presets(vin, true).get();
       }
       return false;
-    });
+    }));
+  }
+
+  std::future<bool> Controller::refresh_climate_presets() {
+    return std::async(std::launch::async, traced("Controller::refresh_climate_presets", [this]() {
+      for (const auto &pair: _vehicles) {
+        if (_validate_remote_capability(pair.first)) {
+          return _fetch_climate_presets(pair.first, true).get();
+        }
+      }
+      return false;
+    }));
   }
 
   // Data Update Methods
   std::future<bool> Controller::fetch(const std::string& vin, bool force) {
-    return std::async(std::launch::async, [this, vin, force]() {
-      std::cout << "Debug: In fetch method for VIN: " << vin << std::endl;
+    return fetch(vin, FetchGroup::ALL, force);
+  }
 
-      std::string upper_vin = vin;
-      std::transform(upper_vin.begin(), upper_vin.end(), upper_vin.begin(), ::toupper);
+  std::future<bool> Controller::fetch(const std::string& vin, FetchGroup groups, bool force) {
+    SUBARULINK_LOG_DEBUG("In fetch method for VIN: ", vin);
 
-      auto it = _vehicles.find(upper_vin);
-      if (it != _vehicles.end()) {
-        std::cout << "Debug: Found vehicle in _vehicles map" << std::endl;
+    std::string upper_vin = vin;
+    std::transform(upper_vin.begin(), upper_vin.end(), upper_vin.begin(), ::toupper);
 
-        std::lock_guard<std::mutex> lock(_controller_mutex);
-        auto last_fetch = it->second.last_fetch;
-        auto current_time = std::chrono::system_clock::now();
+    auto strand = _strands.find(upper_vin);
+    if (strand == _strands.end()) {
+      SUBARULINK_LOG_WARN("Vehicle not found in _vehicles map");
+      std::promise<bool> not_found;
+      not_found.set_value(false);
+      return not_found.get_future();
+    }
 
-        // If status is empty, we should force fetch regardless of time
-        bool should_fetch = force ||
-                            it->second.vehicle_status.empty() ||
-                            std::chrono::duration_cast<std::chrono::seconds>(
-                                current_time - last_fetch).count() > _fetch_interval;
+    // Fetches of one vehicle run in order on its strand; other vehicles are not held up
+    return strand->second->post(traced("Controller::fetch", [this, upper_vin, groups, force]() {
+      auto current_time = std::chrono::system_clock::now();
+      FetchGroup stale;
+      {
+        std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(upper_vin));
+        stale = _stale_groups(upper_vin, groups & _available_groups(upper_vin), current_time, force);
+      }
 
-        if (should_fetch) {
-          std::cout << "Debug: Fetching fresh data..." << std::endl;
-          bool result = _fetch_status(upper_vin).get();
-          std::cout << "Debug: _fetch_status returned: " << result << std::endl;
+      if (stale == FetchGroup::NONE) {
+        SUBARULINK_LOG_DEBUG("Using cached data");
+        return false;
+      }
 
-          if (result) {
-            it->second.last_fetch = current_time;
-          }
-          return result;
-        } else {
-          std::cout << "Debug: Using cached data" << std::endl;
+      SUBARULINK_LOG_DEBUG("Fetching fresh data...");
+      OperationTimer timer("fetch");
+      // Each request takes the vehicle's lane itself, so other vehicles only wait out single round trips
+      auto fetched = _fetch_status(upper_vin, stale).get();
+      SUBARULINK_LOG_DEBUG("_fetch_status returned: ", static_cast<int>(fetched));
+
+      std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(upper_vin));
+      auto& info = _vehicles.at(upper_vin);
+      for (auto group : FETCH_GROUPS) {
+        if (has_group(fetched, group)) {
+          info.group_last_fetch[group] = current_time;
         }
-      } else {
-        std::cout << "Debug: Vehicle not found in _vehicles map" << std::endl;
       }
-      return false;
-    });
+      if (has_group(fetched, FetchGroup::STATUS)) {
+        info.last_fetch = current_time;
+      }
+      timer.set_success(fetched == stale);
+      return fetched == stale;
+    }));
   }
 
   std::future<bool> Controller::update(const std::string& vin, bool force) {
-    return std::async(std::launch::async, [this, vin, force]() {
-      std::string upper_vin = vin;
-      std::transform(upper_vin.begin(), upper_vin.end(), upper_vin.begin(), ::toupper);
+    std::string upper_vin = vin;
+    std::transform(upper_vin.begin(), upper_vin.end(), upper_vin.begin(), ::toupper);
+
+    auto strand = _strands.find(upper_vin);
+    if (strand == _strands.end()) {
+      std::promise<bool> invalid;
+      invalid.set_exception(std::make_exception_ptr(SubaruException("Invalid VIN")));
+      return invalid.get_future();
+    }
 
+    return strand->second->post(traced("Controller::update", [this, upper_vin, force]() {
       if (!get_remote_status(upper_vin)) {
         throw VehicleNotSupported("Active STARLINK Security Plus subscription required.");
       }
 
-      std::lock_guard<std::mutex> lock(_controller_mutex);
-      auto it = _vehicles.find(upper_vin);
-      auto last_update = it->second.last_update;
       auto current_time = std::chrono::system_clock::now();
+      std::chrono::system_clock::time_point last_update;
+      {
+        std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(upper_vin));
+        last_update = _vehicles.at(upper_vin).last_update;
+      }
 
       if (force || std::chrono::duration_cast<std::chrono::seconds>(
           current_time - last_update).count() > _update_interval) {
+        OperationTimer timer("update");
         bool result = _locate(upper_vin, true).get();
+        timer.set_success(result);
         if (result) {
-          it->second.last_update = current_time;
+          std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(upper_vin));
+          _vehicles.at(upper_vin).last_update = current_time;
         }
         return result;
       }
       return false;
-    });
+    }));
   }
 
   // Interval Management Methods
@@ -456,6 +717,212 @@ namespace subarulink {
     return false;
   }
 
+  bool Controller::save_latency_profiles(const std::string& path) const {
+    return _latency_profiles.save(path);
+  }
+
+  bool Controller::load_latency_profiles(const std::string& path) {
+    return _latency_profiles.load(path);
+  }
+
+  // Background Polling
+  void Controller::start_polling(bool include_updates) {
+    std::lock_guard<std::mutex> lock(_scheduler_mutex);
+    if (!_scheduler) {
+      _scheduler = std::make_unique<PollScheduler>(
+          [this](const std::string& vin, PollKind kind) { _scheduled_poll(vin, kind); },
+          [this](const std::string& vin, PollKind kind) { return _poll_interval(vin, kind); });
+    }
+
+    for (const auto& pair : _vehicles) {
+      _scheduler->add(pair.first, PollKind::FETCH);
+      if (include_updates && get_remote_status(pair.first)) {
+        _scheduler->add(pair.first, PollKind::UPDATE);
+      }
+    }
+    _scheduler->start();
+  }
+
+  void Controller::stop_polling() {
+    std::lock_guard<std::mutex> lock(_scheduler_mutex);
+    if (_scheduler) {
+      _scheduler->stop();
+    }
+  }
+
+  bool Controller::pause_polling(const std::string& vin) {
+    std::lock_guard<std::mutex> lock(_scheduler_mutex);
+    return _scheduler && _scheduler->pause(vin);
+  }
+
+  bool Controller::resume_polling(const std::string& vin) {
+    std::lock_guard<std::mutex> lock(_scheduler_mutex);
+    return _scheduler && _scheduler->resume(vin);
+  }
+
+  bool Controller::is_polling_paused(const std::string& vin) const {
+    std::lock_guard<std::mutex> lock(_scheduler_mutex);
+    return _scheduler && _scheduler->is_paused(vin);
+  }
+
+  void Controller::_scheduled_poll(const std::string& vin, PollKind kind) {
+    // The scheduler owns the timing, so a poll firing a moment early still counts as due
+    auto due_by = std::chrono::system_clock::now() + std::chrono::seconds(POLL_SLACK_SECS);
+
+    if (kind == PollKind::UPDATE) {
+      bool due;
+      {
+        std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(due_by - _vehicles.at(vin).last_update);
+        due = elapsed.count() >= _update_interval;
+      }
+      if (due) {
+        update(vin, true).get();
+      }
+      return;
+    }
+
+    // An active vehicle is polled more often than the fetch interval; look ahead by the difference
+    // so its status still counts as due
+    auto lead = std::max(0, _fetch_interval - _poll_interval(vin, PollKind::FETCH));
+    due_by += std::chrono::seconds(lead);
+
+    FetchGroup due;
+    {
+      std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+      due = _stale_groups(vin, _available_groups(vin), due_by, false);
+    }
+    if (due != FetchGroup::NONE) {
+      auto since = get_version(vin);
+      fetch(vin, due, true).get();
+      _observe_activity(vin, since);
+    }
+  }
+
+  int Controller::_poll_interval(const std::string& vin, PollKind kind) const {
+    if (kind == PollKind::UPDATE) {
+      return _update_interval;
+    }
+    if (!_adaptive_polling) {
+      return _fetch_interval;
+    }
+    // A charging vehicle is polled around its predicted finish; its rising charge would otherwise
+    // keep it at the base interval
+    if (auto delay = _charge_tracker.poll_delay(vin, std::chrono::system_clock::now())) {
+      return *delay;
+    }
+    return _poll_policy.interval(vin, _fetch_interval);
+  }
+
+  void Controller::_observe_activity(const std::string& vin, uint64_t since) {
+    PollObservation observation;
+    {
+      std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+      const auto& status = _vehicles.at(vin).vehicle_status;
+      auto state = status.find(vehicle_fields::VEHICLE_STATE);
+      observation.ignition_on = state != status.end() && state->second == vehicle_fields::VEHICLE_STATE_IGNITION_ON;
+
+      for (const auto& delta : _change_logs.at(vin).since(since)) {
+        const auto& name = field_name(delta.field);
+        if (name == "LAST_UPDATED_DATE" || name == vehicle_fields::TIMESTAMP) {
+          observation.source_moved = true;
+        } else {
+          observation.data_changed = true;
+        }
+      }
+    }
+    _poll_policy.record(vin, observation);
+  }
+
+  std::optional<VehicleState> Controller::get_vehicle_state(const std::string& vin) const {
+    _validate_vin(vin);
+    std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+    const auto& status = _vehicles.at(vin).vehicle_status;
+    auto state = status.find(vehicle_fields::VEHICLE_STATE);
+    if (state != status.end()) {
+      if (state->second == vehicle_fields::VEHICLE_STATE_IGNITION_ON) {
+        return VehicleState::IGNITION_ON;
+      }
+      if (state->second == vehicle_fields::VEHICLE_STATE_IGNITION_OFF) {
+        return VehicleState::IGNITION_OFF;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void Controller::set_adaptive_polling(bool enabled) {
+    _adaptive_polling = enabled;
+  }
+
+  bool Controller::get_adaptive_polling() const {
+    return _adaptive_polling;
+  }
+
+  bool Controller::set_active_poll_interval(int value) {
+    return _poll_policy.set_active_interval(value);
+  }
+
+  int Controller::get_poll_interval(const std::string& vin) const {
+    return _poll_interval(vin, PollKind::FETCH);
+  }
+
+  void Controller::set_request_rate_limit(double requests_per_second, double burst) {
+    _connection->set_rate_limit(requests_per_second, burst);
+  }
+
+  double Controller::get_request_rate_limit() const {
+    return _connection->get_rate_limit();
+  }
+
+  void Controller::set_base_url(const std::string& base_url) {
+    _connection->set_base_url(base_url);
+  }
+
+  int Controller::get_preset_interval() const {
+    return _preset_interval;
+  }
+
+  bool Controller::set_preset_interval(int value) {
+    if (value >= 300) {  // Minimum 5 minutes
+      _preset_interval = value;
+      return true;
+    }
+    return false;
+  }
+
+  int Controller::get_group_interval(FetchGroup group) const {
+    switch (group) {
+      case FetchGroup::STATUS:
+        return _fetch_interval;
+      case FetchGroup::PRESETS:
+        return _preset_interval;
+      default: {
+        auto it = _group_intervals.find(group);
+        if (it != _group_intervals.end()) {
+          return it->second;
+        }
+        throw SubaruException("Invalid fetch group");
+      }
+    }
+  }
+
+  bool Controller::set_group_interval(FetchGroup group, int value) {
+    switch (group) {
+      case FetchGroup::STATUS:
+        return set_fetch_interval(value);
+      case FetchGroup::PRESETS:
+        return set_preset_interval(value);
+      default: {
+        auto it = _group_intervals.find(group);
+        if (it != _group_intervals.end() && value >= 60) {  // Minimum 1 minute
+          it->second = value;
+          return true;
+        }
+        return false;
+      }
+    }
+  }
+
   // Time Related Methods
   std::chrono::system_clock::time_point Controller::get_last_fetch_time(const std::string& vin) const {
     auto it = _vehicles.find(vin);
@@ -473,189 +940,512 @@ namespace subarulink {
     throw SubaruException("Invalid VIN");
   }
 
-  std::future<bool> Controller::_fetch_status(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      std::cout << "Debug: Fetching vehicle status data..." << std::endl;
+  FetchGroup Controller::_available_groups(const std::string& vin) const {
+    auto groups = FetchGroup::STATUS;
 
-      try {
-        auto vehicle_status = _get_vehicle_status(vin).get();
-        _raw_api_data[vin]["vehicleStatus"] = vehicle_status;
+    // Additional data for Security Plus and Gen2/3
+    if (get_remote_status(vin) &&
+        (get_api_gen(vin) == api::API_FEATURE_G2_TELEMATICS ||
+         get_api_gen(vin) == api::API_FEATURE_G3_TELEMATICS)) {
+      groups |= FetchGroup::CONDITION | FetchGroup::HEALTH | FetchGroup::LOCATION;
+    }
 
-        if (vehicle_status.find("success") != vehicle_status.end() &&
-            vehicle_status["success"].get<bool>() &&
-            vehicle_status.find("data") != vehicle_status.end()) {
+    if (get_res_status(vin) || get_ev_status(vin)) {
+      groups |= FetchGroup::PRESETS;
+    }
+    return groups;
+  }
 
-          try {
-            auto status = _parse_vehicle_status(vehicle_status, vin);
+  FetchGroup Controller::_stale_groups(const std::string& vin, FetchGroup groups,
+                                       std::chrono::system_clock::time_point now, bool force) const {
+    const auto& info = _vehicles.at(vin);
+    auto stale = FetchGroup::NONE;
 
-            // Use insert with iterators to handle all values
-            for (auto it = status.begin(); it != status.end(); ++it) {
-              _vehicles[vin].vehicle_status[it.key()] = it.value();
-            }
+    for (auto group : FETCH_GROUPS) {
+      if (!has_group(groups, group)) {
+        continue;
+      }
+      auto last = info.group_last_fetch.find(group);
+      if (force || last == info.group_last_fetch.end() ||
+          std::chrono::duration_cast<std::chrono::seconds>(now - last->second).count() > get_group_interval(group)) {
+        stale |= group;
+      }
+    }
 
-            // Additional data for Security Plus and Gen2/3
-            if (get_remote_status(vin) &&
-                (get_api_gen(vin) == api::API_FEATURE_G2_TELEMATICS ||
-                 get_api_gen(vin) == api::API_FEATURE_G3_TELEMATICS)) {
-
-              std::cout << "Debug: Fetching additional data for G2/G3 vehicle" << std::endl;
-
-              // Get condition data
-              auto condition_resp = _remote_query(vin, api::API_CONDITION).get();
-              if (condition_resp.find("success") != condition_resp.end() &&
-                  condition_resp["success"].get<bool>()) {
-                _raw_api_data[vin]["condition"] = condition_resp;
-                if (condition_resp.find("data") != condition_resp.end()) {
-                  auto condition_status = _parse_condition(condition_resp, vin).get();
-                  for (auto it = condition_status.begin(); it != condition_status.end(); ++it) {
-                    _vehicles[vin].vehicle_status[it.key()] = it.value();
-                  }
-                }
-              }
+    // Condition and health parsing rely on capability checks that read the status
+    if (info.vehicle_status.empty() &&
+        (has_group(stale, FetchGroup::CONDITION) || has_group(stale, FetchGroup::HEALTH) ||
+         has_group(groups, FetchGroup::STATUS))) {
+      stale |= FetchGroup::STATUS;
+    }
+    return stale;
+  }
 
-              // Get vehicle health data
-              auto health_resp = _remote_query(vin, api::API_VEHICLE_HEALTH).get();
-              if (health_resp.find("success") != health_resp.end() &&
-                  health_resp["success"].get<bool>()) {
-                _raw_api_data[vin]["health"] = health_resp;
-                if (health_resp.find("data") != health_resp.end()) {
-                  auto health_data = _parse_health(health_resp, vin);
-                  for (auto it = health_data.begin(); it != health_data.end(); ++it) {
-                    _vehicles[vin].vehicle_health[it.key()] = it.value();
-                  }
-                }
+  std::future<FetchGroup> Controller::_fetch_status(const std::string& vin, FetchGroup groups) {
+    return std::async(std::launch::async, traced("Controller::_fetch_status", [this, vin, groups]() {
+      SUBARULINK_LOG_DEBUG("Fetching vehicle status data...");
+
+      auto requested = groups & _available_groups(vin);
+      auto fetched = FetchGroup::NONE;
+      std::mutex fetched_mutex;
+      auto mark_fetched = [&fetched, &fetched_mutex](FetchGroup group) {
+        std::lock_guard<std::mutex> lock(fetched_mutex);
+        fetched |= group;
+      };
+
+      bool fetch_status = has_group(requested, FetchGroup::STATUS);
+      bool status_success = false;
+      nlohmann::json condition_resp;
+      nlohmann::json health_resp;
+
+      // Everything except the presets needs the session validated once; each request then
+      // reselects the vehicle under its lane only if another vehicle took the selection. The
+      // condition and health results are merged after the status so capability checks see a
+      // populated status
+      TaskGraph graph;
+      auto vehicle_groups = FetchGroup::STATUS | FetchGroup::CONDITION | FetchGroup::HEALTH | FetchGroup::LOCATION;
+      if ((requested & vehicle_groups) != FetchGroup::NONE) {
+        graph.add("session", [this, vin]() {
+          Connection::VehicleLane lane(*_connection, vin);
+          _connection->validate_session(vin).get();
+        });
+      }
+
+      if (fetch_status) {
+        graph.add("status", [this, vin, &status_success, &mark_fetched]() {
+          auto vehicle_status = _get_vehicle_status(vin, true).get();
+          std::vector<VehicleEvent> events;
+          {
+            std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+            _raw_api_data.at(vin)["vehicleStatus"] = vehicle_status;
+
+            if (vehicle_status.find("success") != vehicle_status.end() &&
+                vehicle_status["success"].get<bool>() &&
+                vehicle_status.find("data") != vehicle_status.end()) {
+              try {
+                auto status = _parse_vehicle_status(vehicle_status, vin);
+
+                std::vector<FieldDelta> deltas;
+                auto time = source_time(status, vehicle_fields::TIMESTAMP);
+                _merge_fields(_vehicles.at(vin).vehicle_status, status, time, deltas);
+                _record_field_history(vin, status, time);
+                events = _commit_changes(vin, std::move(deltas));
+                status_success = true;
+                mark_fetched(FetchGroup::STATUS);
+              } catch (const nlohmann::json::exception& e) {
+                SUBARULINK_LOG_WARN("JSON parsing error: ", e.what());
+                throw;
               }
+            } else {
+              SUBARULINK_LOG_WARN("Vehicle status response was not successful or missing data");
+            }
+          }
+          _publish(events);
+        }, {"session"});
+      }
 
-              // Get location data
-              bool locate_success = _locate(vin).get();
+      // Merges wait for the status only when it is part of this fetch
+      auto after = [fetch_status](const std::string& query) {
+        return fetch_status ? std::vector<std::string>{query, "status"} : std::vector<std::string>{query};
+      };
+      auto status_usable = [fetch_status, &status_success]() {
+        return !fetch_status || status_success;
+      };
+
+      if (has_group(requested, FetchGroup::CONDITION)) {
+        graph.add("condition_query", [this, vin, &condition_resp]() {
+          condition_resp = _remote_query(vin, api::API_CONDITION, true).get();
+        }, {"session"});
+
+        graph.add("condition", [this, vin, &condition_resp, &status_usable, &mark_fetched]() {
+          if (!status_usable() || condition_resp.find("success") == condition_resp.end() ||
+              !condition_resp["success"].get<bool>()) {
+            return;
+          }
+          nlohmann::json condition_status;
+          if (condition_resp.find("data") != condition_resp.end()) {
+            condition_status = _parse_condition(condition_resp, vin).get();
+          }
+
+          std::vector<VehicleEvent> events;
+          {
+            std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+            _raw_api_data.at(vin)["condition"] = condition_resp;
+            std::vector<FieldDelta> deltas;
+            auto time = source_time(condition_status, "LAST_UPDATED_DATE");
+            _merge_fields(_vehicles.at(vin).vehicle_status, condition_status, time, deltas);
+            _record_field_history(vin, condition_status, time);
+            events = _commit_changes(vin, std::move(deltas));
+            if (get_ev_status(vin)) {
+              _track_charge(vin, condition_status, time, events);
             }
+          }
+          _publish(events);
+          mark_fetched(FetchGroup::CONDITION);
+        }, after("condition_query"));
+      }
 
-            // Fetch climate presets for supported vehicles
-            if (get_res_status(vin) || get_ev_status(vin)) {
-              _fetch_climate_presets(vin).get();
+      if (has_group(requested, FetchGroup::HEALTH)) {
+        graph.add("health_query", [this, vin, &health_resp]() {
+          health_resp = _remote_query(vin, api::API_VEHICLE_HEALTH, true).get();
+        }, {"session"});
+
+        graph.add("health", [this, vin, &health_resp, &status_usable, &mark_fetched]() {
+          if (!status_usable() || health_resp.find("success") == health_resp.end() ||
+              !health_resp["success"].get<bool>()) {
+            return;
+          }
+          std::vector<VehicleEvent> events;
+          {
+            std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+            _raw_api_data.at(vin)["health"] = health_resp;
+            if (health_resp.find("data") != health_resp.end()) {
+              auto health_data = _parse_health(health_resp, vin);
+              std::vector<FieldDelta> deltas;
+              _merge_fields(_vehicles.at(vin).vehicle_health, health_data, std::chrono::system_clock::now(), deltas);
+              events = _commit_changes(vin, std::move(deltas), EventType::HEALTH_TROUBLE);
             }
+          }
+          _publish(events);
+          mark_fetched(FetchGroup::HEALTH);
+        }, after("health_query"));
+      }
 
-            return true;
-          } catch (const nlohmann::json::exception& e) {
-            std::cout << "Debug: JSON parsing error: " << e.what() << std::endl;
-            throw;
+      if (has_group(requested, FetchGroup::LOCATION)) {
+        graph.add("location", [this, vin, &mark_fetched]() {
+          if (_locate(vin, false, true).get()) {
+            mark_fetched(FetchGroup::LOCATION);
           }
-        }
-        std::cout << "Debug: Vehicle status response was not successful or missing data" << std::endl;
-        return false;
+        }, {"session"});
+      }
 
+      // Fetch climate presets for supported vehicles
+      if (has_group(requested, FetchGroup::PRESETS)) {
+        graph.add("presets", [this, vin, &mark_fetched]() {
+          if (_fetch_climate_presets(vin).get()) {
+            mark_fetched(FetchGroup::PRESETS);
+          }
+        });
+      }
+
+      try {
+        graph.run();
       } catch (const std::exception& e) {
-        std::cout << "Debug: Error in _fetch_status: " << e.what() << std::endl;
-        if (std::string(e.what()).find("HTTP 500") != std::string::npos) {
-          return false;
+        SUBARULINK_LOG_WARN("Error in _fetch_status: ", e.what());
+        if (std::string(e.what()).find("HTTP 500") == std::string::npos) {
+          throw;
         }
-        throw;
       }
-    });
+      return fetched;
+    }));
   }
 
   // Vehicle Control Methods
 
   std::future<bool> Controller::charge_start(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
+    return std::async(std::launch::async, traced("Controller::charge_start", [this, vin]() {
       if (!get_ev_status(vin)) {
         throw VehicleNotSupported("PHEV charging not supported for this vehicle");
       }
-      auto [success, _] = _remote_command(vin, api::API_EV_CHARGE_NOW, api::API_REMOTE_SVC_STATUS).get();
+      auto [success, _] = _remote_command(vin, api::API_EV_CHARGE_NOW, api::API_REMOTE_SVC_STATUS)->result().get();
       return success;
-    });
+    }));
   }
 
   std::future<bool> Controller::lock(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      nlohmann::json form_data = {{"forceKeyInCar", false}};
-      auto [success, _] = _actuate(vin, api::API_LOCK, form_data).get();
-      return success;
-    });
+    return std::async(std::launch::async, traced("Controller::lock", [this, vin]() {
+      return lock_command(vin).wait();
+    }));
   }
 
   std::future<bool> Controller::unlock(const std::string& vin, const std::string& door) {
-    return std::async(std::launch::async, [this, vin, door]() {
-      if (std::find(door::VALID_DOORS.begin(), door::VALID_DOORS.end(), door) != door::VALID_DOORS.end()) {
-        nlohmann::json form_data = {{door::WHICH_DOOR, door}};
-        auto [success, _] = _actuate(vin, api::API_UNLOCK, form_data).get();
-        return success;
-      }
-      throw SubaruException("Invalid door specified for unlock command");
-    });
+    return std::async(std::launch::async, traced("Controller::unlock", [this, vin, door]() {
+      return unlock_command(vin, door).wait();
+    }));
   }
 
   std::future<bool> Controller::lights(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      std::string poll_url = api::API_REMOTE_SVC_STATUS;
-      if (get_api_gen(vin) == api::API_FEATURE_G1_TELEMATICS) {
-        poll_url = api::API_G1_HORN_LIGHTS_STATUS;
-      }
-      auto [success, _] = _actuate(vin, api::API_LIGHTS, nlohmann::json(), poll_url).get();
-      return success;
-    });
+    return std::async(std::launch::async, traced("Controller::lights", [this, vin]() {
+      return lights_command(vin).wait();
+    }));
   }
 
   std::future<bool> Controller::lights_stop(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      std::string poll_url = api::API_REMOTE_SVC_STATUS;
-      if (get_api_gen(vin) == api::API_FEATURE_G1_TELEMATICS) {
-        poll_url = api::API_G1_HORN_LIGHTS_STATUS;
+    return std::async(std::launch::async, traced("Controller::lights_stop", [this, vin]() {
+      auto [success, _] = _actuate(vin, api::API_LIGHTS_STOP, nlohmann::json(),
+                                   _horn_lights_poll_url(vin))->result().get();
+      return success;
+    }));
+  }
+
+  std::future<bool> Controller::horn(const std::string& vin) {
+    return std::async(std::launch::async, traced("Controller::horn", [this, vin]() {
+      return horn_command(vin).wait();
+    }));
+  }
+
+  std::future<bool> Controller::horn_stop(const std::string& vin) {
+    return std::async(std::launch::async, traced("Controller::horn_stop", [this, vin]() {
+      auto [success, _] = _actuate(vin, api::API_HORN_LIGHTS_STOP, nlohmann::json(),
+                                   _horn_lights_poll_url(vin))->result().get();
+      return success;
+    }));
+  }
+
+  std::future<bool> Controller::remote_stop(const std::string& vin) {
+    return std::async(std::launch::async, traced("Controller::remote_stop", [this, vin]() {
+      if (!get_res_status(vin) && !get_ev_status(vin)) {
+        throw VehicleNotSupported("Remote Start not supported for this vehicle");
       }
-      auto [success, _] = _actuate(vin, api::API_LIGHTS_STOP, nlohmann::json(), poll_url).get();
+      auto [success, _] = _actuate(vin, api::API_G2_REMOTE_ENGINE_STOP)->result().get();
       return success;
-    });
+    }));
+  }
+
+  std::future<bool> Controller::remote_start(const std::string& vin, const std::string& preset_name) {
+    return std::async(std::launch::async, traced("Controller::remote_start", [this, vin, preset_name]() {
+      return remote_start_command(vin, preset_name).wait();
+    }));
+  }
+
+  // Remote Command Handles
+  CommandHandle Controller::lock_command(const std::string& vin) {
+    nlohmann::json form_data = {{"forceKeyInCar", false}};
+    return _handle(_actuate(vin, api::API_LOCK, form_data));
+  }
+
+  CommandHandle Controller::unlock_command(const std::string& vin, const std::string& door) {
+    if (std::find(door::VALID_DOORS.begin(), door::VALID_DOORS.end(), door) == door::VALID_DOORS.end()) {
+      throw SubaruException("Invalid door specified for unlock command");
+    }
+    nlohmann::json form_data = {{door::WHICH_DOOR, door}};
+    return _handle(_actuate(vin, api::API_UNLOCK, form_data));
+  }
+
+  CommandHandle Controller::lights_command(const std::string& vin) {
+    return _handle(_actuate(vin, api::API_LIGHTS, nlohmann::json(), _horn_lights_poll_url(vin)));
+  }
+
+  CommandHandle Controller::horn_command(const std::string& vin) {
+    return _handle(_actuate(vin, api::API_HORN_LIGHTS, nlohmann::json(), _horn_lights_poll_url(vin)));
+  }
+
+  CommandHandle Controller::remote_start_command(const std::string& vin, const std::string& preset_name) {
+    if (!_validate_remote_capability(vin)) {
+      throw VehicleNotSupported("Remote start capability not available");
+    }
+
+    auto preset = _find_climate_preset(vin, preset_name);
+    if (!preset) {
+      throw SubaruException("Climate preset '" + preset_name + "' not found");
+    }
+
+    // Save the quick start setting only when this start is next, so an earlier queued start keeps its preset
+    auto preset_data = preset->to_json();
+    return _handle(_actuate(vin, api::API_G2_REMOTE_ENGINE_START, preset_data, api::API_REMOTE_SVC_STATUS,
+                            [this, preset_data]() { _sync_quick_start_settings(preset_data); }));
+  }
+
+  // Fleet Methods
+  std::future<BulkResult> Controller::bulk_lock(const std::vector<std::string>& vins, const BulkOptions& options) {
+    return std::async(std::launch::async, traced("Controller::bulk_lock", [this, vins, options]() {
+      return run_bulk(vins, [this](const std::string& vin) { return lock(vin).get(); }, options);
+    }));
+  }
+
+  std::future<BulkResult> Controller::bulk_unlock(const std::vector<std::string>& vins,
+                                                  const std::string& door,
+                                                  const BulkOptions& options) {
+    return std::async(std::launch::async, traced("Controller::bulk_unlock", [this, vins, door, options]() {
+      return run_bulk(vins, [this, &door](const std::string& vin) { return unlock(vin, door).get(); }, options);
+    }));
+  }
+
+  std::future<BulkResult> Controller::bulk_lights(const std::vector<std::string>& vins, const BulkOptions& options) {
+    return std::async(std::launch::async, traced("Controller::bulk_lights", [this, vins, options]() {
+      return run_bulk(vins, [this](const std::string& vin) { return lights(vin).get(); }, options);
+    }));
+  }
+
+  std::future<BulkResult> Controller::bulk_update(const std::vector<std::string>& vins,
+                                                  bool force,
+                                                  const BulkOptions& options) {
+    return std::async(std::launch::async, traced("Controller::bulk_update", [this, vins, force, options]() {
+      return run_bulk(vins, [this, force](const std::string& vin) {
+        if (update(vin, force).get()) {
+          return BulkStatus::SUCCEEDED;
+        }
+        // Without force, update also returns false when the location is fresh and nothing was sent
+        return !force && _location_fresh(vin) ? BulkStatus::SKIPPED : BulkStatus::FAILED;
+      }, options);
+    }));
+  }
+
+  std::future<BulkResult> Controller::bulk_fetch(const std::vector<std::string>& vins,
+                                                 FetchGroup groups,
+                                                 bool force,
+                                                 const BulkOptions& options) {
+    return std::async(std::launch::async, traced("Controller::bulk_fetch", [this, vins, groups, force, options]() {
+      return run_bulk(vins, [this, groups, force](const std::string& vin) {
+        if (fetch(vin, groups, force).get()) {
+          return BulkStatus::SUCCEEDED;
+        }
+        // Without force, fetch also returns false when every group is fresh and nothing was sent
+        return !force && _groups_fresh(vin, groups) ? BulkStatus::SKIPPED : BulkStatus::FAILED;
+      }, options);
+    }));
+  }
+
+  bool Controller::_location_fresh(const std::string& vin) const {
+    std::string upper_vin = vin;
+    std::transform(upper_vin.begin(), upper_vin.end(), upper_vin.begin(), ::toupper);
+    auto mutex = _vehicle_mutex.find(upper_vin);
+    if (mutex == _vehicle_mutex.end()) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(*mutex->second);
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now() - _vehicles.at(upper_vin).last_update);
+    return elapsed.count() <= _update_interval;
+  }
+
+  bool Controller::_groups_fresh(const std::string& vin, FetchGroup groups) const {
+    std::string upper_vin = vin;
+    std::transform(upper_vin.begin(), upper_vin.end(), upper_vin.begin(), ::toupper);
+    auto mutex = _vehicle_mutex.find(upper_vin);
+    if (mutex == _vehicle_mutex.end()) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(*mutex->second);
+    return _stale_groups(upper_vin, groups & _available_groups(upper_vin), std::chrono::system_clock::now(),
+                         false) == FetchGroup::NONE;
+  }
+
+  // Fleet Location
+  std::vector<std::string> Controller::get_vehicles_within(const GeoPoint& center, double radius_m) const {
+    return _spatial_index.within_radius(center, radius_m);
+  }
+
+  std::vector<std::string> Controller::get_vehicles_in_box(const GeoPoint& south_west,
+                                                           const GeoPoint& north_east) const {
+    return _spatial_index.within_box(south_west, north_east);
+  }
+
+  std::vector<std::string> Controller::get_vehicles_in_polygon(const std::vector<GeoPoint>& vertices) const {
+    return _spatial_index.within_polygon(vertices);
+  }
+
+  void Controller::add_geofence(const Geofence& fence) {
+    _spatial_index.add_fence(fence);
+  }
+
+  bool Controller::remove_geofence(const std::string& id) {
+    return _spatial_index.remove_fence(id);
+  }
+
+  std::vector<Geofence> Controller::get_geofences() const {
+    return _spatial_index.fences();
+  }
+
+  std::vector<std::string> Controller::get_vehicles_in_geofence(const std::string& id) const {
+    return _spatial_index.members(id);
+  }
+
+  std::vector<std::string> Controller::get_geofences_containing(const std::string& vin) const {
+    return _spatial_index.fences_containing(vin);
+  }
+
+  void Controller::set_location_history(bool enabled, size_t max_samples) {
+    _location_history.set_max_samples(max_samples);
+    _record_locations = enabled;
+  }
+
+  bool Controller::get_location_history() const {
+    return _record_locations;
+  }
+
+  std::vector<LocationSample> Controller::get_location_trace(const std::string& vin,
+                                                             std::chrono::system_clock::time_point from,
+                                                             std::chrono::system_clock::time_point to) const {
+    return _location_history.range(vin, from, to);
+  }
+
+  std::optional<ChargeSession> Controller::get_charge_session(const std::string& vin) const {
+    return _charge_tracker.session(vin);
+  }
+
+  void Controller::set_field_history(bool enabled, const std::string& directory,
+                                     const TimeSeriesRetention& retention) {
+    std::shared_ptr<TimeSeriesStore> released;
+    std::lock_guard<std::mutex> lock(_field_history_mutex);
+    if (!enabled) {
+      released = std::move(_field_history);
+      return;
+    }
+    if (!_field_history || _field_history->directory() != directory) {
+      released = std::move(_field_history);
+      _field_history = std::make_shared<TimeSeriesStore>(directory);
+    }
+    _field_history->set_retention(retention);
+  }
+
+  bool Controller::get_field_history() const {
+    std::lock_guard<std::mutex> lock(_field_history_mutex);
+    return _field_history != nullptr;
+  }
+
+  std::vector<TimeSeriesPoint> Controller::get_field_series(const std::string& vin, const std::string& field,
+                                                            std::chrono::system_clock::time_point from,
+                                                            std::chrono::system_clock::time_point to) const {
+    std::shared_ptr<TimeSeriesStore> store;
+    {
+      std::lock_guard<std::mutex> lock(_field_history_mutex);
+      store = _field_history;
+    }
+    return store ? store->range(vin, field, from, to) : std::vector<TimeSeriesPoint>{};
+  }
+
+  std::vector<TimeSeriesBucket> Controller::get_field_buckets(const std::string& vin, const std::string& field,
+                                                              std::chrono::system_clock::time_point from,
+                                                              std::chrono::system_clock::time_point to,
+                                                              std::chrono::seconds width) const {
+    std::shared_ptr<TimeSeriesStore> store;
+    {
+      std::lock_guard<std::mutex> lock(_field_history_mutex);
+      store = _field_history;
+    }
+    return store ? store->downsample(vin, field, from, to, width) : std::vector<TimeSeriesBucket>{};
   }
 
-  std::future<bool> Controller::horn(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      std::string poll_url = api::API_REMOTE_SVC_STATUS;
-      if (get_api_gen(vin) == api::API_FEATURE_G1_TELEMATICS) {
-        poll_url = api::API_G1_HORN_LIGHTS_STATUS;
-      }
-      auto [success, _] = _actuate(vin, api::API_HORN_LIGHTS, nlohmann::json(), poll_url).get();
-      return success;
-    });
+  void Controller::flush_field_history() {
+    std::shared_ptr<TimeSeriesStore> store;
+    {
+      std::lock_guard<std::mutex> lock(_field_history_mutex);
+      store = _field_history;
+    }
+    if (store) {
+      store->flush();
+    }
   }
 
-  std::future<bool> Controller::horn_stop(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      std::string poll_url = api::API_REMOTE_SVC_STATUS;
-      if (get_api_gen(vin) == api::API_FEATURE_G1_TELEMATICS) {
-        poll_url = api::API_G1_HORN_LIGHTS_STATUS;
-      }
-      auto [success, _] = _actuate(vin, api::API_HORN_LIGHTS_STOP, nlohmann::json(), poll_url).get();
-      return success;
-    });
+  // Metrics
+  MetricsSnapshot Controller::metrics() const {
+    return Metrics::instance().snapshot();
   }
 
-  std::future<bool> Controller::remote_stop(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      if (!get_res_status(vin) && !get_ev_status(vin)) {
-        throw VehicleNotSupported("Remote Start not supported for this vehicle");
-      }
-      auto [success, _] = _actuate(vin, api::API_G2_REMOTE_ENGINE_STOP).get();
-      return success;
-    });
+  bool Controller::write_metrics(const std::string& path) const {
+    return Metrics::instance().write_prometheus(path);
   }
 
-  std::future<bool> Controller::remote_start(const std::string& vin, const std::string& preset_name) {
-    return std::async(std::launch::async, [this, vin, preset_name]() {
-      if (!_validate_remote_capability(vin)) {
-        throw VehicleNotSupported("Remote start capability not available");
-      }
+  // Tracing
+  void Controller::set_tracing(bool enabled) {
+    Tracer::instance().set_enabled(enabled);
+  }
 
-      auto preset_data = get_climate_preset_by_name(vin, preset_name).get();
-      if (!preset_data.is_null()) {
-        auto response = _post(api::API_G2_SAVE_RES_QUICK_START_SETTINGS, {}, preset_data).get();
-        if (response["success"].get<bool>()) {
-          auto [success, _] = _actuate(vin, api::API_G2_REMOTE_ENGINE_START, preset_data).get();
-          return success;
-        }
-        throw SubaruException("Failed to save climate preset settings");
-      }
-      throw SubaruException("Climate preset '" + preset_name + "' not found");
-    });
+  bool Controller::write_trace(const std::string& path, uint64_t trace_id) const {
+    return Tracer::instance().write_chrome_trace(path, trace_id);
   }
 
   // PIN Management
@@ -686,7 +1476,8 @@ namespace subarulink {
   }
 
   void Controller::_check_error_code(const nlohmann::json& js_resp) {
-    if (js_resp.contains("errorCode")) {
+    // Successful responses carry "errorCode": null
+    if (js_resp.contains("errorCode") && js_resp["errorCode"].is_string()) {
       std::string error = js_resp["errorCode"].get<std::string>();
 
       if (error == api::API_ERROR_INVALID_CREDENTIALS ||
@@ -707,6 +1498,22 @@ namespace subarulink {
   void Controller::_parse_vehicle(const nlohmann::json& vehicle) {
     std::string vin = vehicle["vin"].get<std::string>();
     _vehicle_mutex.emplace(vin, std::make_unique<std::mutex>());
+    _strands.emplace(vin, std::make_unique<Strand>());
+    _command_queues.emplace(vin, std::make_unique<CommandQueue>(
+        [this](const std::shared_ptr<RemoteCommand>& command) {
+          try {
+            return _run_remote_command(command);
+          } catch (...) {
+            _publish_command_state(*command, RemoteCommandState::FAILED);
+            throw;
+          }
+        },
+        command_rules(),
+        [this](const std::shared_ptr<RemoteCommand>& command, RemoteCommandState state) {
+          SUBARULINK_LOG_DEBUG("Settled queued ", command->command(), " for ", command->vin(), " without sending it");
+          _publish_command_state(*command, state);
+        }));
+    _change_logs.emplace(vin, ChangeLog());
     _raw_api_data[vin] = {{"switchVehicle", vehicle}};
 
     VehicleInfo info;
@@ -737,6 +1544,10 @@ namespace subarulink {
       status[vehicle_fields::TIMESTAMP] = data[api::API_TIMESTAMP].get<std::string>();
     }
 
+    if (data.find(api::API_VEHICLE_STATE) != data.end() && data[api::API_VEHICLE_STATE].is_string()) {
+      status[vehicle_fields::VEHICLE_STATE] = data[api::API_VEHICLE_STATE].get<std::string>();
+    }
+
     // Optional values - keep old if present
     if (data.find(api::API_AVG_FUEL_CONSUMPTION) != data.end() &&
         !data[api::API_AVG_FUEL_CONSUMPTION].is_null()) {
@@ -806,7 +1617,7 @@ namespace subarulink {
   }
 
   std::future<nlohmann::json> Controller::_parse_condition(const nlohmann::json& js_resp, const std::string& vin) {
-    return std::async(std::launch::async, [this, js_resp, vin]() {
+    return std::async(std::launch::async, traced("Controller::_parse_condition", [this, js_resp, vin]() {
       nlohmann::json keep_data;
       auto data = js_resp["data"]["result"];
 
@@ -830,9 +1641,8 @@ namespace subarulink {
         keep_data["LAST_UPDATED_DATE"] = data[api::API_LAST_UPDATED_DATE].get<std::string>();
       }
 
-      // Handle window status
-      auto has_power_windows_future = has_power_windows(vin);
-      if (has_power_windows_future.get()) {
+      // Handle window status; this runs on the vehicle's strand, so it must not fetch
+      if (_has_power_windows(vin)) {
         for (const auto& [key, value] : {
             std::make_pair("WINDOW_FRONT_LEFT_STATUS", api::API_WINDOW_FRONT_LEFT_STATUS),
             std::make_pair("WINDOW_FRONT_RIGHT_STATUS", api::API_WINDOW_FRONT_RIGHT_STATUS),
@@ -854,138 +1664,284 @@ namespace subarulink {
 
       // Handle EV specific values
       if (get_ev_status(vin)) {
-        if (data.find(api::API_EV_DISTANCE_TO_EMPTY) != data.end() &&
-            !data[api::API_EV_DISTANCE_TO_EMPTY].is_null()) {
-          if (data[api::API_EV_DISTANCE_TO_EMPTY].is_string()) {
-            keep_data["EV_DISTANCE_TO_EMPTY"] =
-                std::stoi(data[api::API_EV_DISTANCE_TO_EMPTY].get<std::string>());
-          } else {
-            keep_data["EV_DISTANCE_TO_EMPTY"] =
-                data[api::API_EV_DISTANCE_TO_EMPTY].get<int>();
+        // Numbers arrive as JSON numbers or strings depending on the telematics generation
+        auto number = [&data](const std::string& key) -> std::optional<double> {
+          if (data.find(key) == data.end() || data[key].is_null()) {
+            return std::nullopt;
+          }
+          if (data[key].is_string()) {
+            try {
+              return std::stod(data[key].get<std::string>());
+            } catch (const std::exception&) {
+              return std::nullopt;
+            }
+          }
+          return data[key].get<double>();
+        };
+
+        if (auto distance = number(api::API_EV_DISTANCE_TO_EMPTY)) {
+          keep_data[vehicle_fields::EV_DISTANCE_TO_EMPTY] = static_cast<int>(*distance);
+        }
+        if (auto percent = number(api::API_EV_STATE_OF_CHARGE_PERCENT)) {
+          keep_data[vehicle_fields::EV_STATE_OF_CHARGE_PERCENT] = *percent;
+        }
+        auto minutes = number(api::API_EV_TIME_TO_FULLY_CHARGED);
+        if (minutes && std::to_string(static_cast<int>(*minutes)) != error_values::BAD_EV_TIME_TO_FULLY_CHARGED) {
+          keep_data[vehicle_fields::EV_TIME_TO_FULLY_CHARGED] = static_cast<int>(*minutes);
+        }
+
+        for (const auto& [key, value] : {
+            std::make_pair(vehicle_fields::EV_IS_PLUGGED_IN, api::API_EV_IS_PLUGGED_IN),
+            std::make_pair(vehicle_fields::EV_CHARGER_STATE_TYPE, api::API_EV_CHARGER_STATE_TYPE),
+            std::make_pair(vehicle_fields::EV_STATE_OF_CHARGE_MODE, api::API_EV_STATE_OF_CHARGE_MODE),
+            std::make_pair(vehicle_fields::EV_TIME_TO_FULLY_CHARGED_UTC, api::API_EV_TIME_TO_FULLY_CHARGED_UTC)
+        }) {
+          if (data.find(value) != data.end() && data[value].is_string() &&
+              !data[value].get<std::string>().empty()) {
+            keep_data[key] = data[value].get<std::string>();
           }
         }
       }
 
       // Add debug output
-      std::cout << "Debug: Parsed condition data: " << keep_data.dump(2) << std::endl;
+      SUBARULINK_LOG_TRACE("Parsed condition data: ", redact(keep_data, 2));
 
       return keep_data;
-    });
+    }));
   }
 
-  std::future<bool> Controller::_fetch_climate_presets(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      if (get_res_status(vin) || get_ev_status(vin)) {
-        std::vector<nlohmann::json> presets;
-
-        // Fetch STARLINK Presets
-        auto js_resp = _post(api::API_G2_FETCH_RES_SUBARU_PRESETS).get();
-        _raw_api_data[vin]["climatePresetSettings"] = js_resp;
+  std::future<bool> Controller::_fetch_climate_presets(const std::string& vin, bool force) {
+    return std::async(std::launch::async, traced("Controller::_fetch_climate_presets", [this, vin, force]() {
+      if (!get_res_status(vin) && !get_ev_status(vin)) {
+        throw VehicleNotSupported("Active STARLINK Security Plus subscription required.");
+      }
 
-        if (js_resp.contains("data")) {
-          for (const auto& preset : js_resp["data"]) {
-            auto preset_data = nlohmann::json::parse(preset.get<std::string>());
-            if (get_ev_status(vin) && preset_data["vehicleType"] == "phev") {
-              presets.push_back(preset_data);
-            } else if (!get_ev_status(vin) && preset_data["vehicleType"] == "gas") {
-              presets.push_back(preset_data);
-            }
+      // Presets are account-level, so one load serves every vehicle until it expires. Concurrent callers
+      // join the load in flight; a forced one only joins a load sent after it was asked for.
+      auto requested = std::chrono::steady_clock::now();
+      for (;;) {
+        std::shared_future<void> pending;
+        bool fresh_enough = false;
+        std::promise<void> loaded;
+        {
+          std::lock_guard<std::mutex> lock(_preset_mutex);
+          bool expired = std::chrono::duration_cast<std::chrono::seconds>(
+              std::chrono::system_clock::now() - _preset_cache.fetched_at).count() > _preset_interval;
+
+          if (_preset_load.valid()) {
+            pending = _preset_load;
+            fresh_enough = !force || _preset_load_started >= requested;
+          } else if (!force && _preset_cache.valid && !expired) {
+            _apply_climate_presets(vin);
+            return true;
+          } else {
+            _preset_load = loaded.get_future().share();
+            _preset_load_started = std::chrono::steady_clock::now();
           }
         }
 
-        // Fetch User Defined Presets
-        js_resp = _post(api::API_G2_FETCH_RES_USER_PRESETS).get();
-        _raw_api_data[vin]["remoteEngineStartSettings"] = js_resp;
+        if (pending.valid()) {
+          pending.get();
+          if (fresh_enough) {
+            std::lock_guard<std::mutex> lock(_preset_mutex);
+            _apply_climate_presets(vin);
+            return true;
+          }
+          continue;
+        }
 
-        if (js_resp.contains("data") && js_resp["data"].is_string()) {
-          auto user_presets = nlohmann::json::parse(js_resp["data"].get<std::string>());
-          for (const auto& preset : user_presets) {
-            presets.push_back(preset);
+        PresetCache cache;
+        try {
+          cache = _download_climate_presets();
+        } catch (...) {
+          {
+            std::lock_guard<std::mutex> lock(_preset_mutex);
+            _preset_load = {};
           }
+          loaded.set_exception(std::current_exception());
+          throw;
         }
 
-        _vehicles[vin].climate = presets;
+        {
+          std::lock_guard<std::mutex> lock(_preset_mutex);
+          // The quick start hash is learned by remote starts, not by refreshes, so it outlives a preset reload
+          cache.quick_start_hash = _preset_cache.quick_start_hash;
+          cache.quick_start_at = _preset_cache.quick_start_at;
+          _preset_cache = std::move(cache);
+          _preset_load = {};
+
+          // Keep every vehicle that already holds presets in step with the new account data
+          for (const auto& entry : _vehicles) {
+            const auto& other_vin = entry.first;
+            bool holds_presets;
+            {
+              std::lock_guard<std::mutex> vehicle_lock(*_vehicle_mutex.at(other_vin));
+              holds_presets = !entry.second.climate.empty();
+            }
+            if (other_vin == vin || holds_presets) {
+              _apply_climate_presets(other_vin);
+            }
+          }
+        }
+        loaded.set_value();
         return true;
       }
-      throw VehicleNotSupported("Active STARLINK Security Plus subscription required.");
-    });
+    }));
   }
 
-  std::future<std::tuple<bool, nlohmann::json>> Controller::_actuate(
-      const std::string& vin,
-      const std::string& cmd,
-      const nlohmann::json& data,
-      const std::string& poll_url) {
+  Controller::PresetCache Controller::_download_climate_presets() {
+    auto current_time = std::chrono::system_clock::now();
+    PresetCache cache;
 
-    return std::async(std::launch::async, [this, vin, cmd, data, poll_url]() {
-      nlohmann::json form_data = {
-          {"delay", 0},
-          {"vin", vin}
-      };
+    // Fetch STARLINK Presets
+    cache.raw_subaru_presets = _post(api::API_G2_FETCH_RES_SUBARU_PRESETS).get();
 
-      if (!data.is_null()) {
-        form_data.update(data);
+    if (cache.raw_subaru_presets.contains("data")) {
+      for (const auto& preset : cache.raw_subaru_presets["data"]) {
+        auto decoded = ClimatePreset::from_json(nlohmann::json::parse(preset.get<std::string>()));
+        if (decoded.vehicle_type == ClimatePreset::VehicleType::PHEV) {
+          cache.phev_presets.push_back(std::move(decoded));
+        } else if (decoded.vehicle_type == ClimatePreset::VehicleType::GAS) {
+          cache.gas_presets.push_back(std::move(decoded));
+        }
       }
+    }
+
+    // Fetch User Defined Presets
+    cache.raw_user_presets = _post(api::API_G2_FETCH_RES_USER_PRESETS).get();
 
-      if (get_remote_status(vin)) {
-        return _remote_command(vin, cmd, poll_url, form_data).get();
+    if (cache.raw_user_presets.contains("data") && cache.raw_user_presets["data"].is_string()) {
+      auto user_presets = nlohmann::json::parse(cache.raw_user_presets["data"].get<std::string>());
+      for (const auto& preset : user_presets) {
+        cache.user_presets.push_back(ClimatePreset::from_json(preset));
       }
-      throw VehicleNotSupported("Active STARLINK Security Plus subscription required.");
-    });
+    }
+
+    cache.fetched_at = current_time;
+    cache.valid = true;
+    return cache;
   }
 
-  bool Controller::_validate_remote_start_params(const std::string& vin, const nlohmann::json& preset_data) {
-    bool is_valid = true;
-    std::string err_msg;
-    nlohmann::json data_copy = preset_data;  // Create a mutable copy
+  void Controller::_apply_climate_presets(const std::string& vin) {
+    const auto& starlink_presets = get_ev_status(vin) ? _preset_cache.phev_presets : _preset_cache.gas_presets;
 
-    try {
-      // Validate each preset parameter against valid options
-      for (const auto& [key, value] : preset_data.items()) {
-        if (key == climate_control::PRESET_NAME && value.is_string()) {
-          continue;
-        }
+    std::vector<ClimatePreset> presets;
+    presets.reserve(starlink_presets.size() + _preset_cache.user_presets.size());
+    presets.insert(presets.end(), starlink_presets.begin(), starlink_presets.end());
+    presets.insert(presets.end(), _preset_cache.user_presets.begin(), _preset_cache.user_presets.end());
 
-        auto it = climate_control::VALID_CLIMATE_OPTIONS.find(key);
-        if (it != climate_control::VALID_CLIMATE_OPTIONS.end()) {
-          if (std::find(it->second.begin(), it->second.end(), value.get<std::string>()) == it->second.end()) {
-            is_valid = false;
-            err_msg = "Invalid value for " + key + ": " + value.dump();
-            break;
-          }
-        }
+    std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+    _vehicles.at(vin).climate = std::move(presets);
+    _raw_api_data.at(vin)["climatePresetSettings"] = _preset_cache.raw_subaru_presets;
+    _raw_api_data.at(vin)["remoteEngineStartSettings"] = _preset_cache.raw_user_presets;
+  }
+
+  void Controller::_sync_quick_start_settings(const nlohmann::json& preset_data) {
+    auto hash = quick_start_hash(preset_data);
+    std::optional<size_t> known;
+    {
+      // Trust the known hash only as long as the preset cache, since the app can change the settings too
+      std::lock_guard<std::mutex> lock(_preset_mutex);
+      auto age = std::chrono::duration_cast<std::chrono::seconds>(
+          std::chrono::system_clock::now() - _preset_cache.quick_start_at).count();
+      if (age <= _preset_interval) {
+        known = _preset_cache.quick_start_hash;
+      }
+    }
+
+    // Learn what the server holds only when no start has told us lately; a refresh never pays for this
+    if (!known) {
+      try {
+        known = fetched_quick_start_hash(_post(api::API_G2_FETCH_RES_QUICK_START_SETTINGS).get());
+      } catch (const SubaruException& e) {
+        SUBARULINK_LOG_WARN("Quick start settings fetch failed, saving anyway: ", e.what());
+      }
+      if (known) {
+        std::lock_guard<std::mutex> lock(_preset_mutex);
+        _preset_cache.quick_start_hash = known;
+        _preset_cache.quick_start_at = std::chrono::system_clock::now();
       }
-    } catch (const std::exception& e) {
-      is_valid = false;
-      err_msg = std::string("Invalid option: ") + e.what();
     }
+    if (known == hash) {
+      SUBARULINK_LOG_DEBUG("Quick start settings unchanged, skipping save");
+      return;
+    }
+
+    auto response = _post(api::API_G2_SAVE_RES_QUICK_START_SETTINGS, {}, preset_data).get();
+    bool saved = response["success"].get<bool>();
 
-    if (!is_valid) {
-      throw SubaruException(err_msg);
+    std::lock_guard<std::mutex> lock(_preset_mutex);
+    _preset_cache.quick_start_hash = saved ? std::optional<size_t>(hash) : std::nullopt;
+    _preset_cache.quick_start_at = std::chrono::system_clock::now();
+    if (!saved) {
+      throw SubaruException("Failed to save climate preset settings");
     }
+  }
 
-    // Update config constants based on vehicle type
-    if (get_ev_status(vin)) {
-      for (const auto& [key, value] : climate_control::START_CONFIG_CONSTS_EV) {
-        data_copy[key] = value;  // Modify the copy instead
-      }
-    } else {
-      for (const auto& [key, value] : climate_control::START_CONFIG_CONSTS_RES) {
-        data_copy[key] = value;  // Modify the copy instead
+  std::shared_ptr<RemoteCommand> Controller::_actuate(
+      const std::string& vin,
+      const std::string& cmd,
+      const nlohmann::json& data,
+      const std::string& poll_url,
+      std::function<void()> prepare) {
+    nlohmann::json form_data = {
+        {"delay", 0},
+        {"vin", vin}
+    };
+
+    if (!data.is_null()) {
+      form_data.update(data);
+    }
+
+    if (get_remote_status(vin)) {
+      return _remote_command(vin, cmd, poll_url, form_data, std::move(prepare));
+    }
+    throw VehicleNotSupported("Active STARLINK Security Plus subscription required.");
+  }
+
+  std::string Controller::_horn_lights_poll_url(const std::string& vin) const {
+    if (get_api_gen(vin) == api::API_FEATURE_G1_TELEMATICS) {
+      return api::API_G1_HORN_LIGHTS_STATUS;
+    }
+    return api::API_REMOTE_SVC_STATUS;
+  }
+
+  std::optional<ClimatePreset> Controller::_find_climate_preset(const std::string& vin,
+                                                               const std::string& preset_name) const {
+    auto it = _vehicles.find(vin);
+    if (it == _vehicles.end()) {
+      throw SubaruException("Invalid VIN");
+    }
+    for (const auto& preset : it->second.climate) {
+      if (preset.name == preset_name) {
+        return preset;
       }
     }
+    return std::nullopt;
+  }
+
+  bool Controller::_validate_remote_start_params(const std::string& vin, ClimatePreset& preset) {
+    // Validate each preset parameter against the precomputed allowed-value bitsets
+    preset.validate();
+
+    // Update config constants based on vehicle type
+    const auto& config_consts = get_ev_status(vin) ? climate_control::START_CONFIG_CONSTS_EV
+                                                   : climate_control::START_CONFIG_CONSTS_RES;
+    for (const auto& [key, value] : config_consts) {
+      preset.assign(key, value);
+    }
 
-    return is_valid;
+    return true;
   }
 
-  std::future<nlohmann::json> Controller::_remote_query(const std::string& vin, const std::string& cmd) {
-    return std::async(std::launch::async, [this, vin, cmd]() {
+  std::future<nlohmann::json> Controller::_remote_query(const std::string& vin, const std::string& cmd,
+                                                       bool session_validated) {
+    return std::async(std::launch::async, traced("Controller::_remote_query", [this, vin, cmd, session_validated]() {
       int tries_left = 2;
       nlohmann::json js_resp;
+      bool validate = !session_validated;
 
       while (tries_left > 0) {
-        _connection->validate_session(vin).get();
-
         // Get API generation
         std::string api_gen = get_api_gen(vin);
         if (api_gen == api::API_FEATURE_G1_TELEMATICS) {
@@ -994,38 +1950,46 @@ namespace subarulink {
           api_gen = "g2";  // G3 uses G2 API for now
         }
 
-        {
-          std::lock_guard<std::mutex> lock(*_vehicle_mutex[vin]);
-
-          // Create the modified command properly
-          std::string modified_cmd = cmd;
-          size_t pos = modified_cmd.find("api_gen");
-          if (pos != std::string::npos) {
-            modified_cmd.replace(pos, 7, api_gen); // 7 is length of "api_gen"
-          }
+        // Create the modified command properly
+        std::string modified_cmd = cmd;
+        size_t pos = modified_cmd.find("api_gen");
+        if (pos != std::string::npos) {
+          modified_cmd.replace(pos, 7, api_gen); // 7 is length of "api_gen"
+        }
 
-          std::cout << "Debug: Making remote query to: " << modified_cmd << std::endl;
+        SUBARULINK_LOG_DEBUG("Making remote query to: ", modified_cmd);
 
+        {
+          Connection::VehicleLane lane(*_connection, vin);
+          if (validate) {
+            _connection->validate_session(vin).get();
+          } else {
+            _connection->select_vehicle(vin).get();
+          }
           js_resp = _post(modified_cmd).get();
+        }
+        validate = true;
 
-          if (js_resp["success"].get<bool>()) {
-            return js_resp;
-          }
+        if (js_resp["success"].get<bool>()) {
+          return js_resp;
+        }
 
-          if (js_resp.find("errorCode") != js_resp.end() &&
-              js_resp["errorCode"] == api::API_ERROR_SOA_403) {
-            tries_left--;
-          } else {
-            tries_left = 0;
+        if (js_resp.find("errorCode") != js_resp.end() &&
+            js_resp["errorCode"] == api::API_ERROR_SOA_403) {
+          tries_left--;
+          if (tries_left > 0) {
+            Metrics::instance().count(MetricEvent::RETRY, "remote_query");
           }
+        } else {
+          tries_left = 0;
         }
       }
       throw SubaruException("Remote query failed. Response: " + js_resp.dump());
-    });
+    }));
   }
 
-  std::future<bool> Controller::_locate(const std::string& vin, bool hard_poll) {
-    return std::async(std::launch::async, [this, vin, hard_poll]() {
+  std::future<bool> Controller::_locate(const std::string& vin, bool hard_poll, bool session_validated) {
+    return std::async(std::launch::async, traced("Controller::_locate", [this, vin, hard_poll, session_validated]() {
       nlohmann::json js_resp;
       bool success = false;
 
@@ -1038,60 +2002,83 @@ namespace subarulink {
                                api::API_G1_LOCATE_STATUS : api::API_G2_LOCATE_STATUS;
 
         try {
-          std::cout << "Debug: Starting locate request..." << std::endl;
-          auto result = _remote_command(vin, locate_cmd, poll_url).get();
+          SUBARULINK_LOG_DEBUG("Starting locate request...");
+          auto result = _remote_command(vin, locate_cmd, poll_url)->result().get();
           success = std::get<0>(result);
           js_resp = std::get<1>(result);
 
           if (success && js_resp["success"].get<bool>()) {
             if (js_resp["data"].contains("result")) {
-              std::cout << "Debug: Processing locate result..." << std::endl;
-              _parse_location(vin, js_resp["data"]["result"]);
+              SUBARULINK_LOG_DEBUG("Processing locate result...");
+              std::vector<VehicleEvent> events;
+              {
+                std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+                events = _parse_location(vin, js_resp["data"]["result"]);
+              }
+              _publish(events);
+              return true;
             } else {
               // Initiate a regular locate query since the command only gave us status
-              std::cout << "Debug: No location data in response, fetching location..." << std::endl;
+              SUBARULINK_LOG_DEBUG("No location data in response, fetching location...");
               js_resp = _remote_query(vin, api::API_LOCATE).get();
-              _raw_api_data[vin]["locate"] = js_resp;
-              if (js_resp["success"].get<bool>() && js_resp["data"].contains("result")) {
-                _parse_location(vin, js_resp["data"]["result"]);
+              std::vector<VehicleEvent> events;
+              {
+                std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+                _raw_api_data.at(vin)["locate"] = js_resp;
+                if (js_resp["success"].get<bool>() && js_resp["data"].contains("result")) {
+                  events = _parse_location(vin, js_resp["data"]["result"]);
+                  success = true;
+                } else {
+                  success = false;
+                }
+              }
+              _publish(events);
+              if (success) {
                 return true;
               }
             }
           }
         } catch (const nlohmann::json::exception& e) {
-          std::cout << "Debug: JSON error in _locate: " << e.what() << std::endl;
-          std::cout << "Debug: Response was: " << js_resp.dump(2) << std::endl;
+          SUBARULINK_LOG_WARN("JSON error in _locate: ", e.what());
+          SUBARULINK_LOG_TRACE("Response was: ", redact(js_resp, 2));
           return false;
         }
       } else {
         // Get last reported location
         try {
-          js_resp = _remote_query(vin, api::API_LOCATE).get();
-          _raw_api_data[vin]["locate"] = js_resp;
-          if (js_resp["success"].get<bool>() && js_resp["data"].contains("result")) {
-            _parse_location(vin, js_resp["data"]["result"]);
+          js_resp = _remote_query(vin, api::API_LOCATE, session_validated).get();
+          std::vector<VehicleEvent> events;
+          bool parsed = false;
+          {
+            std::lock_guard<std::mutex> lock(*_vehicle_mutex.at(vin));
+            _raw_api_data.at(vin)["locate"] = js_resp;
+            if (js_resp["success"].get<bool>() && js_resp["data"].contains("result")) {
+              events = _parse_location(vin, js_resp["data"]["result"]);
+              parsed = true;
+            }
+          }
+          _publish(events);
+          if (parsed) {
             return true;
           }
         } catch (const nlohmann::json::exception& e) {
-          std::cout << "Debug: JSON error in _locate: " << e.what() << std::endl;
-          std::cout << "Debug: Response was: " << js_resp.dump(2) << std::endl;
+          SUBARULINK_LOG_WARN("JSON error in _locate: ", e.what());
+          SUBARULINK_LOG_TRACE("Response was: ", redact(js_resp, 2));
           return false;
         }
       }
 
       return false;
-    });
+    }));
   }
 
   std::future<std::tuple<bool, bool, nlohmann::json>> Controller::_execute_remote_command(
-      const std::string& vin,
-      const std::string& cmd,
-      const nlohmann::json& data,
-      const std::string& poll_url) {
+      const std::shared_ptr<RemoteCommand>& command) {
 
-    return std::async(std::launch::async, [this, vin, cmd, data, poll_url]() {
-      // G3 uses G2 API for now
-      std::string api_gen = (get_api_gen(vin) == api::API_FEATURE_G1_TELEMATICS) ? "g1" : "g2";
+    return std::async(std::launch::async, traced("Controller::_execute_remote_command", [this, command]() {
+      const auto& vin = command->vin();
+      const auto& cmd = command->command();
+      const auto& poll_url = command->poll_url();
 
       nlohmann::json form_data = {
           {"pin", _pin},
@@ -1099,85 +2086,236 @@ namespace subarulink {
           {"vin", vin}
       };
 
-      if (!data.is_null()) {
-        form_data.update(data);
+      if (!command->data().is_null()) {
+        form_data.update(command->data());
       }
 
-      // Create a local copy of cmd before modifying it
-      std::string modified_cmd = cmd;
-      modified_cmd.replace(modified_cmd.find("api_gen"), 7, api_gen);
-
-      auto js_resp = _post(modified_cmd, {}, form_data).get();
+      // Selection and execute must not interleave with another vehicle; status polls are keyed by
+      // serviceRequestId and run outside the lane
+      nlohmann::json js_resp;
+      {
+        Connection::VehicleLane lane(*_connection, vin);
+        _connection->validate_session(vin).get();
+        _publish_command_state(*command, RemoteCommandState::SENT);
+        js_resp = _post(_command_url(vin, cmd), {}, form_data).get();
+      }
 
       if (js_resp["errorCode"] == api::API_ERROR_SOA_403) {
+        _publish_command_state(*command, RemoteCommandState::QUEUED);
         return std::make_tuple(true, false, js_resp);
       }
 
       if (js_resp["errorCode"] == api::API_ERROR_G1_SERVICE_ALREADY_STARTED ||
           js_resp["errorCode"] == api::API_ERROR_SERVICE_ALREADY_STARTED) {
-        std::this_thread::sleep_for(std::chrono::seconds(10));
+        _publish_command_state(*command, RemoteCommandState::QUEUED);
+        // Another client's command is running; retry as soon as it finishes instead of guessing.
+        // A cancel ends the wait at once; the retry loop then sees it before sending again
+        auto running = js_resp.contains("data") && js_resp["data"].is_object()
+                       ? js_resp["data"].value(api::API_SERVICE_REQ_ID, "") : "";
+        if (!running.empty()) {
+          auto finished = _wait_request_status(vin, running, poll_url);
+          // Stops our polling of the other command only; that command keeps running
+          command->on_cancel([this, running]() { _status_poller.cancel(running); });
+          finished.wait();
+        } else {
+          std::promise<void> cancelled;
+          auto interrupted = cancelled.get_future();
+          command->on_cancel([&cancelled]() { cancelled.set_value(); });
+          interrupted.wait_for(std::chrono::seconds(10));
+        }
+        command->on_cancel(nullptr);
         return std::make_tuple(true, false, js_resp);
       }
 
       if (js_resp["success"].get<bool>()) {
         std::string req_id = js_resp["data"][api::API_SERVICE_REQ_ID];
-        auto [success, response] = _wait_request_status(vin, req_id, poll_url).get();
+        _publish_command_state(*command, RemoteCommandState::POLLING, req_id);
+
+        // Poll around this command's learned completion time on this telematics generation
+        auto profile_key = get_api_gen(vin) + " " + cmd;
+        auto sent_at = std::chrono::steady_clock::now();
+        auto outcome = _wait_request_status(vin, req_id, poll_url, _latency_profiles.schedule(profile_key));
+
+        // A cancel that arrived while the execute call was in flight could not see the serviceRequestId
+        if (command->cancel_requested()) {
+          _cancel_sent_command(command);
+        }
+
+        auto [success, response] = outcome.get();
+        // A reported SUCCESS or FAILED is a completion; a timeout or cancel only bounds it from below,
+        // and dropping those would bias the profile towards fast commands
+        bool completed = success || (response.contains("data") && response["data"].is_object() &&
+                                     response["data"].contains("remoteServiceState"));
+        _latency_profiles.record(profile_key, std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - sent_at), !completed);
+        if (success) {
+          _publish_command_state(*command, RemoteCommandState::SUCCEEDED, req_id);
+        } else {
+          _publish_command_state(*command, command->cancel_requested() ? RemoteCommandState::CANCELLED
+                                                                       : RemoteCommandState::FAILED, req_id);
+        }
         return std::make_tuple(false, success, response);
       }
 
+      _publish_command_state(*command, RemoteCommandState::FAILED);
       return std::make_tuple(false, false, js_resp);
-    });
+    }));
   }
 
-  std::future<std::tuple<bool, nlohmann::json>> Controller::_remote_command(
+  std::shared_ptr<RemoteCommand> Controller::_remote_command(
       const std::string& vin,
       const std::string& cmd,
       const std::string& poll_url,
-      const nlohmann::json& data) {
-    return std::async(std::launch::async, [this, vin, cmd, poll_url, data]() {
-      bool try_again = true;
-      while (try_again && !_pin_lockout) {
-        if (_connection->get_session_age() > MAX_SESSION_AGE_MINS) {
-          _connection->reset_session();
-        }
+      const nlohmann::json& data,
+      std::function<void()> prepare) {
+    auto queue = _command_queues.find(vin);
+    if (queue == _command_queues.end()) {
+      throw SubaruException("Invalid VIN");
+    }
 
-        _connection->validate_session(vin).get();
+    auto command = std::make_shared<RemoteCommand>(vin, cmd, poll_url, data, std::move(prepare));
+    _publish_command_state(*command, RemoteCommandState::QUEUED);
+    return queue->second->submit(command);
+  }
+
+  RemoteCommand::Result Controller::_run_remote_command(const std::shared_ptr<RemoteCommand>& command) {
+    // Runs on the vehicle's command queue, so continue the trace of the call that queued it
+    TraceSpan span("Controller::_run_remote_command", command->trace_context(), command->queued_at());
+    OperationTimer timer(command->command());
+    bool try_again = true;
+    bool first_attempt = true;
+    while (try_again && !_pin_lockout) {
+      // Cancelled before it was sent, or while waiting to retry
+      if (command->cancel_requested()) {
+        _publish_command_state(*command, RemoteCommandState::CANCELLED);
+        return std::make_tuple(false, nlohmann::json{{"success", false}, {"errorCode", RemoteCommand::CANCELLED}});
+      }
+
+      if (_connection->get_session_age() > MAX_SESSION_AGE_MINS) {
+        _connection->reset_session();
+      }
+      command->prepare();
+      if (!first_attempt) {
+        Metrics::instance().count(MetricEvent::RETRY, command->command());
+      }
+      first_attempt = false;
 
-        auto [again, success, response] = _execute_remote_command(vin, cmd, data, poll_url).get();
-        try_again = again;
+      auto [again, success, response] = _execute_remote_command(command).get();
+      try_again = again;
 
-        if (success) {
-          return std::make_tuple(true, response);
-        }
+      if (success) {
+        timer.set_success();
+        return std::make_tuple(true, response);
+      }
+      if (command->state() == RemoteCommandState::CANCELLED) {
+        return std::make_tuple(false, response);
+      }
+    }
+
+    if (_pin_lockout) {
+      throw PINLockoutProtect("Remote command cancelled to prevent account lockout");
+    }
+
+    throw SubaruException("Unexpected error in remote command");
+  }
+
+  void Controller::_cancel_sent_command(const std::shared_ptr<RemoteCommand>& command) {
+    if (!command->begin_server_cancel()) {
+      return;
+    }
+
+    // Release the waiting command and its poll traffic first; the server cancel is best effort
+    auto req_id = command->service_request_id();
+    _status_poller.cancel(req_id);
+
+    auto endpoint = CANCEL_ENDPOINTS.find(command->command());
+    if (endpoint == CANCEL_ENDPOINTS.end()) {
+      SUBARULINK_LOG_DEBUG("No cancel endpoint for ", command->command(), ", stopped polling only");
+      return;
+    }
+
+    nlohmann::json form_data = {
+        {"pin", _pin},
+        {"delay", 0},
+        {"vin", command->vin()},
+        {api::API_SERVICE_REQ_ID, req_id}
+    };
+
+    try {
+      Connection::VehicleLane lane(*_connection, command->vin());
+      _connection->validate_session(command->vin()).get();
+      auto js_resp = _post(_command_url(command->vin(), endpoint->second), {}, form_data).get();
+      SUBARULINK_LOG_TRACE("Cancel of ", req_id, " returned: ", redact(js_resp));
+    } catch (const std::exception& e) {
+      SUBARULINK_LOG_WARN("Cancel of ", req_id, " failed: ", e.what());
+    }
+  }
+
+  std::future<bool> Controller::_cancel_command(const std::shared_ptr<RemoteCommand>& command) {
+    return std::async(std::launch::async, traced("Controller::_cancel_command", [this, command]() {
+      if (!command->request_cancel()) {
+        return command->state() == RemoteCommandState::CANCELLED;
+      }
+
+      auto queue = _command_queues.find(command->vin());
+      if (queue != _command_queues.end() && queue->second->withdraw(command)) {
+        return true;
       }
 
-      if (_pin_lockout) {
-        throw PINLockoutProtect("Remote command cancelled to prevent account lockout");
+      // Sent commands are cancelled here once they have a serviceRequestId, or by the execute path otherwise
+      if (!command->service_request_id().empty()) {
+        _cancel_sent_command(command);
       }
 
-      throw SubaruException("Unexpected error in remote command");
+      command->result().wait();
+      return command->state() == RemoteCommandState::CANCELLED;
+    }));
+  }
+
+  CommandHandle Controller::_handle(std::shared_ptr<RemoteCommand> command) {
+    return CommandHandle(std::move(command), [this](const std::shared_ptr<RemoteCommand>& cancelled) {
+      return _cancel_command(cancelled);
     });
   }
 
-  std::future<nlohmann::json> Controller::_get_vehicle_status(const std::string& vin) {
-    return std::async(std::launch::async, [this, vin]() {
-      std::cout << "Debug: In _get_vehicle_status for VIN: " << vin << std::endl;
+  std::string Controller::_command_url(const std::string& vin, const std::string& endpoint) const {
+    // G3 uses G2 API for now
+    std::string api_gen = (get_api_gen(vin) == api::API_FEATURE_G1_TELEMATICS) ? "g1" : "g2";
+    std::string url = endpoint;
+    auto pos = url.find("api_gen");
+    if (pos != std::string::npos) {
+      url.replace(pos, 7, api_gen);
+    }
+    return url;
+  }
+
+  std::future<nlohmann::json> Controller::_get_vehicle_status(const std::string& vin, bool session_validated) {
+    return std::async(std::launch::async, traced("Controller::_get_vehicle_status", [this, vin, session_validated]() {
+      SUBARULINK_LOG_DEBUG("In _get_vehicle_status for VIN: ", vin);
 
       try {
-        std::cout << "Debug: Validating session..." << std::endl;
-        _connection->validate_session(vin).get();
+        nlohmann::json response;
+        {
+          Connection::VehicleLane lane(*_connection, vin);
+          if (!session_validated) {
+            SUBARULINK_LOG_DEBUG("Validating session...");
+            _connection->validate_session(vin).get();
+          } else {
+            _connection->select_vehicle(vin).get();
+          }
 
-        std::cout << "Debug: Making API_VEHICLE_STATUS request..." << std::endl;
-        auto response = _get(api::API_VEHICLE_STATUS).get();
+          SUBARULINK_LOG_DEBUG("Making API_VEHICLE_STATUS request...");
+          response = _get(api::API_VEHICLE_STATUS).get();
+        }
 
-        std::cout << "Debug: Vehicle status API response: " << response.dump(2) << std::endl;
+        SUBARULINK_LOG_TRACE("Vehicle status API response: ", redact(response, 2));
         return response;
 
       } catch (const std::exception& e) {
-        std::cout << "Debug: Error in _get_vehicle_status: " << e.what() << std::endl;
+        SUBARULINK_LOG_WARN("Error in _get_vehicle_status: ", e.what());
         throw;
       }
-    });
+    }));
   }
 
   bool Controller::_validate_remote_capability(const std::string& vin) {
@@ -1206,57 +2344,26 @@ namespace subarulink {
       const std::string& vin,
       const std::string& req_id,
       const std::string& poll_url,
-      int attempts) {
-
-    return std::async(std::launch::async, [this, vin, req_id, poll_url, attempts]() {
-      int remaining_attempts = attempts;
-
-      while (remaining_attempts > 0) {
-        try {
-          _connection->validate_session(vin).get();
-
-          std::map<std::string, std::string> params = {
-              {"serviceRequestId", req_id}
-          };
-
-          auto js_resp = _post(poll_url, params).get();
-          _check_error_code(js_resp);
-
-          if (js_resp["success"].get<bool>()) {
-            // Check if service is completed
-            auto status = js_resp["data"]["remoteServiceState"].get<std::string>();
-
-            if (status == "SUCCESS") {
-              return std::make_tuple(true, js_resp);
-            } else if (status == "FAILED") {
-              return std::make_tuple(false, js_resp);
-            }
-          }
-        } catch (const SubaruException& e) {
-          if (std::string(e.what()).find("HTTP 500") != std::string::npos) {
-            // Server error, continue polling
-            remaining_attempts--;
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            continue;
-          }
-          throw;
-        }
+      const PollSchedule& schedule) {
+    return _status_poller.watch(vin, req_id, poll_url, schedule);
+  }
 
-        remaining_attempts--;
-        if (remaining_attempts > 0) {
-          std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
-      }
+  nlohmann::json Controller::_poll_request_status(const std::string& poll_url, const std::string& req_id) {
+    std::map<std::string, std::string> params = {
+        {"serviceRequestId", req_id}
+    };
 
-      return std::make_tuple(false, nlohmann::json());
-    });
+    auto js_resp = _post(poll_url, params).get();
+    _check_error_code(js_resp);
+    return js_resp;
   }
 
-  void Controller::_parse_location(const std::string& vin, const nlohmann::json& result) {
-    auto& vehicle_status = _vehicles[vin].vehicle_status;
+
+  std::vector<VehicleEvent> Controller::_parse_location(const std::string& vin, const nlohmann::json& result) {
+    nlohmann::json location;
 
     // Initialize location validity flag
-    vehicle_status["LOCATION_VALID"] = false;
+    location["LOCATION_VALID"] = false;
 
     // Check if location data exists and is valid
     if (result.find("longitude") != result.end() && result.find("latitude") != result.end()) {
@@ -1281,13 +2388,13 @@ namespace subarulink {
       if (longitude != error_values::BAD_LONGITUDE &&
           latitude != error_values::BAD_LATITUDE) {
 
-        vehicle_status["LONGITUDE"] = longitude;
-        vehicle_status["LATITUDE"] = latitude;
-        vehicle_status["LOCATION_VALID"] = true;
+        location["LONGITUDE"] = longitude;
+        location["LATITUDE"] = latitude;
+        location["LOCATION_VALID"] = true;
 
         // Add timestamp if available
         if (result.find("locationTimestamp") != result.end()) {
-          vehicle_status["LOCATION_TIMESTAMP"] = result["locationTimestamp"].get<std::string>();
+          location["LOCATION_TIMESTAMP"] = result["locationTimestamp"].get<std::string>();
         }
       }
     }
@@ -1295,18 +2402,172 @@ namespace subarulink {
     // Parse heading if available
     if (result.find("heading") != result.end() && !result["heading"].is_null()) {
       if (result["heading"].is_string()) {
-        vehicle_status["HEADING"] = result["heading"].get<std::string>();
+        location["HEADING"] = result["heading"].get<std::string>();
       } else if (result["heading"].is_number()) {
-        vehicle_status["HEADING"] = std::to_string(result["heading"].get<double>());
+        location["HEADING"] = std::to_string(result["heading"].get<double>());
       }
     }
 
     // Parse location name/address if available
     if (result.find("locationName") != result.end() && !result["locationName"].is_null()) {
-      vehicle_status["LOCATION_NAME"] = result["locationName"].get<std::string>();
+      location["LOCATION_NAME"] = result["locationName"].get<std::string>();
+    }
+
+    SUBARULINK_LOG_TRACE("Parsed location data: ", redact(location, 2));
+
+    std::vector<FieldDelta> deltas;
+    _merge_fields(_vehicles.at(vin).vehicle_status, location, source_time(location, "LOCATION_TIMESTAMP"), deltas);
+    auto events = _commit_changes(vin, std::move(deltas), EventType::LOCATION_UPDATED);
+
+    if (location["LOCATION_VALID"].get<bool>()) {
+      GeoPoint position{location["LATITUDE"].get<double>(), location["LONGITUDE"].get<double>()};
+      if (_record_locations) {
+        LocationSample sample{source_time(location, "LOCATION_TIMESTAMP"), position.latitude, position.longitude, {}};
+        if (location.contains("HEADING")) {
+          try {
+            sample.heading = static_cast<int>(std::lround(std::stod(location["HEADING"].get<std::string>())));
+          } catch (const std::exception&) {
+            // Unparseable heading is recorded as unknown
+          }
+        }
+        _location_history.append(vin, sample);
+      }
+      for (const auto& crossing : _spatial_index.update(vin, position)) {
+        VehicleEvent event;
+        event.type = EventType::GEOFENCE;
+        event.vin = vin;
+        event.fence_id = crossing.fence_id;
+        event.entered = crossing.entered;
+        event.time = std::chrono::system_clock::now();
+        events.push_back(std::move(event));
+      }
+    }
+    return events;
+  }
+
+  void Controller::_track_charge(const std::string& vin, const nlohmann::json& condition,
+                                 std::chrono::system_clock::time_point time, std::vector<VehicleEvent>& events) {
+    ChargeSample sample;
+    sample.time = time;
+    if (condition.contains(vehicle_fields::EV_STATE_OF_CHARGE_PERCENT)) {
+      sample.state_of_charge = condition[vehicle_fields::EV_STATE_OF_CHARGE_PERCENT].get<double>();
+    }
+    sample.charging = condition.value(vehicle_fields::EV_CHARGER_STATE_TYPE, std::string()) == ev_charge::CHARGING;
+    if (condition.contains(vehicle_fields::EV_TIME_TO_FULLY_CHARGED_UTC)) {
+      sample.full_at = parse_api_timestamp(condition[vehicle_fields::EV_TIME_TO_FULLY_CHARGED_UTC].get<std::string>());
+    }
+    if (!sample.full_at && condition.contains(vehicle_fields::EV_TIME_TO_FULLY_CHARGED)) {
+      sample.full_at = time + std::chrono::minutes(condition[vehicle_fields::EV_TIME_TO_FULLY_CHARGED].get<int>());
+    }
+
+    auto transition = _charge_tracker.record(vin, sample);
+    if (transition == ChargeTracker::Transition::NONE) {
+      return;
+    }
+    VehicleEvent event;
+    event.type = EventType::CHARGE;
+    event.vin = vin;
+    event.charging = transition == ChargeTracker::Transition::STARTED;
+    event.time = std::chrono::system_clock::now();
+    events.push_back(std::move(event));
+  }
+
+  void Controller::_record_field_history(const std::string& vin, const nlohmann::json& values,
+                                         std::chrono::system_clock::time_point time) {
+    std::shared_ptr<TimeSeriesStore> store;
+    {
+      std::lock_guard<std::mutex> lock(_field_history_mutex);
+      store = _field_history;
+    }
+    if (!store) {
+      return;
+    }
+    for (const auto& field : HISTORY_FIELDS) {
+      auto it = values.find(field);
+      if (it != values.end() && it->is_number()) {
+        store->append(vin, field, time, it->get<double>());
+      }
+    }
+  }
+
+  void Controller::_merge_fields(std::map<std::string, nlohmann::json>& target,
+                                 const nlohmann::json& values,
+                                 std::chrono::system_clock::time_point source_time,
+                                 std::vector<FieldDelta>& deltas) {
+    for (auto it = values.begin(); it != values.end(); ++it) {
+      auto existing = target.find(it.key());
+      if (existing == target.end()) {
+        deltas.push_back({0, field_id(it.key()), nullptr, it.value(), source_time});
+        target.emplace(it.key(), it.value());
+      } else if (existing->second != it.value()) {
+        deltas.push_back({0, field_id(it.key()), existing->second, it.value(), source_time});
+        existing->second = it.value();
+      }
+    }
+  }
+
+  std::vector<VehicleEvent> Controller::_commit_changes(const std::string& vin,
+                                                        std::vector<FieldDelta> deltas,
+                                                        EventType kind) {
+    if (deltas.empty()) {
+      return {};
+    }
+    auto version = _change_logs.at(vin).commit(deltas);
+    _vehicles[vin].version = version;
+
+    // Stamp the copy the same way the log does, so subscribers see what get_changes_since returns
+    auto committed = std::move(deltas);
+    for (auto& delta : committed) {
+      delta.version = version;
+    }
+    auto now = std::chrono::system_clock::now();
+
+    std::vector<VehicleEvent> events;
+    VehicleEvent changed;
+    changed.type = EventType::FIELD_CHANGED;
+    changed.vin = vin;
+    changed.version = _vehicles[vin].version;
+    changed.changes = committed;
+    changed.time = now;
+    events.push_back(changed);
+
+    // Health events only fire when a trouble indicator moved, not on every health refresh
+    if (kind == EventType::HEALTH_TROUBLE) {
+      bool trouble_changed = std::any_of(committed.begin(), committed.end(), [](const FieldDelta& delta) {
+        const auto& name = field_name(delta.field);
+        return name == "HEALTH_TROUBLE" || name == "HEALTH_FEATURES";
+      });
+      if (!trouble_changed) {
+        return events;
+      }
+    }
+
+    if (kind != EventType::NONE) {
+      changed.type = kind;
+      events.push_back(std::move(changed));
+    }
+    return events;
+  }
+
+  void Controller::_publish(const std::vector<VehicleEvent>& events) {
+    for (const auto& event : events) {
+      _events.publish(event);
+    }
+  }
+
+  void Controller::_publish_command_state(RemoteCommand& command, RemoteCommandState state, const std::string& req_id) {
+    if (!command.transition(state, req_id)) {
+      return;
     }
 
-    std::cout << "Debug: Parsed location data: " << nlohmann::json(vehicle_status).dump(2) << std::endl;
+    VehicleEvent event;
+    event.type = EventType::REMOTE_COMMAND;
+    event.vin = command.vin();
+    event.command = command.command();
+    event.command_state = state;
+    event.service_request_id = command.service_request_id();
+    event.time = std::chrono::system_clock::now();
+    _events.publish(event);
   }
 
 } // namespace subarulink
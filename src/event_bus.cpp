@@ -0,0 +1,85 @@
+#include "event_bus.h"
+#include "logger.h"
+
+namespace subarulink {
+
+  EventBus::EventBus() : _dispatcher(&EventBus::_dispatch_loop, this) {}
+
+  EventBus::~EventBus() {
+    {
+      std::lock_guard<std::mutex> lock(_queue_mutex);
+      _stopping = true;
+    }
+    _queue_cv.notify_all();
+    _dispatcher.join();
+  }
+
+  SubscriptionId EventBus::subscribe(EventType types, EventCallback callback, const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto id = _next_id++;
+    _subscriptions.emplace(id, Subscription{types, std::move(callback), vin});
+    return id;
+  }
+
+  bool EventBus::unsubscribe(SubscriptionId id) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _subscriptions.erase(id) > 0;
+  }
+
+  void EventBus::set_executor(Executor executor) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _executor = std::move(executor);
+  }
+
+  void EventBus::publish(const VehicleEvent &event) {
+    std::vector<EventCallback> callbacks;
+    Executor executor;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (const auto &[id, subscription]: _subscriptions) {
+        if ((subscription.types & event.type) != EventType::NONE &&
+            (subscription.vin.empty() || subscription.vin == event.vin)) {
+          callbacks.push_back(subscription.callback);
+        }
+      }
+      executor = _executor;
+    }
+
+    for (auto &callback: callbacks) {
+      auto job = [callback = std::move(callback), event]() {
+        try {
+          callback(event);
+        } catch (const std::exception &e) {
+          SUBARULINK_LOG_WARN("Event callback threw: ", e.what());
+        }
+      };
+
+      if (executor) {
+        executor(std::move(job));
+      } else {
+        {
+          std::lock_guard<std::mutex> lock(_queue_mutex);
+          _queue.push_back(std::move(job));
+        }
+        _queue_cv.notify_one();
+      }
+    }
+  }
+
+  void EventBus::_dispatch_loop() {
+    std::unique_lock<std::mutex> lock(_queue_mutex);
+    while (true) {
+      _queue_cv.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+      if (_queue.empty()) {
+        return;  // Stopping with nothing left to deliver
+      }
+      auto job = std::move(_queue.front());
+      _queue.pop_front();
+
+      lock.unlock();
+      job();
+      lock.lock();
+    }
+  }
+
+} // namespace subarulink
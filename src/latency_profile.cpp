@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <fstream>
+
+#include "latency_profile.h"
+#include "logger.h"
+
+namespace subarulink {
+
+  namespace {
+    constexpr int64_t MIN_INTERVAL_MS = 250;
+    constexpr int64_t MAX_DENSE_INTERVAL_MS = 2000;
+    constexpr int64_t MAX_INTERVAL_MS = 5000;
+    constexpr int64_t MIN_DEADLINE_MS = 20000;
+    constexpr int MAX_ATTEMPTS = 40;
+    constexpr double BACKOFF = 1.5;
+  }
+
+  void LatencyProfiles::record(const std::string &key, std::chrono::milliseconds elapsed, bool censored) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &profile = _profiles[key];
+    Sample sample{elapsed.count(), censored};
+    if (profile.samples.size() < MAX_SAMPLES) {
+      profile.samples.push_back(sample);
+    } else {
+      profile.samples[profile.next] = sample;
+      profile.next = (profile.next + 1) % MAX_SAMPLES;
+    }
+  }
+
+  PollSchedule LatencyProfiles::schedule(const std::string &key) const {
+    std::vector<Sample> sorted;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto it = _profiles.find(key);
+      if (it == _profiles.end()) {
+        return PollSchedule();
+      }
+      auto completed = std::count_if(it->second.samples.begin(), it->second.samples.end(),
+                                     [](const Sample &sample) { return !sample.censored; });
+      if (static_cast<size_t>(completed) < MIN_SAMPLES) {
+        return PollSchedule();
+      }
+      sorted = _sorted(it->second);
+    }
+
+    auto p25 = _at(sorted, 25);
+    auto p90 = _at(sorted, 90);
+
+    // First poll a little before the fast quartile finishes, then a few polls across the typical range
+    PollSchedule schedule;
+    schedule.first_delay = std::chrono::milliseconds(p25 * 4 / 5);
+    schedule.interval = std::chrono::milliseconds(std::clamp((p90 - p25) / 4, MIN_INTERVAL_MS, MAX_DENSE_INTERVAL_MS));
+    schedule.backoff = BACKOFF;
+    schedule.max_interval = std::chrono::milliseconds(MAX_INTERVAL_MS);
+
+    // Enough attempts to cover twice the slow tail, timeouts included, and never less than the fixed
+    // cadence covered
+    auto deadline = std::max(MIN_DEADLINE_MS, 2 * sorted.back().ms);
+    int64_t elapsed = schedule.first_delay.count();
+    double interval = static_cast<double>(schedule.interval.count());
+    int attempts = 1;
+    while (elapsed < deadline && attempts < MAX_ATTEMPTS) {
+      elapsed += static_cast<int64_t>(interval);
+      interval = std::min(interval * BACKOFF, static_cast<double>(MAX_INTERVAL_MS));
+      ++attempts;
+    }
+    schedule.attempts = attempts;
+    return schedule;
+  }
+
+  std::chrono::milliseconds LatencyProfiles::percentile(const std::string &key, double percentile) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _profiles.find(key);
+    if (it == _profiles.end() || it->second.samples.empty()) {
+      return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(_at(_sorted(it->second), percentile));
+  }
+
+  nlohmann::json LatencyProfiles::to_json() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    nlohmann::json profiles = nlohmann::json::object();
+    for (const auto &[key, profile]: _profiles) {
+      // Oldest first, so reloading keeps the same eviction order
+      nlohmann::json samples = nlohmann::json::array();
+      for (size_t i = 0; i < profile.samples.size(); ++i) {
+        const auto &sample = profile.samples[(profile.next + i) % profile.samples.size()];
+        if (sample.censored) {
+          samples.push_back({{"censored", sample.ms}});
+        } else {
+          samples.push_back(sample.ms);
+        }
+      }
+      profiles[key] = samples;
+    }
+    return profiles;
+  }
+
+  void LatencyProfiles::from_json(const nlohmann::json &profiles) {
+    std::map<std::string, Profile> loaded;
+    for (auto it = profiles.begin(); it != profiles.end(); ++it) {
+      if (!it.value().is_array()) {
+        continue;
+      }
+      auto &profile = loaded[it.key()];
+      for (const auto &sample: it.value()) {
+        if (sample.is_number_integer() && sample.get<int64_t>() >= 0) {
+          profile.samples.push_back({sample.get<int64_t>(), false});
+        } else if (sample.is_object() && sample.contains("censored") && sample["censored"].is_number_integer() &&
+                   sample["censored"].get<int64_t>() >= 0) {
+          profile.samples.push_back({sample["censored"].get<int64_t>(), true});
+        }
+      }
+      // Keep only the newest samples
+      if (profile.samples.size() > MAX_SAMPLES) {
+        profile.samples.erase(profile.samples.begin(), profile.samples.end() - MAX_SAMPLES);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _profiles = std::move(loaded);
+  }
+
+  bool LatencyProfiles::save(const std::string &path) const {
+    std::ofstream file(path);
+    if (!file) {
+      return false;
+    }
+    file << to_json().dump();
+    return static_cast<bool>(file);
+  }
+
+  bool LatencyProfiles::load(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+      return false;
+    }
+    try {
+      from_json(nlohmann::json::parse(file));
+      return true;
+    } catch (const nlohmann::json::exception &e) {
+      SUBARULINK_LOG_WARN("Could not parse latency profiles: ", e.what());
+      return false;
+    }
+  }
+
+  std::vector<LatencyProfiles::Sample> LatencyProfiles::_sorted(const Profile &profile) {
+    auto sorted = profile.samples;
+    // On a tie a completion counts first: a command censored at t was still running at t
+    std::sort(sorted.begin(), sorted.end(), [](const Sample &a, const Sample &b) {
+      return a.ms != b.ms ? a.ms < b.ms : !a.censored && b.censored;
+    });
+    return sorted;
+  }
+
+  int64_t LatencyProfiles::_at(const std::vector<Sample> &sorted, double percentile) {
+    // Product-limit estimate: each completion lowers the share still running by one over the
+    // samples still at risk; a censored sample only leaves the risk set
+    double target = percentile / 100.0;
+    double running = 1.0;
+    size_t at_risk = sorted.size();
+    for (const auto &sample: sorted) {
+      if (!sample.censored) {
+        running *= 1.0 - 1.0 / static_cast<double>(at_risk);
+        if (1.0 - running >= target - 1e-9) {
+          return sample.ms;
+        }
+      }
+      --at_risk;
+    }
+    // The percentile lies past every completion; the slowest sample is a lower bound
+    return sorted.back().ms;
+  }
+
+} // namespace subarulink
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+
+#include "location_history.h"
+
+namespace subarulink {
+
+  namespace {
+    constexpr double MICRODEGREES = 1e6;
+  }
+
+  LocationHistory::LocationHistory(size_t max_samples)
+      : _max_samples(std::max(max_samples, BLOCK_SAMPLES)) {}
+
+  bool LocationHistory::append(const std::string &vin, const LocationSample &sample) {
+    auto point = _encode(sample);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &series = _series[vin];
+    if (!series.blocks.empty() && point.time <= series.blocks.back().last.time) {
+      return false;
+    }
+
+    if (series.blocks.empty() || series.blocks.back().count == BLOCK_SAMPLES) {
+      if (!series.blocks.empty()) {
+        series.blocks.back().bytes.shrink_to_fit();
+      }
+      series.blocks.emplace_back();
+      series.blocks.back().first_time = point.time;
+    }
+
+    // A new block starts from a default Point, so its first sample is stored nearly whole
+    auto &block = series.blocks.back();
+    _put(block.bytes, point.time - block.last.time);
+    _put(block.bytes, point.latitude - block.last.latitude);
+    _put(block.bytes, point.longitude - block.last.longitude);
+    _put(block.bytes, point.heading - block.last.heading);
+    block.last = point;
+    ++block.count;
+    ++series.samples;
+
+    _trim(series);
+    return true;
+  }
+
+  std::vector<LocationSample> LocationHistory::range(const std::string &vin,
+                                                     std::chrono::system_clock::time_point from,
+                                                     std::chrono::system_clock::time_point to) const {
+    auto first = std::chrono::duration_cast<std::chrono::seconds>(from.time_since_epoch()).count();
+    auto last = std::chrono::duration_cast<std::chrono::seconds>(to.time_since_epoch()).count();
+
+    std::vector<LocationSample> samples;
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto series = _series.find(vin);
+    if (series == _series.end()) {
+      return samples;
+    }
+
+    const auto &blocks = series->second.blocks;
+    auto block = std::lower_bound(blocks.begin(), blocks.end(), first,
+                                  [](const Block &b, int64_t time) { return b.last.time < time; });
+    for (; block != blocks.end() && block->first_time <= last; ++block) {
+      Point point;
+      size_t offset = 0;
+      for (size_t i = 0; i < block->count; ++i) {
+        point.time += _get(block->bytes, offset);
+        point.latitude += _get(block->bytes, offset);
+        point.longitude += _get(block->bytes, offset);
+        point.heading += _get(block->bytes, offset);
+        if (point.time > last) {
+          break;
+        }
+        if (point.time >= first) {
+          samples.push_back(_decode(point));
+        }
+      }
+    }
+    return samples;
+  }
+
+  std::optional<LocationSample> LocationHistory::latest(const std::string &vin) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto series = _series.find(vin);
+    if (series == _series.end() || series->second.blocks.empty()) {
+      return std::nullopt;
+    }
+    return _decode(series->second.blocks.back().last);
+  }
+
+  size_t LocationHistory::size(const std::string &vin) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto series = _series.find(vin);
+    return series == _series.end() ? 0 : series->second.samples;
+  }
+
+  size_t LocationHistory::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bytes = 0;
+    for (const auto &[vin, series]: _series) {
+      for (const auto &block: series.blocks) {
+        bytes += sizeof(Block) + block.bytes.capacity();
+      }
+    }
+    return bytes;
+  }
+
+  void LocationHistory::set_max_samples(size_t max_samples) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _max_samples = std::max(max_samples, BLOCK_SAMPLES);
+    for (auto &[vin, series]: _series) {
+      _trim(series);
+    }
+  }
+
+  size_t LocationHistory::get_max_samples() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _max_samples;
+  }
+
+  void LocationHistory::clear(const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _series.erase(vin);
+  }
+
+  LocationHistory::Point LocationHistory::_encode(const LocationSample &sample) {
+    Point point;
+    point.time = std::chrono::duration_cast<std::chrono::seconds>(sample.time.time_since_epoch()).count();
+    point.latitude = std::llround(sample.latitude * MICRODEGREES);
+    point.longitude = std::llround(sample.longitude * MICRODEGREES);
+    point.heading = sample.heading ? ((*sample.heading % 360) + 360) % 360 : -1;
+    return point;
+  }
+
+  LocationSample LocationHistory::_decode(const Point &point) {
+    LocationSample sample;
+    sample.time = std::chrono::system_clock::time_point(std::chrono::seconds(point.time));
+    sample.latitude = static_cast<double>(point.latitude) / MICRODEGREES;
+    sample.longitude = static_cast<double>(point.longitude) / MICRODEGREES;
+    if (point.heading >= 0) {
+      sample.heading = static_cast<int>(point.heading);
+    }
+    return sample;
+  }
+
+  void LocationHistory::_put(std::vector<uint8_t> &bytes, int64_t value) {
+    // Zigzag maps small negative deltas to small unsigned values
+    auto encoded = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (encoded >= 0x80) {
+      bytes.push_back(static_cast<uint8_t>(encoded | 0x80));
+      encoded >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(encoded));
+  }
+
+  int64_t LocationHistory::_get(const std::vector<uint8_t> &bytes, size_t &offset) {
+    uint64_t encoded = 0;
+    int shift = 0;
+    while (bytes[offset] & 0x80) {
+      encoded |= static_cast<uint64_t>(bytes[offset++] & 0x7F) << shift;
+      shift += 7;
+    }
+    encoded |= static_cast<uint64_t>(bytes[offset++]) << shift;
+    return static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+  }
+
+  void LocationHistory::_trim(Series &series) const {
+    while (series.samples > _max_samples && series.blocks.size() > 1) {
+      series.samples -= series.blocks.front().count;
+      series.blocks.pop_front();
+    }
+  }
+
+} // namespace subarulink
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <unordered_set>
+
+#include "logger.h"
+#include "constants.h"
+
+namespace subarulink {
+
+  namespace {
+    const std::string MASK = "******";
+    constexpr size_t MASK_INDEX = Logger::CAPACITY - 1;
+    constexpr auto IDLE_WAIT = std::chrono::milliseconds(100);
+
+    bool sensitive(const std::string &key) {
+      static const std::unordered_set<std::string> keys = []() {
+        std::unordered_set<std::string> all(RAW_API_FIELDS_TO_REDACT.begin(), RAW_API_FIELDS_TO_REDACT.end());
+        all.insert(CREDENTIAL_FIELDS_TO_REDACT.begin(), CREDENTIAL_FIELDS_TO_REDACT.end());
+        return all;
+      }();
+      return keys.count(key) > 0;
+    }
+
+    uint32_t thread_number() {
+      static std::atomic<uint32_t> next{1};
+      thread_local uint32_t number = next.fetch_add(1, std::memory_order_relaxed);
+      return number;
+    }
+  }
+
+  const char *log_level_name(LogLevel level) {
+    switch (level) {
+      case LogLevel::TRACE: return "TRACE";
+      case LogLevel::DEBUG: return "DEBUG";
+      case LogLevel::INFO: return "INFO";
+      case LogLevel::WARN: return "WARN";
+      case LogLevel::ERROR: return "ERROR";
+      case LogLevel::OFF: return "OFF";
+    }
+    return "UNKNOWN";
+  }
+
+  const std::string &redact_field(const std::string &key, const std::string &value) {
+    return sensitive(key) ? MASK : value;
+  }
+
+  nlohmann::json redacted(const nlohmann::json &value) {
+    if (value.is_object()) {
+      auto copy = nlohmann::json::object();
+      for (auto it = value.begin(); it != value.end(); ++it) {
+        copy[it.key()] = sensitive(it.key()) && !it.value().is_null() ? nlohmann::json(MASK) : redacted(it.value());
+      }
+      return copy;
+    }
+    if (value.is_array()) {
+      auto copy = nlohmann::json::array();
+      for (const auto &item: value) {
+        copy.push_back(redacted(item));
+      }
+      return copy;
+    }
+    return value;
+  }
+
+  std::ostream &operator<<(std::ostream &out, const RedactedJson &json) {
+    return out << redacted(json.value).dump(json.indent);
+  }
+
+  Logger &Logger::instance() {
+    static Logger logger;
+    return logger;
+  }
+
+  Logger::Logger()
+      : _slots(new Slot[CAPACITY]),
+        _level(static_cast<uint8_t>(LogLevel::INFO)) {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Logger::CAPACITY must be a power of two");
+    for (size_t i = 0; i < CAPACITY; ++i) {
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _thread = std::thread(&Logger::_run, this);
+  }
+
+  Logger::~Logger() {
+    _stopping = true;
+    _wake.notify_one();
+    if (_thread.joinable()) {
+      _thread.join();
+    }
+  }
+
+  void Logger::set_level(LogLevel level) {
+    _level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+  }
+
+  LogLevel Logger::get_level() const {
+    return static_cast<LogLevel>(_level.load(std::memory_order_relaxed));
+  }
+
+  void Logger::set_sink(LogSink sink) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sink = std::move(sink);
+  }
+
+  void Logger::flush() {
+    auto target = _head.load();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _wake.notify_one();
+    _progress.wait(lock, [this, target]() { return _written.load() >= target; });
+  }
+
+  uint64_t Logger::dropped() const {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+  Logger::Slot *Logger::_claim() {
+    // Bounded multi-producer ring: a slot is free for position pos once its sequence equals pos
+    auto pos = _head.load(std::memory_order_relaxed);
+    for (;;) {
+      auto *slot = &_slots[pos & MASK_INDEX];
+      auto sequence = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          return slot;
+        }
+      } else if (diff < 0) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      } else {
+        pos = _head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  Logger::RecordStream &Logger::_stream(LogRecord &record) {
+    thread_local RecordStream stream;
+    stream.reset(record);
+    return stream;
+  }
+
+  void Logger::_publish(Slot *slot, LogLevel level, RecordStream &stream) {
+    auto &record = slot->record;
+    record.level = level;
+    record.thread = thread_number();
+    record.time = std::chrono::system_clock::now();
+    record.length = static_cast<uint16_t>(stream.length());
+    if (stream.truncated() && record.length >= 3) {
+      std::memcpy(record.message + record.length - 3, "...", 3);
+    }
+
+    slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1);
+    if (_idle.load()) {
+      _wake.notify_one();
+    }
+  }
+
+  void Logger::_run() {
+    size_t tail = 0;
+    for (;;) {
+      LogSink sink;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        sink = _sink;
+      }
+
+      size_t batch = 0;
+      for (;;) {
+        auto *slot = &_slots[tail & MASK_INDEX];
+        if (slot->sequence.load(std::memory_order_acquire) != tail + 1) {
+          break;
+        }
+        if (sink) {
+          sink(slot->record);
+        } else {
+          _write_stdout(slot->record);
+        }
+        slot->sequence.store(tail + CAPACITY, std::memory_order_release);
+        ++tail;
+        ++batch;
+      }
+
+      if (batch > 0) {
+        if (!sink) {
+          std::fflush(stdout);
+        }
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _written.store(tail);
+        }
+        _progress.notify_all();
+        continue;
+      }
+
+      if (_stopping && tail == _head.load()) {
+        return;
+      }
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _idle.store(true);
+      // Re-check after announcing idle so a record published meanwhile is not left waiting
+      if (_slots[tail & MASK_INDEX].sequence.load() != tail + 1 && !_stopping) {
+        _wake.wait_for(lock, IDLE_WAIT);
+      }
+      _idle.store(false);
+    }
+  }
+
+  void Logger::_write_stdout(const LogRecord &record) {
+    auto time = std::chrono::system_clock::to_time_t(record.time);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        record.time.time_since_epoch()).count() % 1000;
+
+    // Only the writer thread formats times, so the shared gmtime buffer is safe here
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", std::gmtime(&time));
+    std::fprintf(stdout, "%s.%03dZ %-5s [%u] %.*s\n", stamp, static_cast<int>(millis),
+                 log_level_name(record.level), record.thread,
+                 static_cast<int>(record.length), record.message);
+  }
+
+  Logger::RecordStream::RecordStream() : std::ostream(nullptr) {
+    rdbuf(&_buffer);
+  }
+
+  void Logger::RecordStream::reset(LogRecord &record) {
+    _buffer.reset(record.message, LogRecord::MESSAGE_BYTES);
+    clear();
+    flags(std::ios_base::dec | std::ios_base::skipws);
+    precision(6);
+    width(0);
+  }
+
+  size_t Logger::RecordStream::length() const {
+    return _buffer.length();
+  }
+
+  bool Logger::RecordStream::truncated() const {
+    return _buffer.truncated();
+  }
+
+  void Logger::RecordStream::Buffer::reset(char *begin, size_t size) {
+    setp(begin, begin + size);
+    _truncated = false;
+  }
+
+  size_t Logger::RecordStream::Buffer::length() const {
+    return static_cast<size_t>(pptr() - pbase());
+  }
+
+  bool Logger::RecordStream::Buffer::truncated() const {
+    return _truncated;
+  }
+
+  Logger::RecordStream::Buffer::int_type Logger::RecordStream::Buffer::overflow(int_type ch) {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      _truncated = true;
+    }
+    return traits_type::eof();
+  }
+
+  std::streamsize Logger::RecordStream::Buffer::xsputn(const char *s, std::streamsize count) {
+    auto room = static_cast<std::streamsize>(epptr() - pptr());
+    auto copied = std::min(room, count);
+    std::memcpy(pptr(), s, static_cast<size_t>(copied));
+    pbump(static_cast<int>(copied));
+    if (copied < count) {
+      _truncated = true;
+    }
+    return copied;
+  }
+
+} // namespace subarulink
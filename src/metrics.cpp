@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+
+#include "metrics.h"
+
+namespace subarulink {
+
+  namespace {
+    constexpr char SEPARATOR = '\x1f';
+
+    /// Bounds of the Prometheus histogram buckets, in seconds
+    constexpr double EXPORT_BOUNDS[] = {0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120};
+
+    std::vector <std::string> split_labels(const std::string &key) {
+      std::vector <std::string> labels;
+      size_t start = 1;
+      for (;;) {
+        auto end = key.find(SEPARATOR, start);
+        labels.push_back(key.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        if (end == std::string::npos) {
+          return labels;
+        }
+        start = end + 1;
+      }
+    }
+
+    // FNV-1a over the series key as _register joins it, without building the key
+    size_t series_hash(char family, std::initializer_list<std::string_view> labels) {
+      uint64_t hash = 14695981039346656037ULL;
+      auto mix = [&hash](char c) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+      };
+      mix(family);
+      bool first = true;
+      for (auto label: labels) {
+        if (!first) {
+          mix(SEPARATOR);
+        }
+        first = false;
+        for (char c: label) {
+          mix(c);
+        }
+      }
+      return static_cast<size_t>(hash);
+    }
+
+    bool series_matches(const std::string &key, char family, std::initializer_list<std::string_view> labels) {
+      if (key.empty() || key[0] != family) {
+        return false;
+      }
+      size_t position = 1;
+      bool first = true;
+      for (auto label: labels) {
+        if (!first) {
+          if (position >= key.size() || key[position] != SEPARATOR) {
+            return false;
+          }
+          ++position;
+        }
+        first = false;
+        if (key.compare(position, label.size(), label) != 0) {
+          return false;
+        }
+        position += label.size();
+      }
+      return position == key.size();
+    }
+
+    std::string escape(const std::string &value) {
+      std::string escaped;
+      escaped.reserve(value.size());
+      for (char c: value) {
+        if (c == '\\' || c == '"') {
+          escaped += '\\';
+          escaped += c;
+        } else if (c == '\n') {
+          escaped += "\\n";
+        } else {
+          escaped += c;
+        }
+      }
+      return escaped;
+    }
+
+    void write_family(std::ostream &out, const char *name, const char *type, const char *help) {
+      out << "# HELP " << name << " " << help << "\n";
+      out << "# TYPE " << name << " " << type << "\n";
+    }
+
+    void write_histograms(std::ostream &out, const char *name, const char *label,
+                          const std::map <std::string, LatencyStats> &series) {
+      for (const auto &[value, stats]: series) {
+        auto labels = std::string(label) + "=\"" + escape(value) + "\"";
+        // A fine bucket counts towards a bound once its upper edge is within it
+        auto bucket = stats.buckets.begin();
+        uint64_t cumulative = 0;
+        for (double bound: EXPORT_BOUNDS) {
+          while (bucket != stats.buckets.end() && bucket->first <= bound) {
+            cumulative += bucket->second;
+            ++bucket;
+          }
+          out << name << "_bucket{" << labels << ",le=\"" << bound << "\"} " << cumulative << "\n";
+        }
+        out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << stats.count << "\n";
+        out << name << "_sum{" << labels << "} " << stats.sum_seconds << "\n";
+        out << name << "_count{" << labels << "} " << stats.count << "\n";
+      }
+    }
+  }
+
+  double LatencyStats::percentile(double quantile) const {
+    if (count == 0) {
+      return 0.0;
+    }
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (const auto &[upper, calls]: buckets) {
+      seen += calls;
+      if (seen >= rank) {
+        return std::min(upper, max_seconds);
+      }
+    }
+    return max_seconds;
+  }
+
+  bool ResponseKey::operator<(const ResponseKey &other) const {
+    return std::tie(endpoint, status, error_code) < std::tie(other.endpoint, other.status, other.error_code);
+  }
+
+  std::string MetricsSnapshot::prometheus() const {
+    std::ostringstream out;
+    out << std::setprecision(10);
+
+    write_family(out, "subarulink_request_duration_seconds", "histogram", "STARLINK HTTP request latency");
+    write_histograms(out, "subarulink_request_duration_seconds", "endpoint", requests);
+
+    write_family(out, "subarulink_requests_total", "counter", "STARLINK HTTP requests by outcome");
+    for (const auto &[key, calls]: responses) {
+      out << "subarulink_requests_total{endpoint=\"" << escape(key.endpoint) << "\",status=\"" << key.status
+          << "\",error_code=\"" << escape(key.error_code) << "\"} " << calls << "\n";
+    }
+
+    write_family(out, "subarulink_operation_duration_seconds", "histogram", "Controller operation latency");
+    write_histograms(out, "subarulink_operation_duration_seconds", "operation", operations);
+
+    write_family(out, "subarulink_operation_errors_total", "counter", "Controller operations that failed or threw");
+    for (const auto &[operation, calls]: operation_errors) {
+      out << "subarulink_operation_errors_total{operation=\"" << escape(operation) << "\"} " << calls << "\n";
+    }
+
+    write_family(out, "subarulink_retries_total", "counter", "Attempts repeated after a retryable error");
+    for (const auto &[operation, calls]: retries) {
+      out << "subarulink_retries_total{operation=\"" << escape(operation) << "\"} " << calls << "\n";
+    }
+
+    write_family(out, "subarulink_session_resets_total", "counter", "HTTP sessions dropped and re-established");
+    out << "subarulink_session_resets_total " << session_resets << "\n";
+    write_family(out, "subarulink_vehicle_switches_total", "counter", "selectVehicle calls that switched vehicle");
+    out << "subarulink_vehicle_switches_total " << vehicle_switches << "\n";
+    write_family(out, "subarulink_reauthentications_total", "counter", "Logins after the session expired");
+    out << "subarulink_reauthentications_total " << reauthentications << "\n";
+    return out.str();
+  }
+
+  Metrics::Metrics() {
+    for (auto &shard: _shards) {
+      for (auto &slot: shard.slots) {
+        slot.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  Metrics &Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+  }
+
+  void Metrics::record_request(const std::string &endpoint, int status, const std::string &error_code,
+                               std::chrono::steady_clock::duration latency) {
+    _observe(_cell(Family::REQUEST, {endpoint}, true), latency);
+
+    char status_text[16];
+    auto status_end = std::to_chars(status_text, status_text + sizeof(status_text), status).ptr;
+    _add(_cell(Family::RESPONSE, {endpoint, std::string_view(status_text, status_end - status_text), error_code},
+               false), 1);
+  }
+
+  void Metrics::record_operation(const std::string &operation, bool success,
+                                 std::chrono::steady_clock::duration latency) {
+    _observe(_cell(Family::OPERATION, {operation}, true), latency);
+    if (!success) {
+      _add(_cell(Family::OPERATION_ERROR, {operation}, false), 1);
+    }
+  }
+
+  void Metrics::count(MetricEvent event, const std::string &label) {
+    switch (event) {
+      case MetricEvent::RETRY:
+        _add(_cell(Family::RETRY, {label}, false), 1);
+        break;
+      case MetricEvent::SESSION_RESET:
+        _add(_cell(Family::SESSION_RESET, {""}, false), 1);
+        break;
+      case MetricEvent::VEHICLE_SWITCH:
+        _add(_cell(Family::VEHICLE_SWITCH, {""}, false), 1);
+        break;
+      case MetricEvent::REAUTHENTICATION:
+        _add(_cell(Family::REAUTHENTICATION, {""}, false), 1);
+        break;
+    }
+  }
+
+  MetricsSnapshot Metrics::snapshot() const {
+    std::map <std::string, Totals> merged;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (const auto &cell: _cells) {
+        merged[cell->key].add(*cell);
+      }
+    }
+
+    MetricsSnapshot snapshot;
+    for (const auto &[key, totals]: merged) {
+      auto labels = split_labels(key);
+      switch (static_cast<Family>(key[0])) {
+        case Family::REQUEST:
+          snapshot.requests[labels[0]] = _latency(totals);
+          break;
+        case Family::RESPONSE:
+          snapshot.responses[ResponseKey{labels[0], std::stoi(labels[1]), labels[2]}] = totals.count;
+          break;
+        case Family::OPERATION:
+          snapshot.operations[labels[0]] = _latency(totals);
+          break;
+        case Family::OPERATION_ERROR:
+          snapshot.operation_errors[labels[0]] = totals.count;
+          break;
+        case Family::RETRY:
+          snapshot.retries[labels[0]] = totals.count;
+          break;
+        case Family::SESSION_RESET:
+          snapshot.session_resets = totals.count;
+          break;
+        case Family::VEHICLE_SWITCH:
+          snapshot.vehicle_switches = totals.count;
+          break;
+        case Family::REAUTHENTICATION:
+          snapshot.reauthentications = totals.count;
+          break;
+      }
+    }
+    return snapshot;
+  }
+
+  bool Metrics::write_prometheus(const std::string &path) const {
+    auto text = snapshot().prometheus();
+    auto temporary = path + ".tmp";
+    {
+      std::ofstream out(temporary, std::ios::trunc);
+      if (!out) {
+        return false;
+      }
+      out << text;
+      if (!out.flush()) {
+        return false;
+      }
+    }
+    // Rename so a scraper never reads a partly written file
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+  }
+
+  void Metrics::reset() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &cell: _cells) {
+      cell->count.store(0, std::memory_order_relaxed);
+      cell->sum_us.store(0, std::memory_order_relaxed);
+      cell->max_us.store(0, std::memory_order_relaxed);
+      if (cell->buckets) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+          cell->buckets[i].store(0, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  Metrics::Cell &Metrics::_cell(Family family, std::initializer_list<std::string_view> labels, bool histogram) {
+    // A thread keeps the shard it is given on its first record
+    thread_local const size_t shard_index = _next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    auto &shard = _shards[shard_index];
+
+    auto hash = series_hash(static_cast<char>(family), labels);
+    for (size_t probe = 0; probe < SLOTS; ++probe) {
+      auto *cell = shard.slots[(hash + probe) & (SLOTS - 1)].load(std::memory_order_acquire);
+      if (!cell) {
+        break;
+      }
+      if (series_matches(cell->key, static_cast<char>(family), labels)) {
+        return *cell;
+      }
+    }
+    return _register(shard, hash, family, labels, histogram);
+  }
+
+  Metrics::Cell &Metrics::_register(Shard &shard, size_t hash, Family family,
+                                    std::initializer_list<std::string_view> labels, bool histogram) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Another thread of this shard may have registered the series since the lock-free probe
+    for (size_t probe = 0; probe < SLOTS; ++probe) {
+      auto &slot = shard.slots[(hash + probe) & (SLOTS - 1)];
+      auto *existing = slot.load(std::memory_order_relaxed);
+      if (existing && series_matches(existing->key, static_cast<char>(family), labels)) {
+        return *existing;
+      }
+      if (existing) {
+        continue;
+      }
+
+      auto cell = std::make_unique<Cell>();
+      cell->key += static_cast<char>(family);
+      bool first = true;
+      for (auto label: labels) {
+        if (!first) {
+          cell->key += SEPARATOR;
+        }
+        first = false;
+        cell->key.append(label.data(), label.size());
+      }
+      if (histogram) {
+        cell->buckets.reset(new std::atomic<uint64_t>[BUCKETS]);
+        for (size_t i = 0; i < BUCKETS; ++i) {
+          cell->buckets[i].store(0, std::memory_order_relaxed);
+        }
+      }
+      slot.store(cell.get(), std::memory_order_release);
+      _cells.push_back(std::move(cell));
+      return *_cells.back();
+    }
+
+    if (!_overflow) {
+      _overflow = std::make_unique<Cell>();
+      _overflow->buckets.reset(new std::atomic<uint64_t>[BUCKETS]);
+      for (size_t i = 0; i < BUCKETS; ++i) {
+        _overflow->buckets[i].store(0, std::memory_order_relaxed);
+      }
+    }
+    return *_overflow;
+  }
+
+  void Metrics::_add(Cell &cell, uint64_t amount) {
+    cell.count.fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  void Metrics::_observe(Cell &cell, std::chrono::steady_clock::duration latency) {
+    auto micros = static_cast<uint64_t>(std::max<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), 0));
+    cell.count.fetch_add(1, std::memory_order_relaxed);
+    cell.sum_us.fetch_add(micros, std::memory_order_relaxed);
+    // Threads sharing the shard race on the maximum
+    auto max_us = cell.max_us.load(std::memory_order_relaxed);
+    while (micros > max_us && !cell.max_us.compare_exchange_weak(max_us, micros, std::memory_order_relaxed)) {
+    }
+    cell.buckets[_bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t Metrics::_bucket(uint64_t micros) {
+    constexpr uint64_t sub_buckets = uint64_t{1} << SUB_BUCKET_BITS;
+    if (micros < sub_buckets) {
+      return static_cast<size_t>(micros);
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    int exponent = 63 - __builtin_clzll(micros);
+#else
+    int exponent = 0;
+    while ((micros >> exponent) > 1) {
+      ++exponent;
+    }
+#endif
+    if (exponent > MAX_EXPONENT) {
+      return BUCKETS - 1;
+    }
+    // Exponent selects the power of two, the next SUB_BUCKET_BITS bits the linear step within it
+    auto sub = (micros >> (exponent - SUB_BUCKET_BITS)) & (sub_buckets - 1);
+    return (static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) | static_cast<size_t>(sub);
+  }
+
+  double Metrics::_bucket_upper_seconds(size_t index) {
+    constexpr size_t sub_buckets = size_t{1} << SUB_BUCKET_BITS;
+    if (index < sub_buckets) {
+      return static_cast<double>(index + 1) / 1e6;
+    }
+    auto exponent = static_cast<int>(index >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+    auto sub = index & (sub_buckets - 1);
+    auto upper = static_cast<uint64_t>(sub_buckets + sub + 1) << (exponent - SUB_BUCKET_BITS);
+    return static_cast<double>(upper) / 1e6;
+  }
+
+  LatencyStats Metrics::_latency(const Totals &totals) {
+    LatencyStats stats;
+    stats.count = totals.count;
+    stats.sum_seconds = static_cast<double>(totals.sum_us) / 1e6;
+    stats.max_seconds = static_cast<double>(totals.max_us) / 1e6;
+    for (size_t i = 0; i < totals.buckets.size(); ++i) {
+      if (totals.buckets[i] > 0) {
+        stats.buckets.emplace_back(_bucket_upper_seconds(i), totals.buckets[i]);
+      }
+    }
+    return stats;
+  }
+
+  void Metrics::Totals::add(const Cell &cell) {
+    count += cell.count.load(std::memory_order_relaxed);
+    sum_us += cell.sum_us.load(std::memory_order_relaxed);
+    max_us = std::max(max_us, cell.max_us.load(std::memory_order_relaxed));
+    if (cell.buckets) {
+      buckets.resize(BUCKETS, 0);
+      for (size_t i = 0; i < BUCKETS; ++i) {
+        buckets[i] += cell.buckets[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  OperationTimer::OperationTimer(std::string operation)
+      : _operation(std::move(operation)),
+        _started(std::chrono::steady_clock::now()) {
+  }
+
+  OperationTimer::~OperationTimer() {
+    Metrics::instance().record_operation(_operation, _success, std::chrono::steady_clock::now() - _started);
+  }
+
+  void OperationTimer::set_success(bool success) {
+    _success = success;
+  }
+
+} // namespace subarulink
@@ -0,0 +1,67 @@
+#include <algorithm>
+
+#include "poll_policy.h"
+
+namespace subarulink {
+
+  AdaptivePollPolicy::AdaptivePollPolicy(int active_interval, int max_backoff_factor)
+      : _active_interval(std::max(60, active_interval)),
+        _max_backoff_factor(std::max(1, max_backoff_factor)) {}
+
+  void AdaptivePollPolicy::record(const std::string &vin, const PollObservation &observation) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &activity = _activity[vin];
+    activity.ignition_on = observation.ignition_on;
+    if (observation.ignition_on || observation.source_moved || observation.data_changed) {
+      activity.idle_polls = 0;
+    } else {
+      // Saturate well before overflow; the factor is capped anyway
+      activity.idle_polls = std::min(activity.idle_polls + 1, 30);
+    }
+  }
+
+  int AdaptivePollPolicy::interval(const std::string &vin, int base_interval) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _activity.find(vin);
+    if (it == _activity.end()) {
+      return base_interval;
+    }
+
+    if (it->second.ignition_on) {
+      return std::min(base_interval, _active_interval);
+    }
+
+    long long factor = 1LL << it->second.idle_polls;
+    factor = std::min<long long>(factor, _max_backoff_factor);
+    return static_cast<int>(std::min<long long>(base_interval * factor, 24LL * 3600));
+  }
+
+  void AdaptivePollPolicy::reset(const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _activity.erase(vin);
+  }
+
+  int AdaptivePollPolicy::get_active_interval() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _active_interval;
+  }
+
+  bool AdaptivePollPolicy::set_active_interval(int value) {
+    if (value < 60) {  // Minimum 1 minute
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _active_interval = value;
+    return true;
+  }
+
+  bool AdaptivePollPolicy::set_max_backoff_factor(int value) {
+    if (value < 1) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _max_backoff_factor = value;
+    return true;
+  }
+
+} // namespace subarulink
@@ -0,0 +1,229 @@
+#include <algorithm>
+
+#include "poll_scheduler.h"
+#include "logger.h"
+
+namespace subarulink {
+
+  PollScheduler::PollScheduler(Job job, IntervalFunction interval, size_t max_in_flight)
+      : _job(std::move(job)),
+        _interval_function(std::move(interval)),
+        _max_in_flight(max_in_flight > 0 ? max_in_flight : 1),
+        _random(std::random_device{}()) {}
+
+  PollScheduler::~PollScheduler() {
+    stop();
+  }
+
+  void PollScheduler::add(const std::string &vin, PollKind kind) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto k = static_cast<size_t>(kind);
+    auto &slot = _slots[vin];
+    slot.registered[k] = true;
+    ++slot.generation[k];
+    if (!slot.paused) {
+      _push(vin, kind, Clock::now() + _jitter(vin, kind));
+    }
+    _cv.notify_all();
+  }
+
+  void PollScheduler::remove(const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _slots.erase(vin);
+  }
+
+  bool PollScheduler::pause(const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _slots.find(vin);
+    if (it == _slots.end()) {
+      return false;
+    }
+    it->second.paused = true;
+    return true;
+  }
+
+  bool PollScheduler::resume(const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _slots.find(vin);
+    if (it == _slots.end()) {
+      return false;
+    }
+    auto &slot = it->second;
+    if (slot.paused) {
+      slot.paused = false;
+      auto now = Clock::now();
+      for (size_t k = 0; k < KIND_COUNT; ++k) {
+        if (slot.registered[k]) {
+          auto kind = static_cast<PollKind>(k);
+          ++slot.generation[k];
+          _push(vin, kind, now + _jitter(vin, kind));
+        }
+      }
+      _cv.notify_all();
+    }
+    return true;
+  }
+
+  bool PollScheduler::is_paused(const std::string &vin) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _slots.find(vin);
+    return it != _slots.end() && it->second.paused;
+  }
+
+  void PollScheduler::poll_now(const std::string &vin, PollKind kind) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _slots.find(vin);
+    auto k = static_cast<size_t>(kind);
+    if (it == _slots.end() || !it->second.registered[k] || it->second.paused) {
+      return;
+    }
+    ++it->second.generation[k];
+    _push(vin, kind, Clock::now());
+    _cv.notify_all();
+  }
+
+  void PollScheduler::start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_thread.joinable()) {
+      return;
+    }
+    _stopping = false;
+    _thread = std::thread(&PollScheduler::_run, this);
+  }
+
+  void PollScheduler::stop() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_thread.joinable()) {
+        return;
+      }
+      _stopping = true;
+    }
+    _cv.notify_all();
+    _thread.join();
+
+    // Completing polls take the mutex, so wait for them without holding it
+    std::vector<std::future<void>> running;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      running.swap(_running);
+    }
+    for (auto &poll: running) {
+      poll.wait();
+    }
+  }
+
+  bool PollScheduler::is_running() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _thread.joinable() && !_stopping;
+  }
+
+  size_t PollScheduler::get_max_in_flight() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _max_in_flight;
+  }
+
+  bool PollScheduler::set_max_in_flight(size_t value) {
+    if (value == 0) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _max_in_flight = value;
+    _cv.notify_all();
+    return true;
+  }
+
+  void PollScheduler::_run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping) {
+      _reap();
+
+      if (_queue.empty()) {
+        _cv.wait(lock);
+        continue;
+      }
+
+      auto now = Clock::now();
+      if (_queue.top().due > now) {
+        _cv.wait_until(lock, _queue.top().due);
+        continue;
+      }
+
+      if (_in_flight >= _max_in_flight) {
+        _cv.wait(lock);
+        continue;
+      }
+
+      auto entry = _queue.top();
+      _queue.pop();
+
+      // Entries of removed, paused or rescheduled vehicles are dropped here rather than searched for
+      auto k = static_cast<size_t>(entry.kind);
+      auto it = _slots.find(entry.vin);
+      if (it == _slots.end() || !it->second.registered[k] ||
+          it->second.generation[k] != entry.generation || it->second.paused) {
+        continue;
+      }
+      auto &slot = it->second;
+
+      // Keep the vehicle's phase; after falling a whole interval behind, restart the cadence from now
+      auto interval = _interval(entry.vin, entry.kind);
+      auto next = entry.due + interval;
+      if (next <= now) {
+        next = now + interval;
+      }
+      _push(entry.vin, entry.kind, next);
+
+      if (slot.in_flight[k]) {
+        continue;
+      }
+      slot.in_flight[k] = true;
+      ++_in_flight;
+
+      _running.push_back(std::async(std::launch::async, [this, vin = entry.vin, kind = entry.kind, k]() {
+        try {
+          _job(vin, kind);
+        } catch (const std::exception &e) {
+          SUBARULINK_LOG_WARN("Scheduled poll failed for VIN ", vin, ": ", e.what());
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _slots.find(vin);
+        if (it != _slots.end()) {
+          it->second.in_flight[k] = false;
+        }
+        --_in_flight;
+        _cv.notify_all();
+      }));
+    }
+  }
+
+  void PollScheduler::_push(const std::string &vin, PollKind kind, Clock::time_point due) {
+    auto k = static_cast<size_t>(kind);
+    _queue.push(Entry{due, vin, kind, _slots[vin].generation[k]});
+  }
+
+  PollScheduler::Clock::duration PollScheduler::_jitter(const std::string &vin, PollKind kind) {
+    auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(_interval(vin, kind)).count();
+    if (interval <= 0) {
+      return Clock::duration::zero();
+    }
+    std::uniform_int_distribution<long long> phase(0, interval - 1);
+    return std::chrono::milliseconds(phase(_random));
+  }
+
+  PollScheduler::Clock::duration PollScheduler::_interval(const std::string &vin, PollKind kind) const {
+    return std::chrono::seconds(std::max(1, _interval_function(vin, kind)));
+  }
+
+  void PollScheduler::_reap() {
+    for (auto it = _running.begin(); it != _running.end();) {
+      if (it->wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        it = _running.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+} // namespace subarulink
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <thread>
+
+#include "rate_limiter.h"
+
+namespace subarulink {
+
+  RateLimiter::RateLimiter(double rate, double burst)
+      : _rate(std::max(0.0, rate)),
+        _burst(std::max(1.0, burst)),
+        _tokens(std::max(1.0, burst)),
+        _last(Clock::now()) {}
+
+  void RateLimiter::set_rate(double rate, double burst) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _refill(Clock::now());
+    _rate = std::max(0.0, rate);
+    _burst = std::max(1.0, burst);
+    _tokens = std::min(_tokens, _burst);
+  }
+
+  double RateLimiter::get_rate() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _rate;
+  }
+
+  void RateLimiter::acquire() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_rate > 0.0) {
+      _refill(Clock::now());
+      if (_tokens >= 1.0) {
+        _tokens -= 1.0;
+        return;
+      }
+
+      // Sleep until the next token is due; the rate may change meanwhile, so re-check after
+      auto wait = std::chrono::duration<double>((1.0 - _tokens) / _rate);
+      lock.unlock();
+      std::this_thread::sleep_for(wait);
+      lock.lock();
+    }
+  }
+
+  bool RateLimiter::try_acquire() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_rate <= 0.0) {
+      return true;
+    }
+    _refill(Clock::now());
+    if (_tokens >= 1.0) {
+      _tokens -= 1.0;
+      return true;
+    }
+    return false;
+  }
+
+  void RateLimiter::_refill(Clock::time_point now) {
+    std::chrono::duration<double> elapsed = now - _last;
+    _tokens = std::min(_burst, _tokens + elapsed.count() * _rate);
+    _last = now;
+  }
+
+} // namespace subarulink
@@ -0,0 +1,133 @@
+#include "remote_command.h"
+
+namespace subarulink {
+
+  bool is_final(RemoteCommandState state) {
+    return state == RemoteCommandState::SUCCEEDED ||
+           state == RemoteCommandState::FAILED ||
+           state == RemoteCommandState::CANCELLED;
+  }
+
+  RemoteCommand::RemoteCommand(std::string vin, std::string command, std::string poll_url, nlohmann::json data,
+                               std::function<void()> prepare)
+      : _vin(std::move(vin)),
+        _command(std::move(command)),
+        _poll_url(std::move(poll_url)),
+        _data(std::move(data)),
+        _prepare(std::move(prepare)),
+        _trace_context(Tracer::current()),
+        _queued_at(std::chrono::steady_clock::now()),
+        _history{{RemoteCommandState::QUEUED, std::chrono::system_clock::now()}},
+        _result(_promise.get_future().share()) {}
+
+  RemoteCommandState RemoteCommand::state() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _history.back().state;
+  }
+
+  std::vector<RemoteCommand::Transition> RemoteCommand::history() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _history;
+  }
+
+  std::string RemoteCommand::service_request_id() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _req_id;
+  }
+
+  bool RemoteCommand::cancel_requested() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _cancel_requested;
+  }
+
+  bool RemoteCommand::transition(RemoteCommandState state, const std::string &req_id) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (is_final(_history.back().state)) {
+      return false;
+    }
+    if (!req_id.empty()) {
+      _req_id = req_id;
+    }
+    // A retry re-enters QUEUED; repeating the current state adds nothing
+    if (_history.back().state != state) {
+      _history.push_back({state, std::chrono::system_clock::now()});
+    }
+    return true;
+  }
+
+  bool RemoteCommand::request_cancel() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (is_final(_history.back().state)) {
+      return false;
+    }
+    if (!_cancel_requested && _on_cancel) {
+      _on_cancel();
+    }
+    _cancel_requested = true;
+    return true;
+  }
+
+  void RemoteCommand::on_cancel(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _on_cancel = std::move(callback);
+    if (_on_cancel && _cancel_requested) {
+      _on_cancel();
+    }
+  }
+
+  bool RemoteCommand::begin_server_cancel() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_server_cancel) {
+      return false;
+    }
+    _server_cancel = true;
+    return true;
+  }
+
+  void RemoteCommand::prepare() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_prepared || !_prepare) {
+        return;
+      }
+    }
+    // Only the command's own queue sends it, so the step never runs concurrently
+    _prepare();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _prepared = true;
+  }
+
+  void RemoteCommand::complete(Result result) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_completed) {
+      _completed = true;
+      _promise.set_value(std::move(result));
+    }
+  }
+
+  void RemoteCommand::fail(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_completed) {
+      _completed = true;
+      _promise.set_exception(error);
+    }
+  }
+
+  CommandHandle::CommandHandle(std::shared_ptr<RemoteCommand> command, Canceller canceller)
+      : _command(std::move(command)),
+        _canceller(std::move(canceller)) {}
+
+  bool CommandHandle::wait() const {
+    return std::get<0>(_command->result().get());
+  }
+
+  std::future<bool> CommandHandle::cancel() const {
+    if (!_command || !_canceller) {
+      std::promise<bool> none;
+      none.set_value(false);
+      return none.get_future();
+    }
+    return _canceller(_command);
+  }
+
+} // namespace subarulink
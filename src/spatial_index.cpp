@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "spatial_index.h"
+
+namespace subarulink {
+
+  namespace {
+    constexpr double EARTH_RADIUS_M = 6371008.8;
+    constexpr double METERS_PER_DEGREE = EARTH_RADIUS_M * M_PI / 180.0;
+
+    // Bounding box of a circle, widened to every longitude near the poles
+    void radius_bounds(const GeoPoint &center, double radius_m, GeoPoint &south_west, GeoPoint &north_east) {
+      double dlat = radius_m / METERS_PER_DEGREE;
+      double cos_lat = std::cos(center.latitude * M_PI / 180.0);
+      double dlon = cos_lat > 1e-9 ? dlat / cos_lat : 360.0;
+
+      south_west.latitude = std::max(-90.0, center.latitude - dlat);
+      north_east.latitude = std::min(90.0, center.latitude + dlat);
+      if (dlon >= 180.0 || south_west.latitude <= -90.0 || north_east.latitude >= 90.0) {
+        south_west.longitude = -180.0;
+        north_east.longitude = 180.0;
+      } else {
+        south_west.longitude = std::max(-180.0, center.longitude - dlon);
+        north_east.longitude = std::min(180.0, center.longitude + dlon);
+      }
+    }
+
+    bool in_box(const GeoPoint &point, const GeoPoint &south_west, const GeoPoint &north_east) {
+      return point.latitude >= south_west.latitude && point.latitude <= north_east.latitude &&
+             point.longitude >= south_west.longitude && point.longitude <= north_east.longitude;
+    }
+
+    // Even-odd ray casting with longitude as x and latitude as y
+    bool in_polygon(const GeoPoint &point, const std::vector<GeoPoint> &vertices) {
+      bool inside = false;
+      for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+        const auto &a = vertices[i];
+        const auto &b = vertices[j];
+        if ((a.latitude > point.latitude) != (b.latitude > point.latitude)) {
+          double crossing = a.longitude + (point.latitude - a.latitude) * (b.longitude - a.longitude) /
+                                          (b.latitude - a.latitude);
+          if (point.longitude < crossing) {
+            inside = !inside;
+          }
+        }
+      }
+      return inside;
+    }
+
+    void polygon_bounds(const std::vector<GeoPoint> &vertices, GeoPoint &south_west, GeoPoint &north_east) {
+      south_west = north_east = vertices.front();
+      for (const auto &vertex: vertices) {
+        south_west.latitude = std::min(south_west.latitude, vertex.latitude);
+        south_west.longitude = std::min(south_west.longitude, vertex.longitude);
+        north_east.latitude = std::max(north_east.latitude, vertex.latitude);
+        north_east.longitude = std::max(north_east.longitude, vertex.longitude);
+      }
+    }
+
+    uint32_t grid_index(double value, double min, double span, int bits) {
+      auto cells = static_cast<double>(uint64_t(1) << bits);
+      auto index = std::floor((value - min) / span * cells);
+      return static_cast<uint32_t>(std::clamp(index, 0.0, cells - 1));
+    }
+  }
+
+  double distance_meters(const GeoPoint &a, const GeoPoint &b) {
+    double lat1 = a.latitude * M_PI / 180.0;
+    double lat2 = b.latitude * M_PI / 180.0;
+    double dlat = lat2 - lat1;
+    double dlon = (b.longitude - a.longitude) * M_PI / 180.0;
+    double h = std::sin(dlat / 2) * std::sin(dlat / 2) +
+               std::cos(lat1) * std::cos(lat2) * std::sin(dlon / 2) * std::sin(dlon / 2);
+    return 2 * EARTH_RADIUS_M * std::asin(std::min(1.0, std::sqrt(h)));
+  }
+
+  Geofence Geofence::circle(const std::string &id, const GeoPoint &center, double radius_m) {
+    Geofence fence;
+    fence.id = id;
+    fence.shape = Shape::CIRCLE;
+    fence.center = center;
+    fence.radius_m = radius_m;
+    radius_bounds(center, radius_m, fence.south_west, fence.north_east);
+    return fence;
+  }
+
+  Geofence Geofence::box(const std::string &id, const GeoPoint &south_west, const GeoPoint &north_east) {
+    Geofence fence;
+    fence.id = id;
+    fence.shape = Shape::BOX;
+    fence.south_west = {std::min(south_west.latitude, north_east.latitude),
+                        std::min(south_west.longitude, north_east.longitude)};
+    fence.north_east = {std::max(south_west.latitude, north_east.latitude),
+                        std::max(south_west.longitude, north_east.longitude)};
+    return fence;
+  }
+
+  Geofence Geofence::polygon(const std::string &id, const std::vector<GeoPoint> &vertices) {
+    if (vertices.size() < 3) {
+      throw std::invalid_argument("Geofence polygon needs at least three vertices");
+    }
+    Geofence fence;
+    fence.id = id;
+    fence.shape = Shape::POLYGON;
+    fence.vertices = vertices;
+    polygon_bounds(vertices, fence.south_west, fence.north_east);
+    return fence;
+  }
+
+  bool Geofence::contains(const GeoPoint &point) const {
+    if (!in_box(point, south_west, north_east)) {
+      return false;
+    }
+    switch (shape) {
+      case Shape::CIRCLE:
+        return distance_meters(center, point) <= radius_m;
+      case Shape::BOX:
+        return true;
+      case Shape::POLYGON:
+        return in_polygon(point, vertices);
+    }
+    return false;
+  }
+
+  SpatialIndex::SpatialIndex(int precision) {
+    auto bits = 5 * std::clamp(precision, 1, 12);
+    _lon_bits = (bits + 1) / 2;
+    _lat_bits = bits / 2;
+  }
+
+  std::vector<SpatialIndex::Crossing> SpatialIndex::update(const std::string &vin, const GeoPoint &position) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto cell = _cell(position);
+
+    auto previous = _positions.find(vin);
+    bool known = previous != _positions.end();
+    if (known) {
+      auto old_cell = _cell(previous->second);
+      if (old_cell != cell) {
+        auto occupants = _cells.find(old_cell);
+        occupants->second.erase(vin);
+        if (occupants->second.empty()) {
+          _cells.erase(occupants);
+        }
+      }
+    }
+    _positions[vin] = position;
+    _cells[cell].insert(vin);
+
+    auto now_inside = _fences_at(position);
+    auto &was_inside = _inside[vin];
+    std::vector<Crossing> crossings;
+    if (known) {
+      for (const auto &id: was_inside) {
+        if (!now_inside.count(id)) {
+          crossings.push_back({id, false});
+        }
+      }
+      for (const auto &id: now_inside) {
+        if (!was_inside.count(id)) {
+          crossings.push_back({id, true});
+        }
+      }
+    }
+    was_inside = std::move(now_inside);
+    return crossings;
+  }
+
+  bool SpatialIndex::remove(const std::string &vin) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _positions.find(vin);
+    if (it == _positions.end()) {
+      return false;
+    }
+    auto occupants = _cells.find(_cell(it->second));
+    occupants->second.erase(vin);
+    if (occupants->second.empty()) {
+      _cells.erase(occupants);
+    }
+    _positions.erase(it);
+    _inside.erase(vin);
+    return true;
+  }
+
+  std::optional<GeoPoint> SpatialIndex::position(const std::string &vin) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _positions.find(vin);
+    if (it == _positions.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  std::vector<std::string> SpatialIndex::within_radius(const GeoPoint &center, double radius_m) const {
+    GeoPoint south_west, north_east;
+    radius_bounds(center, radius_m, south_west, north_east);
+
+    std::vector<std::pair<double, std::string>> found;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (auto &vin: _candidates(south_west, north_east)) {
+        auto distance = distance_meters(center, _positions.at(vin));
+        if (distance <= radius_m) {
+          found.emplace_back(distance, std::move(vin));
+        }
+      }
+    }
+
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> vins;
+    vins.reserve(found.size());
+    for (auto &[distance, vin]: found) {
+      vins.push_back(std::move(vin));
+    }
+    return vins;
+  }
+
+  std::vector<std::string> SpatialIndex::within_box(const GeoPoint &south_west, const GeoPoint &north_east) const {
+    auto fence = Geofence::box("", south_west, north_east);
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::string> vins;
+    for (auto &vin: _candidates(fence.south_west, fence.north_east)) {
+      if (in_box(_positions.at(vin), fence.south_west, fence.north_east)) {
+        vins.push_back(std::move(vin));
+      }
+    }
+    std::sort(vins.begin(), vins.end());
+    return vins;
+  }
+
+  std::vector<std::string> SpatialIndex::within_polygon(const std::vector<GeoPoint> &vertices) const {
+    auto fence = Geofence::polygon("", vertices);
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::string> vins;
+    for (auto &vin: _candidates(fence.south_west, fence.north_east)) {
+      if (fence.contains(_positions.at(vin))) {
+        vins.push_back(std::move(vin));
+      }
+    }
+    std::sort(vins.begin(), vins.end());
+    return vins;
+  }
+
+  void SpatialIndex::add_fence(const Geofence &fence) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &[vin, fences]: _inside) {
+      fences.erase(fence.id);
+    }
+    _fences[fence.id] = fence;
+    for (const auto &vin: _candidates(fence.south_west, fence.north_east)) {
+      if (fence.contains(_positions.at(vin))) {
+        _inside[vin].insert(fence.id);
+      }
+    }
+  }
+
+  bool SpatialIndex::remove_fence(const std::string &id) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_fences.erase(id) == 0) {
+      return false;
+    }
+    for (auto &[vin, fences]: _inside) {
+      fences.erase(id);
+    }
+    return true;
+  }
+
+  std::vector<Geofence> SpatialIndex::fences() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<Geofence> fences;
+    fences.reserve(_fences.size());
+    for (const auto &[id, fence]: _fences) {
+      fences.push_back(fence);
+    }
+    return fences;
+  }
+
+  std::vector<std::string> SpatialIndex::members(const std::string &id) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::string> vins;
+    for (const auto &[vin, fences]: _inside) {
+      if (fences.count(id)) {
+        vins.push_back(vin);
+      }
+    }
+    return vins;
+  }
+
+  std::vector<std::string> SpatialIndex::fences_containing(const std::string &vin) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _inside.find(vin);
+    if (it == _inside.end()) {
+      return {};
+    }
+    return {it->second.begin(), it->second.end()};
+  }
+
+  SpatialIndex::CellKey SpatialIndex::_cell(const GeoPoint &point) const {
+    CellKey lat = grid_index(point.latitude, -90.0, 180.0, _lat_bits);
+    CellKey lon = grid_index(point.longitude, -180.0, 360.0, _lon_bits);
+    return (lat << 32) | lon;
+  }
+
+  std::vector<std::string> SpatialIndex::_candidates(const GeoPoint &south_west, const GeoPoint &north_east) const {
+    uint64_t lat_min = grid_index(south_west.latitude, -90.0, 180.0, _lat_bits);
+    uint64_t lat_max = grid_index(north_east.latitude, -90.0, 180.0, _lat_bits);
+    uint64_t lon_min = grid_index(south_west.longitude, -180.0, 360.0, _lon_bits);
+    uint64_t lon_max = grid_index(north_east.longitude, -180.0, 360.0, _lon_bits);
+
+    std::vector<std::string> vins;
+    auto add = [&vins](const std::set<std::string> &occupants) {
+      vins.insert(vins.end(), occupants.begin(), occupants.end());
+    };
+
+    // Walk the covered cells, or the occupied ones when the area spans more cells than are occupied
+    auto covered = (lat_max - lat_min + 1) * (lon_max - lon_min + 1);
+    if (covered <= _cells.size()) {
+      for (auto lat = lat_min; lat <= lat_max; ++lat) {
+        for (auto lon = lon_min; lon <= lon_max; ++lon) {
+          auto occupants = _cells.find((lat << 32) | lon);
+          if (occupants != _cells.end()) {
+            add(occupants->second);
+          }
+        }
+      }
+    } else {
+      for (const auto &[key, occupants]: _cells) {
+        auto lat = key >> 32;
+        auto lon = key & 0xFFFFFFFFu;
+        if (lat >= lat_min && lat <= lat_max && lon >= lon_min && lon <= lon_max) {
+          add(occupants);
+        }
+      }
+    }
+    return vins;
+  }
+
+  std::set<std::string> SpatialIndex::_fences_at(const GeoPoint &point) const {
+    std::set<std::string> inside;
+    for (const auto &[id, fence]: _fences) {
+      if (fence.contains(point)) {
+        inside.insert(id);
+      }
+    }
+    return inside;
+  }
+
+} // namespace subarulink
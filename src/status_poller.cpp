@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <map>
+
+#include "status_poller.h"
+#include "remote_command.h"
+#include "exceptions.h"
+#include "logger.h"
+#include "metrics.h"
+
+namespace subarulink {
+
+  StatusPoller::StatusPoller(PollFunction poll, size_t workers)
+      : _poll(std::move(poll)), _worker_count(std::max<size_t>(workers, 1)) {}
+
+  StatusPoller::~StatusPoller() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _cv.notify_all();
+    _work_cv.notify_all();
+    if (_thread.joinable()) {
+      _thread.join();
+    }
+    for (auto &worker: _workers) {
+      worker.join();
+    }
+
+    // Workers finish their current poll and leave the rest of their batch
+    for (auto &request: _in_flight) {
+      if (!request->cancelled) {
+        _requests.push_back(std::move(request));
+      }
+    }
+    for (auto &request: _requests) {
+      request->promise.set_exception(std::make_exception_ptr(SubaruException("Remote service polling stopped")));
+    }
+  }
+
+  std::future<StatusPoller::Result> StatusPoller::watch(const std::string &vin,
+                                                        const std::string &req_id,
+                                                        const std::string &poll_url,
+                                                        const PollSchedule &schedule) {
+    auto request = std::make_unique<Request>();
+    request->vin = vin;
+    request->req_id = req_id;
+    request->poll_url = poll_url;
+    request->attempts_left = schedule.attempts;
+    request->schedule = schedule;
+    request->interval = schedule.interval;
+    request->due = Clock::now() + schedule.first_delay;
+    auto result = request->promise.get_future();
+
+    if (schedule.attempts <= 0) {
+      request->promise.set_value(std::make_tuple(false, nlohmann::json()));
+      return result;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _requests.push_back(std::move(request));
+      if (!_thread.joinable()) {
+        _thread = std::thread(&StatusPoller::_run, this);
+        for (size_t i = 0; i < _worker_count; ++i) {
+          _workers.emplace_back(&StatusPoller::_work, this);
+        }
+      }
+    }
+    _cv.notify_all();
+    return result;
+  }
+
+  bool StatusPoller::cancel(const std::string &req_id) {
+    std::unique_ptr<Request> cancelled;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto in_flight = std::find_if(_in_flight.begin(), _in_flight.end(), [&req_id](const auto &request) {
+        return request->req_id == req_id && !request->cancelled;
+      });
+      if (in_flight != _in_flight.end()) {
+        // The loop discards its response when the poll returns
+        (*in_flight)->cancelled = true;
+        _cancel(**in_flight);
+        return true;
+      }
+
+      auto it = std::find_if(_requests.begin(), _requests.end(),
+                             [&req_id](const auto &request) { return request->req_id == req_id; });
+      if (it == _requests.end()) {
+        return false;
+      }
+      cancelled = std::move(*it);
+      _requests.erase(it);
+    }
+    _cancel(*cancelled);
+    return true;
+  }
+
+  size_t StatusPoller::pending() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _requests.size() + std::count_if(_in_flight.begin(), _in_flight.end(),
+                                            [](const auto &request) { return !request->cancelled; });
+  }
+
+  void StatusPoller::_run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping) {
+      // Apply finished polls first; their responses are already in hand
+      if (!_completed.empty()) {
+        auto completed = std::move(_completed);
+        _completed.clear();
+        for (auto *done: completed) {
+          auto it = std::find_if(_in_flight.begin(), _in_flight.end(),
+                                 [done](const auto &request) { return request.get() == done; });
+          auto request = std::move(*it);
+          _in_flight.erase(it);
+          if (request->cancelled || _handle(*request)) {
+            continue;
+          }
+          request->due = Clock::now() + request->interval;
+          auto grown = std::chrono::duration_cast<std::chrono::milliseconds>(request->interval * request->schedule.backoff);
+          request->interval = std::min(std::max(grown, request->interval), request->schedule.max_interval);
+          _requests.push_back(std::move(request));
+        }
+        continue;
+      }
+
+      // Queue every due poll, one batch per vehicle; each reports back through _completed
+      auto now = Clock::now();
+      std::map<std::string, std::vector<Request *>> due;
+      for (auto it = _requests.begin(); it != _requests.end();) {
+        if ((*it)->due <= now) {
+          (*it)->error = nullptr;
+          due[(*it)->vin].push_back(it->get());
+          _in_flight.push_back(std::move(*it));
+          it = _requests.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      if (!due.empty()) {
+        for (auto &[vin, batch]: due) {
+          _batches.push_back(std::move(batch));
+        }
+        _work_cv.notify_all();
+      }
+
+      if (_requests.empty()) {
+        _cv.wait(lock);
+        continue;
+      }
+      auto next = std::min_element(_requests.begin(), _requests.end(),
+                                   [](const auto &a, const auto &b) { return a->due < b->due; });
+      _cv.wait_until(lock, (*next)->due);
+    }
+  }
+
+  void StatusPoller::_work() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+      _work_cv.wait(lock, [this]() { return _stopping || _next_batch() != _batches.end(); });
+      if (_stopping) {
+        return;
+      }
+      auto next = _next_batch();
+      auto batch = std::move(*next);
+      _batches.erase(next);
+      const auto vin = batch.front()->vin;
+      _polling.insert(vin);
+      for (auto *request: batch) {
+        // The loop settles cancelled requests without a poll
+        if (!request->cancelled && !_stopping) {
+          lock.unlock();
+          try {
+            request->response = _poll(request->poll_url, request->req_id);
+          } catch (...) {
+            request->error = std::current_exception();
+          }
+          lock.lock();
+        }
+        _completed.push_back(request);
+        _cv.notify_all();
+      }
+      // A later batch for this vehicle may be waiting
+      _polling.erase(vin);
+      _work_cv.notify_all();
+    }
+  }
+
+  std::deque<std::vector<StatusPoller::Request *>>::iterator StatusPoller::_next_batch() {
+    return std::find_if(_batches.begin(), _batches.end(),
+                        [this](const auto &batch) { return !_polling.count(batch.front()->vin); });
+  }
+
+  void StatusPoller::_cancel(Request &request) {
+    request.promise.set_value(std::make_tuple(
+        false, nlohmann::json{{"success", false}, {"errorCode", RemoteCommand::CANCELLED}}));
+  }
+
+  bool StatusPoller::_handle(Request &request) {
+    --request.attempts_left;
+    try {
+      if (request.error) {
+        std::rethrow_exception(request.error);
+      }
+      auto &js_resp = request.response;
+      if (js_resp.contains("success") && js_resp["success"].get<bool>()) {
+        auto status = js_resp["data"]["remoteServiceState"].get<std::string>();
+
+        if (status == "SUCCESS") {
+          request.promise.set_value(std::make_tuple(true, js_resp));
+          return true;
+        } else if (status == "FAILED") {
+          request.promise.set_value(std::make_tuple(false, js_resp));
+          return true;
+        }
+      }
+    } catch (const SubaruException &e) {
+      if (std::string(e.what()).find("HTTP 500") == std::string::npos) {
+        request.promise.set_exception(std::current_exception());
+        return true;
+      }
+      // Server error, continue polling
+      SUBARULINK_LOG_WARN("Status poll for ", request.req_id, " failed, retrying: ", e.what());
+      Metrics::instance().count(MetricEvent::RETRY, "status_poll");
+    } catch (...) {
+      request.promise.set_exception(std::current_exception());
+      return true;
+    }
+
+    if (request.attempts_left <= 0) {
+      request.promise.set_value(std::make_tuple(false, nlohmann::json()));
+      return true;
+    }
+    return false;
+  }
+
+} // namespace subarulink
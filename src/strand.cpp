@@ -0,0 +1,48 @@
+#include "strand.h"
+
+namespace subarulink {
+
+  Strand::~Strand() {
+    std::future<void> worker;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      worker = std::move(_worker);
+    }
+    if (worker.valid()) {
+      worker.wait();
+    }
+  }
+
+  void Strand::_enqueue(std::function<void()> job) {
+    std::future<void> finished;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _jobs.push_back(std::move(job));
+      if (_draining) {
+        return;
+      }
+      _draining = true;
+      // The previous worker has already left its loop; release its future outside the lock
+      finished = std::move(_worker);
+      _worker = std::async(std::launch::async, [this]() { _drain(); });
+    }
+  }
+
+  void Strand::_drain() {
+    while (true) {
+      std::function<void()> job;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_jobs.empty()) {
+          _draining = false;
+          return;
+        }
+        job = std::move(_jobs.front());
+        _jobs.pop_front();
+      }
+      // packaged_task stores any exception in the task's future
+      job();
+    }
+  }
+
+} // namespace subarulink
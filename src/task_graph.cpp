@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "task_graph.h"
+#include "exceptions.h"
+#include "trace.h"
+
+namespace subarulink {
+
+  void TaskGraph::add(const std::string &name, Task task, const std::vector <std::string> &depends_on) {
+    auto find = [this](const std::string &node_name) {
+      return std::find_if(_nodes.begin(), _nodes.end(),
+                          [&node_name](const Node &node) { return node.name == node_name; });
+    };
+
+    if (find(name) != _nodes.end()) {
+      throw SubaruException("Duplicate task: " + name);
+    }
+
+    Node node{name, std::move(task), {}, {}};
+    for (const auto &dependency: depends_on) {
+      auto it = find(dependency);
+      if (it == _nodes.end()) {
+        throw SubaruException("Unknown task dependency: " + dependency);
+      }
+      node.dependencies.push_back(static_cast<size_t>(it - _nodes.begin()));
+    }
+    _nodes.push_back(std::move(node));
+  }
+
+  void TaskGraph::run() {
+    // Dependencies are always added first, so their futures exist by the time a dependent is launched
+    for (auto &node: _nodes) {
+      std::vector <std::shared_future<void>> prerequisites;
+      for (auto index: node.dependencies) {
+        prerequisites.push_back(_nodes[index].done);
+      }
+
+      node.done = std::async(std::launch::async, [prerequisites, task = node.task, name = node.name,
+                                                  context = Tracer::current()]() {
+        for (const auto &prerequisite: prerequisites) {
+          prerequisite.get();
+        }
+        TraceSpan span(name, context);
+        task();
+      }).share();
+    }
+
+    std::exception_ptr first_error;
+    for (auto &node: _nodes) {
+      try {
+        node.done.get();
+      } catch (...) {
+        if (!first_error) {
+          first_error = std::current_exception();
+        }
+      }
+    }
+
+    if (first_error) {
+      std::rethrow_exception(first_error);
+    }
+  }
+
+} // namespace subarulink
@@ -0,0 +1,554 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "timeseries_store.h"
+#include "exceptions.h"
+#include "logger.h"
+
+namespace subarulink {
+
+  namespace {
+    namespace fs = std::filesystem;
+
+    constexpr char SEGMENT_MAGIC[4] = {'S', 'L', 'T', 'S'};
+    constexpr uint32_t SEGMENT_VERSION = 1;
+    constexpr const char *SEGMENT_EXTENSION = ".seg";
+
+    struct SegmentHeader {
+      char magic[4];
+      uint32_t version;
+      uint64_t count;
+      int64_t first_time;
+      int64_t last_time;
+      uint64_t bits;
+    };
+
+    // Read-only view of a segment file for the length of one scan
+    class MappedFile {
+    public:
+      explicit MappedFile(const std::string &path) {
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        _contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        _data = _contents.data();
+        _size = _contents.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+          return;
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+          void *address = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+          if (address != MAP_FAILED) {
+            _data = static_cast<const uint8_t *>(address);
+            _size = static_cast<size_t>(info.st_size);
+          }
+        }
+        ::close(fd);
+#endif
+      }
+
+      ~MappedFile() {
+#ifndef _WIN32
+        if (_data) {
+          ::munmap(const_cast<uint8_t *>(_data), _size);
+        }
+#endif
+      }
+
+      MappedFile(const MappedFile &) = delete;
+      MappedFile &operator=(const MappedFile &) = delete;
+
+      const uint8_t *data() const { return _data; }
+      size_t size() const { return _size; }
+
+    private:
+#ifdef _WIN32
+      std::vector<uint8_t> _contents;
+#endif
+      const uint8_t *_data{nullptr};
+      size_t _size{0};
+    };
+
+    // Appends the low count bits of value, most significant first
+    void put_bits(std::vector<uint8_t> &bytes, size_t &bits, uint64_t value, int count) {
+      while (count > 0) {
+        if (bits % 8 == 0) {
+          bytes.push_back(0);
+        }
+        int free = 8 - static_cast<int>(bits % 8);
+        int take = std::min(free, count);
+        auto chunk = static_cast<uint8_t>((value >> (count - take)) & ((1u << take) - 1));
+        bytes.back() |= static_cast<uint8_t>(chunk << (free - take));
+        bits += static_cast<size_t>(take);
+        count -= take;
+      }
+    }
+
+    class BitReader {
+    public:
+      explicit BitReader(const uint8_t *data) : _data(data) {}
+
+      uint64_t read(int count) {
+        uint64_t value = 0;
+        while (count > 0) {
+          int available = 8 - static_cast<int>(_position % 8);
+          int take = std::min(available, count);
+          uint64_t chunk = (_data[_position / 8] >> (available - take)) & ((1u << take) - 1);
+          value = (value << take) | chunk;
+          _position += static_cast<size_t>(take);
+          count -= take;
+        }
+        return value;
+      }
+
+      bool bit() { return read(1) != 0; }
+
+    private:
+      const uint8_t *_data;
+      size_t _position{0};
+    };
+
+    int64_t sign_extend(uint64_t value, int bits) {
+      auto shift = 64 - bits;
+      return static_cast<int64_t>(value << shift) >> shift;
+    }
+
+    int leading_zeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+      return __builtin_clzll(value);
+#else
+      int zeros = 0;
+      for (uint64_t mask = uint64_t(1) << 63; !(value & mask); mask >>= 1) {
+        ++zeros;
+      }
+      return zeros;
+#endif
+    }
+
+    int trailing_zeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+      return __builtin_ctzll(value);
+#else
+      int zeros = 0;
+      for (; !(value & 1); value >>= 1) {
+        ++zeros;
+      }
+      return zeros;
+#endif
+    }
+
+    uint64_t to_bits(double value) {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      return bits;
+    }
+
+    double from_bits(uint64_t bits) {
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+
+    int64_t to_seconds(std::chrono::system_clock::time_point time) {
+      return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+    }
+
+    std::chrono::system_clock::time_point from_seconds(int64_t seconds) {
+      return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+    }
+  }
+
+  TimeSeriesStore::TimeSeriesStore(const std::string &directory)
+      : _directory(directory) {
+    if (_directory.empty()) {
+      return;
+    }
+    std::error_code error;
+    fs::create_directories(_directory, error);
+    if (error) {
+      throw SubaruException("Cannot create time series directory " + _directory + ": " + error.message());
+    }
+    _load();
+  }
+
+  TimeSeriesStore::~TimeSeriesStore() {
+    if (!_directory.empty()) {
+      flush();
+    }
+  }
+
+  bool TimeSeriesStore::append(const std::string &vin, const std::string &field,
+                               std::chrono::system_clock::time_point time, double value) {
+    auto seconds = to_seconds(time);
+    auto bits = to_bits(value);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    SeriesKey key{vin, field};
+    auto &series = _series[key];
+    auto &open = series.open;
+    if ((open.count > 0 && seconds <= open.last_time) ||
+        (open.count == 0 && !series.sealed.empty() && seconds <= series.sealed.back().last_time)) {
+      return false;
+    }
+
+    if (open.count == 0) {
+      // The first point of a segment is stored whole so each segment decodes alone
+      put_bits(open.bytes, open.bits, static_cast<uint64_t>(seconds), 64);
+      put_bits(open.bytes, open.bits, bits, 64);
+      open.first_time = seconds;
+      series.delta = 0;
+      series.leading = -1;
+    } else {
+      auto delta = seconds - open.last_time;
+      auto dod = delta - series.delta;
+      if (dod == 0) {
+        put_bits(open.bytes, open.bits, 0, 1);
+      } else if (dod >= -64 && dod <= 63) {
+        put_bits(open.bytes, open.bits, 0b10, 2);
+        put_bits(open.bytes, open.bits, static_cast<uint64_t>(dod), 7);
+      } else if (dod >= -256 && dod <= 255) {
+        put_bits(open.bytes, open.bits, 0b110, 3);
+        put_bits(open.bytes, open.bits, static_cast<uint64_t>(dod), 9);
+      } else if (dod >= -2048 && dod <= 2047) {
+        put_bits(open.bytes, open.bits, 0b1110, 4);
+        put_bits(open.bytes, open.bits, static_cast<uint64_t>(dod), 12);
+      } else {
+        put_bits(open.bytes, open.bits, 0b1111, 4);
+        put_bits(open.bytes, open.bits, static_cast<uint64_t>(dod), 64);
+      }
+      series.delta = delta;
+
+      auto xored = bits ^ series.value_bits;
+      if (xored == 0) {
+        put_bits(open.bytes, open.bits, 0, 1);
+      } else {
+        put_bits(open.bytes, open.bits, 1, 1);
+        int leading = std::min(leading_zeros(xored), 31);
+        int trailing = trailing_zeros(xored);
+        if (series.leading >= 0 && leading >= series.leading && trailing >= series.trailing) {
+          // Meaningful bits fit the previous window, so its position is not repeated
+          put_bits(open.bytes, open.bits, 0, 1);
+          put_bits(open.bytes, open.bits, xored >> series.trailing, 64 - series.leading - series.trailing);
+        } else {
+          auto length = 64 - leading - trailing;
+          put_bits(open.bytes, open.bits, 1, 1);
+          put_bits(open.bytes, open.bits, static_cast<uint64_t>(leading), 5);
+          put_bits(open.bytes, open.bits, static_cast<uint64_t>(length - 1), 6);
+          put_bits(open.bytes, open.bits, xored >> trailing, length);
+          series.leading = leading;
+          series.trailing = trailing;
+        }
+      }
+    }
+    series.value_bits = bits;
+    open.last_time = seconds;
+    ++open.count;
+    ++series.points;
+
+    if (open.count == SEGMENT_POINTS) {
+      _seal(key, series);
+    }
+    _trim(series);
+    return true;
+  }
+
+  std::vector<TimeSeriesPoint> TimeSeriesStore::range(const std::string &vin, const std::string &field,
+                                                      std::chrono::system_clock::time_point from,
+                                                      std::chrono::system_clock::time_point to) const {
+    auto first = to_seconds(from);
+    auto last = to_seconds(to);
+
+    std::vector<TimeSeriesPoint> points;
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto series = _series.find({vin, field});
+    if (series == _series.end()) {
+      return points;
+    }
+
+    auto visit = [&points](int64_t time, double value) {
+      points.push_back({from_seconds(time), value});
+    };
+    for (const auto &segment: series->second.sealed) {
+      _scan(segment, first, last, visit);
+    }
+    _scan(series->second.open, first, last, visit);
+    return points;
+  }
+
+  std::vector<TimeSeriesBucket> TimeSeriesStore::downsample(const std::string &vin, const std::string &field,
+                                                            std::chrono::system_clock::time_point from,
+                                                            std::chrono::system_clock::time_point to,
+                                                            std::chrono::seconds width) const {
+    auto first = to_seconds(from);
+    auto last = to_seconds(to);
+    auto step = std::max<int64_t>(width.count(), 1);
+
+    std::vector<TimeSeriesBucket> buckets;
+    std::vector<double> sums;
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto series = _series.find({vin, field});
+    if (series == _series.end()) {
+      return buckets;
+    }
+
+    // Points arrive oldest first, so a point either extends the last bucket or opens a new one
+    auto visit = [&](int64_t time, double value) {
+      auto start = first + (time - first) / step * step;
+      if (buckets.empty() || buckets.back().start != from_seconds(start)) {
+        buckets.push_back({from_seconds(start), 0, value, value, 0.0});
+        sums.push_back(0.0);
+      }
+      auto &bucket = buckets.back();
+      ++bucket.count;
+      bucket.min = std::min(bucket.min, value);
+      bucket.max = std::max(bucket.max, value);
+      sums.back() += value;
+    };
+    for (const auto &segment: series->second.sealed) {
+      _scan(segment, first, last, visit);
+    }
+    _scan(series->second.open, first, last, visit);
+
+    for (size_t i = 0; i < buckets.size(); ++i) {
+      buckets[i].avg = sums[i] / static_cast<double>(buckets[i].count);
+    }
+    return buckets;
+  }
+
+  std::vector<std::string> TimeSeriesStore::fields(const std::string &vin) const {
+    std::vector<std::string> names;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _series.lower_bound({vin, ""}); it != _series.end() && it->first.first == vin; ++it) {
+      names.push_back(it->first.second);
+    }
+    return names;
+  }
+
+  size_t TimeSeriesStore::size(const std::string &vin, const std::string &field) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto series = _series.find({vin, field});
+    return series == _series.end() ? 0 : series->second.points;
+  }
+
+  void TimeSeriesStore::set_retention(const TimeSeriesRetention &retention) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _retention = retention;
+    for (auto &[key, series]: _series) {
+      _trim(series);
+    }
+  }
+
+  TimeSeriesRetention TimeSeriesStore::get_retention() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _retention;
+  }
+
+  void TimeSeriesStore::flush() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &[key, series]: _series) {
+      _seal(key, series);
+    }
+  }
+
+  size_t TimeSeriesStore::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bytes = 0;
+    for (const auto &[key, series]: _series) {
+      bytes += sizeof(Series) + series.open.bytes.capacity();
+      for (const auto &segment: series.sealed) {
+        bytes += sizeof(Segment) + segment.bytes.capacity() + segment.path.capacity();
+      }
+    }
+    return bytes;
+  }
+
+  const std::string &TimeSeriesStore::directory() const {
+    return _directory;
+  }
+
+  template<typename Visitor>
+  void TimeSeriesStore::_scan(const Segment &segment, int64_t first, int64_t last, Visitor visit) {
+    if (segment.count == 0 || segment.last_time < first || segment.first_time > last) {
+      return;
+    }
+
+    std::unique_ptr<MappedFile> file;
+    const uint8_t *data = segment.bytes.data();
+    if (!segment.path.empty()) {
+      file = std::make_unique<MappedFile>(segment.path);
+      if (file->size() < sizeof(SegmentHeader) + (segment.bits + 7) / 8) {
+        SUBARULINK_LOG_WARN("Time series segment ", segment.path, " is missing or truncated");
+        return;
+      }
+      data = file->data() + sizeof(SegmentHeader);
+    }
+
+    BitReader in(data);
+    int64_t time = 0;
+    int64_t delta = 0;
+    uint64_t bits = 0;
+    int leading = 0;
+    int trailing = 0;
+    for (size_t i = 0; i < segment.count; ++i) {
+      if (i == 0) {
+        time = static_cast<int64_t>(in.read(64));
+        bits = in.read(64);
+      } else {
+        int64_t dod = 0;
+        if (!in.bit()) {
+          dod = 0;
+        } else if (!in.bit()) {
+          dod = sign_extend(in.read(7), 7);
+        } else if (!in.bit()) {
+          dod = sign_extend(in.read(9), 9);
+        } else if (!in.bit()) {
+          dod = sign_extend(in.read(12), 12);
+        } else {
+          dod = static_cast<int64_t>(in.read(64));
+        }
+        delta += dod;
+        time += delta;
+
+        if (in.bit()) {
+          if (in.bit()) {
+            leading = static_cast<int>(in.read(5));
+            trailing = 64 - leading - (static_cast<int>(in.read(6)) + 1);
+          }
+          bits ^= in.read(64 - leading - trailing) << trailing;
+        }
+      }
+
+      if (time > last) {
+        return;
+      }
+      if (time >= first) {
+        visit(time, from_bits(bits));
+      }
+    }
+  }
+
+  void TimeSeriesStore::_seal(const SeriesKey &key, Series &series) const {
+    auto &open = series.open;
+    if (open.count == 0) {
+      return;
+    }
+
+    if (!_directory.empty()) {
+      auto folder = fs::path(_directory) / key.first / key.second;
+      auto path = folder / (std::to_string(open.first_time) + SEGMENT_EXTENSION);
+      std::error_code error;
+      fs::create_directories(folder, error);
+
+      SegmentHeader header{};
+      std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+      header.version = SEGMENT_VERSION;
+      header.count = open.count;
+      header.first_time = open.first_time;
+      header.last_time = open.last_time;
+      header.bits = open.bits;
+
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      out.write(reinterpret_cast<const char *>(open.bytes.data()), static_cast<std::streamsize>(open.bytes.size()));
+      out.close();
+      if (!error && out) {
+        open.path = path.string();
+        std::vector<uint8_t>().swap(open.bytes);
+      } else {
+        // Kept in memory instead; the points are still queryable, just not persisted
+        SUBARULINK_LOG_WARN("Failed to write time series segment ", path.string());
+      }
+    }
+
+    open.bytes.shrink_to_fit();
+    series.sealed.push_back(std::move(open));
+    series.open = Segment();
+    series.delta = 0;
+    series.value_bits = 0;
+    series.leading = -1;
+    series.trailing = 0;
+  }
+
+  void TimeSeriesStore::_trim(Series &series) const {
+    auto newest = series.open.count > 0 ? series.open.last_time :
+                  series.sealed.empty() ? 0 : series.sealed.back().last_time;
+    auto max_age = _retention.max_age.count();
+
+    while (!series.sealed.empty()) {
+      const auto &oldest = series.sealed.front();
+      bool over_points = _retention.max_points > 0 && series.points - oldest.count >= _retention.max_points;
+      bool too_old = max_age > 0 && oldest.last_time < newest - max_age;
+      if (!over_points && !too_old) {
+        break;
+      }
+      series.points -= oldest.count;
+      _drop(series.sealed.front());
+      series.sealed.pop_front();
+    }
+  }
+
+  void TimeSeriesStore::_drop(Segment &segment) {
+    if (!segment.path.empty()) {
+      std::error_code error;
+      fs::remove(segment.path, error);
+    }
+  }
+
+  void TimeSeriesStore::_load() {
+    std::error_code error;
+    for (const auto &vin: fs::directory_iterator(_directory, error)) {
+      if (!vin.is_directory()) {
+        continue;
+      }
+      for (const auto &field: fs::directory_iterator(vin.path(), error)) {
+        if (!field.is_directory()) {
+          continue;
+        }
+        SeriesKey key{vin.path().filename().string(), field.path().filename().string()};
+        auto &series = _series[key];
+        for (const auto &file: fs::directory_iterator(field.path(), error)) {
+          if (file.path().extension() != SEGMENT_EXTENSION) {
+            continue;
+          }
+          SegmentHeader header{};
+          std::ifstream in(file.path(), std::ios::binary);
+          in.read(reinterpret_cast<char *>(&header), sizeof(header));
+          if (!in || std::memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) != 0 ||
+              header.version != SEGMENT_VERSION || header.count == 0 ||
+              file.file_size() < sizeof(header) + (header.bits + 7) / 8) {
+            SUBARULINK_LOG_WARN("Skipping unreadable time series segment ", file.path().string());
+            continue;
+          }
+
+          Segment segment;
+          segment.first_time = header.first_time;
+          segment.last_time = header.last_time;
+          segment.count = static_cast<size_t>(header.count);
+          segment.bits = static_cast<size_t>(header.bits);
+          segment.path = file.path().string();
+          series.points += segment.count;
+          series.sealed.push_back(std::move(segment));
+        }
+        if (series.sealed.empty()) {
+          _series.erase(key);
+          continue;
+        }
+        std::sort(series.sealed.begin(), series.sealed.end(),
+                  [](const Segment &a, const Segment &b) { return a.first_time < b.first_time; });
+      }
+    }
+  }
+
+} // namespace subarulink
@@ -0,0 +1,110 @@
+#include <cctype>
+
+#include "timestamp.h"
+
+namespace subarulink {
+
+  namespace {
+
+    // Reads exactly count digits starting at pos
+    bool read_digits(const std::string &value, size_t &pos, size_t count, int &out) {
+      if (pos + count > value.size()) {
+        return false;
+      }
+      out = 0;
+      for (size_t i = 0; i < count; ++i) {
+        char c = value[pos + i];
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+          return false;
+        }
+        out = out * 10 + (c - '0');
+      }
+      pos += count;
+      return true;
+    }
+
+    bool expect(const std::string &value, size_t &pos, char c) {
+      if (pos < value.size() && value[pos] == c) {
+        ++pos;
+        return true;
+      }
+      return false;
+    }
+
+    // Days since 1970-01-01 for a proleptic Gregorian date
+    long days_from_civil(int y, int m, int d) {
+      y -= m <= 2;
+      const long era = (y >= 0 ? y : y - 399) / 400;
+      const long yoe = y - era * 400;
+      const long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+      const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+      return era * 146097 + doe - 719468;
+    }
+
+  } // namespace
+
+  std::optional <std::chrono::system_clock::time_point> parse_api_timestamp(const std::string &value) {
+    size_t pos = 0;
+    int year, month, day, hour, minute, second = 0, millis = 0;
+
+    if (!read_digits(value, pos, 4, year) || !expect(value, pos, '-') ||
+        !read_digits(value, pos, 2, month) || !expect(value, pos, '-') ||
+        !read_digits(value, pos, 2, day) || !expect(value, pos, 'T') ||
+        !read_digits(value, pos, 2, hour) || !expect(value, pos, ':') ||
+        !read_digits(value, pos, 2, minute)) {
+      return std::nullopt;
+    }
+
+    if (expect(value, pos, ':') && !read_digits(value, pos, 2, second)) {
+      return std::nullopt;
+    }
+
+    if (expect(value, pos, '.')) {
+      // Keep millisecond precision and ignore any further digits
+      size_t start = pos;
+      while (pos < value.size() && std::isdigit(static_cast<unsigned char>(value[pos]))) {
+        if (pos - start < 3) {
+          millis = millis * 10 + (value[pos] - '0');
+        }
+        ++pos;
+      }
+      for (size_t i = pos - start; i < 3; ++i) {
+        millis *= 10;
+      }
+    }
+
+    int offset_minutes = 0;
+    if (!expect(value, pos, 'Z')) {
+      int sign = 0;
+      if (expect(value, pos, '+')) {
+        sign = 1;
+      } else if (expect(value, pos, '-')) {
+        sign = -1;
+      } else {
+        return std::nullopt;
+      }
+
+      int offset_hours, offset_mins;
+      if (!read_digits(value, pos, 2, offset_hours)) {
+        return std::nullopt;
+      }
+      expect(value, pos, ':');
+      if (!read_digits(value, pos, 2, offset_mins)) {
+        return std::nullopt;
+      }
+      offset_minutes = sign * (offset_hours * 60 + offset_mins);
+    }
+
+    if (pos != value.size() || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour > 23 || minute > 59 || second > 60) {
+      return std::nullopt;
+    }
+
+    long long seconds = days_from_civil(year, month, day) * 86400LL +
+                        hour * 3600LL + minute * 60LL + second - offset_minutes * 60LL;
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::seconds(seconds) + std::chrono::milliseconds(millis)));
+  }
+
+} // namespace subarulink
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <unordered_map>
+
+#include "nlohmann/json.hpp"
+#include "trace.h"
+
+namespace subarulink {
+
+  namespace {
+    thread_local TraceContext current_context;
+
+    uint32_t thread_number() {
+      static std::atomic<uint32_t> next{1};
+      thread_local uint32_t number = next.fetch_add(1, std::memory_order_relaxed);
+      return number;
+    }
+
+    std::string hex(uint64_t id) {
+      char text[17];
+      std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(id));
+      return text;
+    }
+  }
+
+  /**
+   * @brief One thread's finished spans, moved to the retired list when the thread exits
+   */
+  struct Tracer::Buffer {
+    std::mutex mutex;                  ///< Held by the owner to append and by readers to copy
+    std::vector <TraceEvent> events;   ///< Finished spans
+
+    Buffer() {
+      auto &tracer = Tracer::instance();
+      std::lock_guard<std::mutex> lock(tracer._mutex);
+      tracer._buffers.push_back(this);
+    }
+
+    ~Buffer() {
+      auto &tracer = Tracer::instance();
+      std::lock_guard<std::mutex> lock(tracer._mutex);
+      std::move(events.begin(), events.end(), std::back_inserter(tracer._retired));
+      tracer._buffers.erase(std::remove(tracer._buffers.begin(), tracer._buffers.end(), this),
+                            tracer._buffers.end());
+    }
+  };
+
+  Tracer &Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  Tracer::Tracer() : _epoch(std::chrono::steady_clock::now()) {}
+
+  void Tracer::set_enabled(bool enabled) {
+    _enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  TraceContext Tracer::current() {
+    return current_context;
+  }
+
+  std::vector <TraceEvent> Tracer::events(uint64_t trace_id) const {
+    std::vector <TraceEvent> collected;
+    auto keep = [trace_id](const TraceEvent &event) {
+      return trace_id == 0 || event.trace_id == trace_id;
+    };
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      std::copy_if(_retired.begin(), _retired.end(), std::back_inserter(collected), keep);
+      for (auto *buffer: _buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        std::copy_if(buffer->events.begin(), buffer->events.end(), std::back_inserter(collected), keep);
+      }
+    }
+    std::sort(collected.begin(), collected.end(), [](const TraceEvent &a, const TraceEvent &b) {
+      return a.start < b.start;
+    });
+    return collected;
+  }
+
+  std::string Tracer::chrome_trace(uint64_t trace_id) const {
+    auto collected = events(trace_id);
+    auto micros = [this](std::chrono::steady_clock::time_point time) {
+      return std::chrono::duration<double, std::micro>(time - _epoch).count();
+    };
+
+    std::unordered_map<uint64_t, const TraceEvent *> spans;
+    for (const auto &event: collected) {
+      spans[event.span_id] = &event;
+    }
+
+    auto trace_events = nlohmann::json::array();
+    for (const auto &event: collected) {
+      nlohmann::json args = {
+          {"trace_id", hex(event.trace_id)},
+          {"span_id", event.span_id},
+          {"parent_id", event.parent_id}
+      };
+      if (!event.detail.empty()) {
+        args["detail"] = event.detail;
+      }
+      if (event.queued != std::chrono::steady_clock::time_point{}) {
+        args["wait_us"] = std::chrono::duration<double, std::micro>(event.start - event.queued).count();
+      }
+      trace_events.push_back({
+          {"name", event.name},
+          {"cat", "subarulink"},
+          {"ph", "X"},
+          {"ts", micros(event.start)},
+          {"dur", std::chrono::duration<double, std::micro>(event.duration).count()},
+          {"pid", 1},
+          {"tid", event.thread},
+          {"args", args}
+      });
+
+      // Arrow from where the work was handed off to where it started running
+      auto parent = spans.find(event.parent_id);
+      if (parent != spans.end() && parent->second->thread != event.thread) {
+        auto handoff = event.queued != std::chrono::steady_clock::time_point{} ? event.queued : event.start;
+        trace_events.push_back({
+            {"name", "handoff"}, {"cat", "subarulink"}, {"ph", "s"}, {"id", event.span_id},
+            {"ts", micros(std::max(handoff, parent->second->start))}, {"pid", 1}, {"tid", parent->second->thread}
+        });
+        trace_events.push_back({
+            {"name", "handoff"}, {"cat", "subarulink"}, {"ph", "f"}, {"bp", "e"}, {"id", event.span_id},
+            {"ts", micros(event.start)}, {"pid", 1}, {"tid", event.thread}
+        });
+      }
+    }
+
+    return nlohmann::json{{"traceEvents", trace_events}, {"displayTimeUnit", "ms"}}.dump();
+  }
+
+  bool Tracer::write_chrome_trace(const std::string &path, uint64_t trace_id) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    out << chrome_trace(trace_id);
+    return static_cast<bool>(out.flush());
+  }
+
+  void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _retired.clear();
+    for (auto *buffer: _buffers) {
+      std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+      buffer->events.clear();
+    }
+    _size.store(0, std::memory_order_relaxed);
+  }
+
+  uint64_t Tracer::dropped() const {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+  void Tracer::_record(TraceEvent &&event) {
+    if (_size.fetch_add(1, std::memory_order_relaxed) >= MAX_EVENTS) {
+      _size.fetch_sub(1, std::memory_order_relaxed);
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    thread_local Buffer buffer;
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(std::move(event));
+  }
+
+  uint64_t Tracer::_next_id() {
+    return _ids.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  TraceSpan::TraceSpan(std::string_view name, std::string_view detail) {
+    if (Tracer::instance().enabled()) {
+      _open(name, detail, current_context, {});
+    }
+  }
+
+  TraceSpan::TraceSpan(std::string_view name, const TraceContext &parent,
+                       std::chrono::steady_clock::time_point queued) {
+    if (Tracer::instance().enabled()) {
+      _open(name, {}, parent, queued);
+    }
+  }
+
+  TraceSpan::~TraceSpan() {
+    end();
+  }
+
+  void TraceSpan::_open(std::string_view name, std::string_view detail, const TraceContext &parent,
+                        std::chrono::steady_clock::time_point queued) {
+    auto &tracer = Tracer::instance();
+    _active = true;
+    _previous = current_context;
+    _event.name = name;
+    _event.detail = detail;
+    _event.trace_id = parent.trace_id != 0 ? parent.trace_id : tracer._next_id();
+    _event.span_id = tracer._next_id();
+    _event.parent_id = parent.span_id;
+    _event.thread = thread_number();
+    _event.queued = queued;
+    current_context = {_event.trace_id, _event.span_id};
+    _event.start = std::chrono::steady_clock::now();
+  }
+
+  void TraceSpan::end() {
+    if (!_active) {
+      return;
+    }
+    _event.duration = std::chrono::steady_clock::now() - _event.start;
+    _active = false;
+    current_context = _previous;
+    Tracer::instance()._record(std::move(_event));
+  }
+
+} // namespace subarulink
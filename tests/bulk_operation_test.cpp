@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bulk_operation.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  // Stands in for the controller's cache: update sends nothing and returns false while a vehicle is fresh
+  class FakeFleet {
+  public:
+    explicit FakeFleet(std::set<std::string> fresh, std::set<std::string> broken = {})
+        : _fresh(std::move(fresh)), _broken(std::move(broken)) {}
+
+    bool update(const std::string &vin, bool force) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!force && _fresh.count(vin)) {
+        return false;
+      }
+      _sent.push_back(vin);
+      if (_broken.count(vin)) {
+        return false;
+      }
+      _fresh.insert(vin);
+      return true;
+    }
+
+    bool fresh(const std::string &vin) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _fresh.count(vin) > 0;
+    }
+
+    std::vector<std::string> sent() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto sent = _sent;
+      std::sort(sent.begin(), sent.end());
+      return sent;
+    }
+
+  private:
+    std::mutex _mutex;
+    std::set<std::string> _fresh;
+    std::set<std::string> _broken;
+    std::vector<std::string> _sent;
+  };
+
+  // Maps an update the way Controller::bulk_update does
+  BulkResult bulk_update(FakeFleet &fleet, const std::vector<std::string> &vins, bool force) {
+    return run_bulk(vins, [&fleet, force](const std::string &vin) {
+      if (fleet.update(vin, force)) {
+        return BulkStatus::SUCCEEDED;
+      }
+      return !force && fleet.fresh(vin) ? BulkStatus::SKIPPED : BulkStatus::FAILED;
+    });
+  }
+
+  void test_fresh_cache_is_skipped() {
+    FakeFleet fleet({"A", "B", "C"}, {"E"});
+    auto result = bulk_update(fleet, {"A", "B", "C", "D", "E"}, false);
+    CHECK_EQ(result.succeeded, 4u);
+    CHECK_EQ(result.skipped, 3u);
+    CHECK_EQ(result.failed, 1u);
+    CHECK(!result.all_succeeded());
+    CHECK(result.failed_vins() == (std::vector<std::string>{"E"}));
+    CHECK(result.outcomes["A"].success && result.outcomes["A"].skipped);
+    CHECK(result.outcomes["D"].success && !result.outcomes["D"].skipped);
+    CHECK(!result.outcomes["E"].success && !result.outcomes["E"].skipped);
+    CHECK(result.outcomes["E"].error.empty());
+    CHECK(fleet.sent() == (std::vector<std::string>{"D", "E"}));
+  }
+
+  void test_forced_sweep_skips_nothing() {
+    FakeFleet fleet({"A", "B"}, {"B"});
+    auto result = bulk_update(fleet, {"A", "B"}, true);
+    CHECK_EQ(result.succeeded, 1u);
+    CHECK_EQ(result.skipped, 0u);
+    CHECK(result.failed_vins() == (std::vector<std::string>{"B"}));
+    CHECK(fleet.sent() == (std::vector<std::string>{"A", "B"}));
+  }
+
+  void test_success_only_operation() {
+    std::atomic<int> calls{0};
+    auto result = run_bulk({"A", "B", "A", "C"}, [&calls](const std::string &vin) {
+      ++calls;
+      if (vin == "C") {
+        throw std::runtime_error("no subscription");
+      }
+      return vin == "A";
+    });
+    // Duplicates run once and exceptions are failures with their message
+    CHECK_EQ(calls.load(), 3);
+    CHECK_EQ(result.succeeded, 1u);
+    CHECK_EQ(result.skipped, 0u);
+    CHECK(result.failed_vins() == (std::vector<std::string>{"B", "C"}));
+    CHECK_EQ(result.outcomes["C"].error, std::string("no subscription"));
+  }
+
+  void test_parallelism_is_bounded() {
+    std::vector<std::string> vins;
+    for (int i = 0; i < 24; ++i) {
+      vins.push_back("VIN" + std::to_string(i));
+    }
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    BulkOptions options;
+    options.max_parallel = 4;
+    auto result = run_bulk(vins, [&running, &peak](const std::string &) {
+      int now = ++running;
+      int seen = peak.load();
+      while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      --running;
+      return true;
+    }, options);
+    CHECK_EQ(result.succeeded, vins.size());
+    CHECK(peak.load() <= 4);
+    CHECK(peak.load() > 1);
+  }
+
+  void test_progress_counts_every_vehicle() {
+    std::vector<size_t> completed;
+    std::map<std::string, bool> skipped;
+    BulkOptions options;
+    options.max_parallel = 3;
+    options.on_progress = [&](const std::string &vin, const BulkOutcome &outcome, size_t done, size_t total) {
+      // Never called concurrently, so no lock is needed here
+      completed.push_back(done);
+      skipped[vin] = outcome.skipped;
+      CHECK_EQ(total, 5u);
+    };
+    run_bulk({"A", "B", "C", "D", "E"}, [](const std::string &vin) {
+      return vin < "C" ? BulkStatus::SKIPPED : BulkStatus::SUCCEEDED;
+    }, options);
+    CHECK(completed == (std::vector<size_t>{1, 2, 3, 4, 5}));
+    CHECK(skipped == (std::map<std::string, bool>{{"A", true}, {"B", true}, {"C", false}, {"D", false}, {"E", false}}));
+  }
+
+} // namespace
+
+int main() {
+  test::run("fresh_cache_is_skipped", test_fresh_cache_is_skipped);
+  test::run("forced_sweep_skips_nothing", test_forced_sweep_skips_nothing);
+  test::run("success_only_operation", test_success_only_operation);
+  test::run("parallelism_is_bounded", test_parallelism_is_bounded);
+  test::run("progress_counts_every_vehicle", test_progress_counts_every_vehicle);
+  return test::result();
+}
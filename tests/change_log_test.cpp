@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "change_log.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  // One delta per field name, all in one batch
+  std::vector<FieldDelta> batch(const std::vector<std::string> &fields, int value) {
+    std::vector<FieldDelta> deltas;
+    for (const auto &field: fields) {
+      deltas.push_back({0, field_id(field), nullptr, value, std::chrono::system_clock::now()});
+    }
+    return deltas;
+  }
+
+  std::vector<uint64_t> versions(const std::vector<FieldDelta> &deltas) {
+    std::vector<uint64_t> result;
+    for (const auto &delta: deltas) {
+      result.push_back(delta.version);
+    }
+    return result;
+  }
+
+  void test_versions_and_since() {
+    ChangeLog log;
+    CHECK_EQ(log.version(), 0u);
+    CHECK_EQ(log.commit({}), 0u);
+    CHECK_EQ(log.commit(batch({"ODOMETER", "DOOR_BOOT_POSITION"}, 1)), 1u);
+    CHECK_EQ(log.commit(batch({"ODOMETER"}, 2)), 2u);
+    CHECK_EQ(log.commit({}), 2u);
+
+    CHECK(versions(log.since(0)) == (std::vector<uint64_t>{1, 1, 2}));
+    CHECK(versions(log.since(1)) == (std::vector<uint64_t>{2}));
+    CHECK(log.since(2).empty());
+    CHECK_EQ(field_name(log.since(1).front().field), std::string("ODOMETER"));
+    CHECK_EQ(log.since(1).front().new_value, nlohmann::json(2));
+    CHECK_EQ(log.evicted_through(), 0u);
+  }
+
+  void test_truncation_is_reported() {
+    ChangeLog log(4);
+    log.commit(batch({"A", "B"}, 1));       // version 1
+    log.commit(batch({"A", "B"}, 2));       // version 2
+    CHECK_EQ(log.evicted_through(), 0u);
+
+    log.commit(batch({"A"}, 3));            // version 3 evicts one delta of version 1
+    CHECK_EQ(log.evicted_through(), 1u);
+    // A caller at version 0 would miss a change of version 1, and can tell
+    CHECK(versions(log.since(0)) == (std::vector<uint64_t>{1, 2, 2, 3}));
+    CHECK(0 < log.evicted_through());
+    // A caller that processed version 1 still gets everything after it
+    CHECK(versions(log.since(1)) == (std::vector<uint64_t>{2, 2, 3}));
+    CHECK(!(1 < log.evicted_through()));
+
+    log.commit(batch({"A", "B", "C"}, 4));  // version 4 evicts the rest of 1 and all of 2
+    CHECK_EQ(log.evicted_through(), 2u);
+    CHECK(versions(log.since(1)) == (std::vector<uint64_t>{3, 4, 4, 4}));
+    CHECK(1 < log.evicted_through());
+    CHECK(versions(log.since(2)) == (std::vector<uint64_t>{3, 4, 4, 4}));
+  }
+
+  void test_oversized_batch() {
+    ChangeLog log(2);
+    log.commit(batch({"A", "B", "C"}, 1));
+    // The batch itself overflowed, so even version 0 callers know they missed part of it
+    CHECK_EQ(log.evicted_through(), 1u);
+    CHECK_EQ(log.since(0).size(), 2u);
+    CHECK(log.since(1).empty());
+  }
+
+} // namespace
+
+int main() {
+  test::run("versions_and_since", test_versions_and_since);
+  test::run("truncation_is_reported", test_truncation_is_reported);
+  test::run("oversized_batch", test_oversized_batch);
+  return test::result();
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef SUBARULINK_TESTS_CHECK_HPP
+#define SUBARULINK_TESTS_CHECK_HPP
+
+#include <iostream>
+
+namespace subarulink {
+  namespace test {
+
+    /**
+     * @brief Counts failed checks across a test executable
+     * @return Reference to the failure count
+     */
+    inline int &failures() {
+      static int count = 0;
+      return count;
+    }
+
+    /**
+     * @brief Runs one test case and reports its name if any of its checks failed
+     * @param name Test case name
+     * @param test Callable taking no arguments
+     */
+    template<typename F>
+    void run(const char *name, F test) {
+      int before = failures();
+      test();
+      std::cout << (failures() == before ? "PASS " : "FAIL ") << name << std::endl;
+    }
+
+    /**
+     * @brief Exit status of a test executable
+     * @return 0 if every check passed
+     */
+    inline int result() {
+      return failures() == 0 ? 0 : 1;
+    }
+
+  } // namespace test
+} // namespace subarulink
+
+// Records a failure and carries on, so one run reports every broken check
+#define CHECK(expr) \
+  do { \
+    if (!(expr)) { \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed" << std::endl; \
+      ++subarulink::test::failures(); \
+    } \
+  } while (0)
+
+#define CHECK_EQ(actual, expected) \
+  do { \
+    auto &&check_actual = (actual); \
+    auto &&check_expected = (expected); \
+    if (!(check_actual == check_expected)) { \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected ") failed: " \
+                << check_actual << " != " << check_expected << std::endl; \
+      ++subarulink::test::failures(); \
+    } \
+  } while (0)
+
+#endif // SUBARULINK_TESTS_CHECK_HPP
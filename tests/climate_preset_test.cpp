@@ -0,0 +1,108 @@
+#include <string>
+
+#include "climate_preset.h"
+#include "constants.h"
+#include "exceptions.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  bool rejected(const ClimatePreset &preset) {
+    try {
+      preset.validate();
+    } catch (const SubaruException &) {
+      return true;
+    }
+    return false;
+  }
+
+  void test_string_round_trip() {
+    auto wire = nlohmann::json::parse(R"({
+      "name": "Warm up",
+      "runTimeMinutes": "10",
+      "climateZoneFrontTemp": "72",
+      "climateZoneFrontAirMode": "AUTO",
+      "climateZoneFrontAirVolume": "AUTO",
+      "heatedSeatFrontLeft": "HIGH",
+      "heatedRearWindowActive": "true",
+      "airConditionOn": "false",
+      "outerAirCirculation": "outsideAir",
+      "presetType": "userPreset",
+      "startConfiguration": "START_ENGINE_ALLOW_KEY_IN_IGNITION"
+    })");
+    auto preset = ClimatePreset::from_json(wire);
+    CHECK(preset.passthrough.empty());
+    CHECK_EQ(static_cast<int>(preset.temp_f), 72);
+    CHECK(preset.runtime == ClimatePreset::Runtime::MIN_10);
+    CHECK(preset.to_json() == wire);
+    CHECK(!rejected(preset));
+  }
+
+  void test_native_types_round_trip() {
+    auto wire = nlohmann::json::parse(R"({
+      "name": "Cool down",
+      "runTimeMinutes": 5,
+      "climateZoneFrontTemp": 65,
+      "climateZoneFrontTempCelsius": 18,
+      "climateZoneFrontAirMode": "FACE",
+      "heatedRearWindowActive": false,
+      "airConditionOn": true,
+      "canEdit": true,
+      "disabled": false,
+      "canadianMode": false,
+      "index": 3
+    })");
+    auto preset = ClimatePreset::from_json(wire);
+    // Decoded into typed members, not kept verbatim
+    CHECK_EQ(static_cast<int>(preset.temp_f), 65);
+    CHECK_EQ(static_cast<int>(preset.temp_c), 18);
+    CHECK(preset.runtime == ClimatePreset::Runtime::MIN_5);
+    CHECK(preset.rear_defrost == ClimatePreset::Toggle::OFF);
+    CHECK(preset.rear_ac == ClimatePreset::Toggle::ON);
+    CHECK(preset.can_edit == ClimatePreset::Toggle::ON);
+    CHECK_EQ(preset.passthrough.size(), 2u);
+    CHECK(!rejected(preset));
+
+    // Each field goes back with the JSON type it arrived with
+    auto encoded = preset.to_json();
+    CHECK(encoded == wire);
+    CHECK(encoded["climateZoneFrontTemp"].is_number_integer());
+    CHECK(encoded["heatedRearWindowActive"].is_boolean());
+    CHECK(encoded["canadianMode"].is_boolean());
+    CHECK(ClimatePreset::from_json(encoded).to_json() == wire);
+  }
+
+  void test_edits_keep_wire_types() {
+    auto preset = ClimatePreset::from_json(nlohmann::json::parse(
+        R"({"climateZoneFrontTemp": 70, "airConditionOn": "false"})"));
+    // A typed edit keeps the field's wire type
+    preset.temp_f = 74;
+    preset.rear_ac = ClimatePreset::Toggle::ON;
+    CHECK(preset.to_json() == nlohmann::json::parse(R"({"climateZoneFrontTemp": 74, "airConditionOn": "true"})"));
+
+    // Assigning a wire value adopts that value's type
+    preset.assign(climate_control::TEMP_F, "68");
+    preset.assign(climate_control::REAR_AC, false);
+    CHECK(preset.to_json() == nlohmann::json::parse(R"({"climateZoneFrontTemp": "68", "airConditionOn": false})"));
+  }
+
+  void test_unknown_values_are_kept_and_rejected() {
+    auto wire = nlohmann::json::parse(R"({"climateZoneFrontTemp": 99, "runTimeMinutes": 7, "airConditionOn": 1})");
+    auto preset = ClimatePreset::from_json(wire);
+    CHECK_EQ(static_cast<int>(preset.temp_f), 99);
+    CHECK_EQ(preset.passthrough.size(), 2u);
+    CHECK(preset.to_json() == wire);
+    CHECK(rejected(preset));
+  }
+
+} // namespace
+
+int main() {
+  test::run("string_round_trip", test_string_round_trip);
+  test::run("native_types_round_trip", test_native_types_round_trip);
+  test::run("edits_keep_wire_types", test_edits_keep_wire_types);
+  test::run("unknown_values_are_kept_and_rejected", test_unknown_values_are_kept_and_rejected);
+  return test::result();
+}
@@ -0,0 +1,327 @@
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_queue.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  const std::string HORN = "horn";
+  const std::string HORN_STOP = "hornStop";
+  const std::string LIGHTS = "lights";
+  const std::string LIGHTS_STOP = "lightsStop";
+  const std::string LOCK = "lock";
+  const std::string UNLOCK = "unlock";
+
+  CommandRules rules() {
+    CommandRules rules;
+    rules.exclusive_group = {{LOCK, "doors"}, {UNLOCK, "doors"}};
+    rules.cancels = {{HORN_STOP, HORN}, {LIGHTS_STOP, LIGHTS}};
+    return rules;
+  }
+
+  // Stands in for the vehicle: records what was sent and can hold a command in flight
+  class FakeVehicle {
+  public:
+    RemoteCommand::Result send(const std::shared_ptr<RemoteCommand> &command) {
+      std::shared_future<void> hold;
+      bool success = true;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sent.push_back(command->command());
+        auto held = _holds.find(command->command());
+        if (held != _holds.end()) {
+          hold = held->second;
+        }
+        auto outcome = _outcomes.find(command->command());
+        if (outcome != _outcomes.end()) {
+          success = outcome->second;
+        }
+      }
+      if (hold.valid()) {
+        hold.wait();
+      }
+      return std::make_tuple(success, nlohmann::json{{"success", success}});
+    }
+
+    // Keeps every later send of this command in flight until the returned promise is set
+    std::promise<void> hold(const std::string &command) {
+      std::promise<void> release;
+      std::lock_guard<std::mutex> lock(_mutex);
+      _holds[command] = release.get_future().share();
+      return release;
+    }
+
+    void fail(const std::string &command) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _outcomes[command] = false;
+    }
+
+    std::vector<std::string> sent() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _sent;
+    }
+
+  private:
+    std::mutex _mutex;
+    std::vector<std::string> _sent;
+    std::map<std::string, std::shared_future<void>> _holds;
+    std::map<std::string, bool> _outcomes;
+  };
+
+  struct Fixture {
+    FakeVehicle vehicle;
+    CommandQueue queue{[this](const auto &command) { return vehicle.send(command); }, rules()};
+
+    std::shared_ptr<RemoteCommand> submit(const std::string &command, nlohmann::json data = nlohmann::json::object()) {
+      return queue.submit(std::make_shared<RemoteCommand>("VIN", command, "/status.json", std::move(data)));
+    }
+  };
+
+  bool finished(const std::shared_ptr<RemoteCommand> &command) {
+    return command->result().wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+  }
+
+  bool succeeded(const std::shared_ptr<RemoteCommand> &command) {
+    return finished(command) && std::get<0>(command->result().get());
+  }
+
+  std::string error_code(const std::shared_ptr<RemoteCommand> &command) {
+    if (!finished(command)) {
+      return "";
+    }
+    return std::get<1>(command->result().get()).value("errorCode", "");
+  }
+
+  // Waits until the fake has seen the given number of sends
+  bool sent_count(FakeVehicle &vehicle, size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (vehicle.sent().size() < count) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  void test_commands_run_in_order() {
+    Fixture f;
+    auto lock = f.submit(LOCK);
+    auto lights = f.submit(LIGHTS);
+    CHECK(succeeded(lock));
+    CHECK(succeeded(lights));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{LOCK, LIGHTS}));
+  }
+
+  void test_identical_command_joins() {
+    Fixture f;
+    auto release = f.vehicle.hold(LIGHTS);
+    auto running = f.submit(LIGHTS);
+    CHECK(sent_count(f.vehicle, 1));
+    auto first = f.submit(HORN, {{"duration", 5}});
+    auto joined = f.submit(HORN, {{"duration", 5}});
+    auto different = f.submit(HORN, {{"duration", 10}});
+    CHECK(joined == first);
+    CHECK(different != first);
+    CHECK_EQ(f.queue.pending(), 2u);
+    release.set_value();
+    CHECK(succeeded(first));
+    CHECK(succeeded(different));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{LIGHTS, HORN, HORN}));
+  }
+
+  void test_exclusive_group_supersedes() {
+    Fixture f;
+    auto release = f.vehicle.hold(LIGHTS);
+    auto running = f.submit(LIGHTS);
+    CHECK(sent_count(f.vehicle, 1));
+    auto lock = f.submit(LOCK);
+    auto unlock = f.submit(UNLOCK);
+    CHECK_EQ(error_code(lock), RemoteCommand::SUPERSEDED);
+    CHECK(lock->state() == RemoteCommandState::CANCELLED);
+    release.set_value();
+    CHECK(succeeded(unlock));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{LIGHTS, UNLOCK}));
+  }
+
+  void test_sent_command_is_not_superseded() {
+    Fixture f;
+    auto release = f.vehicle.hold(LOCK);
+    auto lock = f.submit(LOCK);
+    CHECK(sent_count(f.vehicle, 1));
+    auto unlock = f.submit(UNLOCK);
+    release.set_value();
+    CHECK(succeeded(lock));
+    CHECK(succeeded(unlock));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{LOCK, UNLOCK}));
+  }
+
+  void test_withdraw() {
+    Fixture f;
+    auto release = f.vehicle.hold(LIGHTS);
+    auto running = f.submit(LIGHTS);
+    CHECK(sent_count(f.vehicle, 1));
+    auto lock = f.submit(LOCK);
+    CHECK(f.queue.withdraw(lock));
+    CHECK(!f.queue.withdraw(lock));
+    CHECK(!f.queue.withdraw(running));
+    CHECK_EQ(error_code(lock), RemoteCommand::CANCELLED);
+    release.set_value();
+    CHECK(succeeded(running));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{LIGHTS}));
+  }
+
+  bool still_waiting(const std::shared_ptr<RemoteCommand> &command) {
+    return command->result().wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout;
+  }
+
+  void test_untracked_stop_is_sent() {
+    // The horn may have been started by the app or the key fob
+    Fixture f;
+    auto stop = f.submit(HORN_STOP);
+    CHECK(succeeded(stop));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN_STOP}));
+  }
+
+  void test_stop_drops_queued_counterpart() {
+    Fixture f;
+    auto release = f.vehicle.hold(LIGHTS);
+    auto running = f.submit(LIGHTS);
+    CHECK(sent_count(f.vehicle, 1));
+    auto horn = f.submit(HORN);
+    auto stop = f.submit(HORN_STOP);
+    CHECK_EQ(error_code(horn), RemoteCommand::CANCELLED);
+    CHECK(succeeded(stop));
+    CHECK_EQ(f.queue.pending(), 0u);
+    release.set_value();
+    CHECK(succeeded(running));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{LIGHTS}));
+  }
+
+  void test_stop_waits_for_running_counterpart() {
+    Fixture f;
+    auto release = f.vehicle.hold(HORN);
+    auto horn = f.submit(HORN);
+    CHECK(sent_count(f.vehicle, 1));
+    auto lock = f.submit(LOCK);
+    // The stop goes ahead of the lock but is not sent while the horn is still being polled
+    auto stop = f.submit(HORN_STOP);
+    CHECK(still_waiting(stop));
+    CHECK_EQ(f.queue.pending(), 2u);
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN}));
+    release.set_value();
+    CHECK(succeeded(horn));
+    CHECK(succeeded(stop));
+    CHECK(succeeded(lock));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN, HORN_STOP, LOCK}));
+  }
+
+  void test_stops_keep_their_order() {
+    Fixture f;
+    auto release = f.vehicle.hold(LIGHTS);
+    auto running = f.submit(LIGHTS);
+    CHECK(sent_count(f.vehicle, 1));
+    auto lock = f.submit(LOCK);
+    auto horn_stop = f.submit(HORN_STOP);
+    auto joined = f.submit(HORN_STOP);
+    auto lights_stop = f.submit(LIGHTS_STOP);
+    CHECK(joined == horn_stop);
+    CHECK_EQ(f.queue.pending(), 3u);
+    release.set_value();
+    CHECK(succeeded(lock));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{LIGHTS, HORN_STOP, LIGHTS_STOP, LOCK}));
+  }
+
+  void test_repeated_stop_is_sent() {
+    Fixture f;
+    auto horn = f.submit(HORN);
+    CHECK(succeeded(horn));
+    auto stop = f.submit(HORN_STOP);
+    CHECK(succeeded(stop));
+    auto again = f.submit(HORN_STOP);
+    CHECK(succeeded(again));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN, HORN_STOP, HORN_STOP}));
+  }
+
+  void test_stop_after_failed_counterpart_is_sent() {
+    Fixture f;
+    f.vehicle.fail(HORN);
+    auto horn = f.submit(HORN);
+    CHECK(finished(horn));
+    CHECK(!std::get<0>(horn->result().get()));
+    auto stop = f.submit(HORN_STOP);
+    CHECK(succeeded(stop));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN, HORN_STOP}));
+  }
+
+  void test_stop_after_dropping_is_sent_while_in_effect() {
+    Fixture f;
+    auto first = f.submit(HORN, {{"duration", 5}});
+    CHECK(succeeded(first));
+    auto release = f.vehicle.hold(LIGHTS);
+    auto running = f.submit(LIGHTS);
+    CHECK(sent_count(f.vehicle, 2));
+    auto queued = f.submit(HORN, {{"duration", 10}});
+    // The first horn is still in effect, so the stop is sent after dropping the second
+    auto stop = f.submit(HORN_STOP);
+    CHECK_EQ(error_code(queued), RemoteCommand::CANCELLED);
+    release.set_value();
+    CHECK(succeeded(stop));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN, LIGHTS, HORN_STOP}));
+  }
+
+  void test_failed_stop_is_retried_by_next_stop() {
+    Fixture f;
+    auto horn = f.submit(HORN);
+    CHECK(succeeded(horn));
+    f.vehicle.fail(HORN_STOP);
+    auto stop = f.submit(HORN_STOP);
+    CHECK(finished(stop));
+    CHECK(!std::get<0>(stop->result().get()));
+    auto again = f.submit(HORN_STOP);
+    CHECK(finished(again));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN, HORN_STOP, HORN_STOP}));
+  }
+
+  void test_stop_drops_queued_and_undoes_running() {
+    Fixture f;
+    auto release = f.vehicle.hold(HORN);
+    auto running = f.submit(HORN, {{"duration", 5}});
+    CHECK(sent_count(f.vehicle, 1));
+    auto queued = f.submit(HORN, {{"duration", 10}});
+    auto stop = f.submit(HORN_STOP);
+    CHECK_EQ(error_code(queued), RemoteCommand::CANCELLED);
+    CHECK(still_waiting(stop));
+    release.set_value();
+    CHECK(succeeded(running));
+    CHECK(succeeded(stop));
+    CHECK(f.vehicle.sent() == (std::vector<std::string>{HORN, HORN_STOP}));
+  }
+
+} // namespace
+
+int main() {
+  test::run("commands_run_in_order", test_commands_run_in_order);
+  test::run("identical_command_joins", test_identical_command_joins);
+  test::run("exclusive_group_supersedes", test_exclusive_group_supersedes);
+  test::run("sent_command_is_not_superseded", test_sent_command_is_not_superseded);
+  test::run("withdraw", test_withdraw);
+  test::run("untracked_stop_is_sent", test_untracked_stop_is_sent);
+  test::run("stop_drops_queued_counterpart", test_stop_drops_queued_counterpart);
+  test::run("stop_waits_for_running_counterpart", test_stop_waits_for_running_counterpart);
+  test::run("stops_keep_their_order", test_stops_keep_their_order);
+  test::run("repeated_stop_is_sent", test_repeated_stop_is_sent);
+  test::run("stop_after_failed_counterpart_is_sent", test_stop_after_failed_counterpart_is_sent);
+  test::run("stop_after_dropping_is_sent_while_in_effect", test_stop_after_dropping_is_sent_while_in_effect);
+  test::run("failed_stop_is_retried_by_next_stop", test_failed_stop_is_retried_by_next_stop);
+  test::run("stop_drops_queued_and_undoes_running", test_stop_drops_queued_and_undoes_running);
+  return test::result();
+}
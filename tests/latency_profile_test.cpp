@@ -0,0 +1,106 @@
+#include <chrono>
+#include <string>
+
+#include "latency_profile.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  const std::string KEY = "g1 hornLights";
+
+  std::chrono::milliseconds ms(int64_t value) {
+    return std::chrono::milliseconds(value);
+  }
+
+  void test_completed_percentiles() {
+    LatencyProfiles profiles;
+    CHECK(profiles.percentile(KEY, 50) == ms(0));
+    for (int64_t value: {5000, 1000, 3000, 2000, 4000}) {
+      profiles.record(KEY, ms(value));
+    }
+    CHECK(profiles.percentile(KEY, 0) == ms(1000));
+    CHECK(profiles.percentile(KEY, 50) == ms(3000));
+    CHECK(profiles.percentile(KEY, 90) == ms(5000));
+    CHECK(profiles.percentile(KEY, 100) == ms(5000));
+  }
+
+  void test_timeouts_push_the_tail() {
+    LatencyProfiles fast;
+    LatencyProfiles timed_out;
+    for (int64_t value: {1000, 2000, 3000, 4000, 5000}) {
+      fast.record(KEY, ms(value));
+      timed_out.record(KEY, ms(value));
+    }
+    // Five more commands never completed within 20 seconds of polling
+    for (int i = 0; i < 5; ++i) {
+      timed_out.record(KEY, ms(20000), true);
+    }
+    CHECK(fast.percentile(KEY, 90) == ms(5000));
+    // Half the commands are still running after 5 s, so the upper percentiles lie past every completion
+    CHECK(timed_out.percentile(KEY, 25) == ms(3000));
+    CHECK(timed_out.percentile(KEY, 50) == ms(5000));
+    CHECK(timed_out.percentile(KEY, 90) == ms(20000));
+    // The schedule keeps polling well past the timeouts instead of stopping at the fast tail
+    auto schedule = timed_out.schedule(KEY);
+    CHECK(schedule.attempts > fast.schedule(KEY).attempts);
+  }
+
+  void test_early_cancel_does_not_bias() {
+    LatencyProfiles profiles;
+    for (int64_t value: {2000, 2000, 4000, 4000}) {
+      profiles.record(KEY, ms(value));
+    }
+    // Cancelled after 500 ms: the command was still running, which says nothing about its end
+    profiles.record(KEY, ms(500), true);
+    CHECK(profiles.percentile(KEY, 0) == ms(2000));
+    CHECK(profiles.percentile(KEY, 50) == ms(2000));
+    CHECK(profiles.percentile(KEY, 100) == ms(4000));
+  }
+
+  void test_schedule_needs_completed_samples() {
+    LatencyProfiles profiles;
+    for (int i = 0; i < 10; ++i) {
+      profiles.record(KEY, ms(20000), true);
+    }
+    for (int i = 0; i < 4; ++i) {
+      profiles.record(KEY, ms(3000));
+    }
+    auto fixed = PollSchedule();
+    CHECK(profiles.schedule(KEY).first_delay == fixed.first_delay);
+    CHECK_EQ(profiles.schedule(KEY).attempts, fixed.attempts);
+
+    profiles.record(KEY, ms(3000));
+    CHECK(profiles.schedule(KEY).first_delay > fixed.first_delay);
+  }
+
+  void test_json_round_trip() {
+    LatencyProfiles profiles;
+    profiles.record(KEY, ms(1500));
+    profiles.record(KEY, ms(20000), true);
+    profiles.record("g2 lock", ms(900));
+    auto json = profiles.to_json();
+    CHECK(json[KEY] == nlohmann::json::parse(R"([1500, {"censored": 20000}])"));
+
+    LatencyProfiles loaded;
+    loaded.from_json(json);
+    CHECK(loaded.to_json() == json);
+    CHECK(loaded.percentile(KEY, 100) == ms(20000));
+
+    // Files written before censored samples existed hold plain numbers
+    loaded.from_json(nlohmann::json::parse(R"({"g2 lock": [700, 800, "bad", -1]})"));
+    CHECK(loaded.percentile("g2 lock", 100) == ms(800));
+    CHECK(loaded.percentile(KEY, 100) == ms(0));
+  }
+
+} // namespace
+
+int main() {
+  test::run("completed_percentiles", test_completed_percentiles);
+  test::run("timeouts_push_the_tail", test_timeouts_push_the_tail);
+  test::run("early_cancel_does_not_bias", test_early_cancel_does_not_bias);
+  test::run("schedule_needs_completed_samples", test_schedule_needs_completed_samples);
+  test::run("json_round_trip", test_json_round_trip);
+  return test::result();
+}
@@ -0,0 +1,248 @@
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "location_history.h"
+#include "check.h"
+
+namespace subarulink {
+
+  // Exposes the private varint codec
+  class LocationHistoryTest {
+  public:
+    static std::vector<uint8_t> put(int64_t value) {
+      std::vector<uint8_t> bytes;
+      LocationHistory::_put(bytes, value);
+      return bytes;
+    }
+
+    static void put(std::vector<uint8_t> &bytes, int64_t value) {
+      LocationHistory::_put(bytes, value);
+    }
+
+    static int64_t get(const std::vector<uint8_t> &bytes, size_t &offset) {
+      return LocationHistory::_get(bytes, offset);
+    }
+  };
+
+} // namespace subarulink
+
+using namespace subarulink;
+
+namespace {
+
+  const std::string VIN = "4S4BTGND0L3100001";
+  constexpr int64_t START = 1700000000;
+
+  // Coordinates are given in microdegrees, the stored precision, so decoding must give them back exactly
+  LocationSample sample(int64_t seconds, int64_t latitude, int64_t longitude, std::optional<int> heading) {
+    LocationSample s;
+    s.time = std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+    s.latitude = static_cast<double>(latitude) / 1e6;
+    s.longitude = static_cast<double>(longitude) / 1e6;
+    s.heading = heading;
+    return s;
+  }
+
+  std::chrono::system_clock::time_point at(int64_t seconds) {
+    return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+  }
+
+  bool same(const LocationSample &a, const LocationSample &b) {
+    return a.time == b.time && a.latitude == b.latitude && a.longitude == b.longitude && a.heading == b.heading;
+  }
+
+  bool same(const std::vector<LocationSample> &actual, const std::vector<LocationSample> &expected) {
+    if (actual.size() != expected.size()) {
+      std::cerr << "  got " << actual.size() << " samples, expected " << expected.size() << std::endl;
+      return false;
+    }
+    for (size_t i = 0; i < actual.size(); ++i) {
+      if (!same(actual[i], expected[i])) {
+        std::cerr << "  sample " << i << " differs" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<LocationSample> append_all(LocationHistory &history, const std::vector<LocationSample> &samples) {
+    for (const auto &s: samples) {
+      CHECK(history.append(VIN, s));
+    }
+    return samples;
+  }
+
+  // Random walk with moves in every direction, occasional stops and missing headings
+  std::vector<LocationSample> drive(size_t count) {
+    std::vector<LocationSample> samples;
+    uint64_t state = 42;
+    auto next = [&state](int64_t span) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      return static_cast<int64_t>((state >> 33) % static_cast<uint64_t>(2 * span + 1)) - span;
+    };
+    int64_t time = START;
+    int64_t latitude = 40123456;
+    int64_t longitude = -105654321;
+    for (size_t i = 0; i < count; ++i) {
+      time += 1 + (next(600) + 600);
+      if (i % 7 != 0) {
+        latitude += next(5000);
+        longitude += next(5000);
+      }
+      std::optional<int> heading;
+      if (i % 5 != 0) {
+        heading = static_cast<int>(next(179) + 180);
+      }
+      samples.push_back(sample(time, latitude, longitude, heading));
+    }
+    return samples;
+  }
+
+  void test_varint_exact_bytes() {
+    CHECK(LocationHistoryTest::put(0) == (std::vector<uint8_t>{0x00}));
+    CHECK(LocationHistoryTest::put(-1) == (std::vector<uint8_t>{0x01}));
+    CHECK(LocationHistoryTest::put(1) == (std::vector<uint8_t>{0x02}));
+    CHECK(LocationHistoryTest::put(-64) == (std::vector<uint8_t>{0x7F}));
+    CHECK(LocationHistoryTest::put(64) == (std::vector<uint8_t>{0x80, 0x01}));
+    CHECK(LocationHistoryTest::put(-65) == (std::vector<uint8_t>{0x81, 0x01}));
+    CHECK(LocationHistoryTest::put(300) == (std::vector<uint8_t>{0xD8, 0x04}));
+  }
+
+  void test_varint_round_trip_every_width() {
+    const int64_t min = std::numeric_limits<int64_t>::min();
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    const std::vector<std::pair<int64_t, size_t>> cases = {
+        {0, 1}, {1, 1}, {-1, 1}, {63, 1}, {-64, 1},
+        {64, 2}, {-65, 2}, {8191, 2}, {-8192, 2},
+        {8192, 3}, {-8193, 3},
+        {std::numeric_limits<int32_t>::max(), 5}, {std::numeric_limits<int32_t>::min(), 5},
+        {int64_t(1) << 55, 9}, {-(int64_t(1) << 55), 8},
+        {max, 10}, {min, 10}, {max - 1, 10}, {min + 1, 10},
+    };
+    for (const auto &[value, width]: cases) {
+      auto bytes = LocationHistoryTest::put(value);
+      CHECK_EQ(bytes.size(), width);
+      size_t offset = 0;
+      CHECK_EQ(LocationHistoryTest::get(bytes, offset), value);
+      CHECK_EQ(offset, bytes.size());
+    }
+  }
+
+  void test_varint_stream() {
+    const std::vector<int64_t> values = {
+        5, 5, 5, -3, 0, 0, 1000000, -1000000, std::numeric_limits<int64_t>::min(), 7,
+        std::numeric_limits<int64_t>::max(), -1};
+    std::vector<uint8_t> bytes;
+    for (auto value: values) {
+      LocationHistoryTest::put(bytes, value);
+    }
+    size_t offset = 0;
+    for (auto value: values) {
+      CHECK_EQ(LocationHistoryTest::get(bytes, offset), value);
+    }
+    CHECK_EQ(offset, bytes.size());
+  }
+
+  void test_negative_deltas() {
+    LocationHistory history;
+    // Heading south-west across the equator and the prime meridian, then back
+    auto expected = append_all(history, {
+        sample(START, 1500000, 2500000, 225),
+        sample(START + 60, 500000, 1000000, 225),
+        sample(START + 120, -500000, -1000, 200),
+        sample(START + 180, -89999999, -179999999, 180),
+        sample(START + 240, 89999999, 179999999, 0),
+        sample(START + 241, -1, -1, 359),
+        sample(START + 242, 0, 0, 0),
+    });
+    CHECK(same(history.range(VIN, at(START), at(START + 242)), expected));
+    CHECK(same(*history.latest(VIN), expected.back()));
+  }
+
+  void test_repeated_values() {
+    LocationHistory history;
+    std::vector<LocationSample> expected;
+    for (int i = 0; i < 50; ++i) {
+      expected.push_back(sample(START + i * 300, 37774929, -122419416, 90));
+    }
+    append_all(history, expected);
+    CHECK(same(history.range(VIN, at(START), at(START + 50 * 300)), expected));
+    CHECK_EQ(history.size(VIN), 50u);
+  }
+
+  void test_headings() {
+    LocationHistory history;
+    append_all(history, {
+        sample(START, 1, 1, std::nullopt),
+        sample(START + 1, 1, 1, -90),
+        sample(START + 2, 1, 1, 450),
+        sample(START + 3, 1, 1, std::nullopt),
+        sample(START + 4, 1, 1, 0),
+    });
+    auto samples = history.range(VIN, at(START), at(START + 4));
+    CHECK_EQ(samples.size(), 5u);
+    if (samples.size() == 5) {
+      CHECK(!samples[0].heading);
+      CHECK(samples[1].heading == std::optional<int>(270));
+      CHECK(samples[2].heading == std::optional<int>(90));
+      CHECK(!samples[3].heading);
+      CHECK(samples[4].heading == std::optional<int>(0));
+    }
+  }
+
+  void test_block_boundary() {
+    LocationHistory history;
+    auto expected = append_all(history, drive(3 * LocationHistory::BLOCK_SAMPLES + 5));
+    CHECK(same(history.range(VIN, expected.front().time, expected.back().time), expected));
+
+    // A range spanning the first block boundary
+    const size_t boundary = LocationHistory::BLOCK_SAMPLES;
+    std::vector<LocationSample> across(expected.begin() + boundary - 2, expected.begin() + boundary + 3);
+    CHECK(same(history.range(VIN, across.front().time, across.back().time), across));
+
+    // A range inside the second block, starting between two samples
+    std::vector<LocationSample> inside(expected.begin() + boundary + 10, expected.begin() + boundary + 20);
+    CHECK(same(history.range(VIN, inside.front().time - std::chrono::seconds(1), inside.back().time), inside));
+
+    // The last sample opens a block of its own
+    CHECK(same(history.range(VIN, expected.back().time, expected.back().time), {expected.back()}));
+    CHECK(same(*history.latest(VIN), expected.back()));
+  }
+
+  void test_rejects_old_samples() {
+    LocationHistory history;
+    CHECK(history.append(VIN, sample(START, 1, 1, 1)));
+    CHECK(!history.append(VIN, sample(START, 2, 2, 2)));
+    CHECK(!history.append(VIN, sample(START - 1, 2, 2, 2)));
+    CHECK_EQ(history.size(VIN), 1u);
+    CHECK(!history.latest("OTHER"));
+    CHECK(history.range("OTHER", at(0), at(START)).empty());
+  }
+
+  void test_trim_drops_whole_blocks() {
+    LocationHistory history(2 * LocationHistory::BLOCK_SAMPLES);
+    auto samples = append_all(history, drive(3 * LocationHistory::BLOCK_SAMPLES + 1));
+    // Blocks of 128, 128, 128 and 1: dropping the first leaves 257, still over the limit
+    std::vector<LocationSample> kept(samples.begin() + 2 * LocationHistory::BLOCK_SAMPLES, samples.end());
+    CHECK_EQ(history.size(VIN), kept.size());
+    CHECK(same(history.range(VIN, samples.front().time, samples.back().time), kept));
+  }
+
+} // namespace
+
+int main() {
+  test::run("varint_exact_bytes", test_varint_exact_bytes);
+  test::run("varint_round_trip_every_width", test_varint_round_trip_every_width);
+  test::run("varint_stream", test_varint_stream);
+  test::run("negative_deltas", test_negative_deltas);
+  test::run("repeated_values", test_repeated_values);
+  test::run("headings", test_headings);
+  test::run("block_boundary", test_block_boundary);
+  test::run("rejects_old_samples", test_rejects_old_samples);
+  test::run("trim_drops_whole_blocks", test_trim_drops_whole_blocks);
+  return test::result();
+}
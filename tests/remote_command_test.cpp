@@ -0,0 +1,71 @@
+#include <future>
+#include <stdexcept>
+#include <string>
+
+#include "remote_command.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  std::shared_ptr<RemoteCommand> command(std::function<void()> prepare = nullptr) {
+    return std::make_shared<RemoteCommand>("VIN", "remoteStart", "status.json", nlohmann::json(), std::move(prepare));
+  }
+
+  void test_prepare_runs_until_it_succeeds() {
+    int runs = 0;
+    auto cmd = command([&runs]() {
+      if (++runs == 1) {
+        throw std::runtime_error("settings not saved");
+      }
+    });
+    bool threw = false;
+    try {
+      cmd->prepare();
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    CHECK(threw);
+    // The failed step is not marked done, so the retry runs it again
+    cmd->prepare();
+    cmd->prepare();
+    CHECK_EQ(runs, 2);
+  }
+
+  void test_cancel_interrupts_wait() {
+    auto cmd = command();
+    std::promise<void> cancelled;
+    auto interrupted = cancelled.get_future();
+    cmd->on_cancel([&cancelled]() { cancelled.set_value(); });
+    CHECK(interrupted.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+    auto waiter = std::async(std::launch::async, [&interrupted]() {
+      return interrupted.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+    });
+    CHECK(cmd->request_cancel());
+    CHECK(waiter.get());
+    // A repeated cancel does not run the callback again
+    CHECK(cmd->request_cancel());
+    cmd->on_cancel(nullptr);
+  }
+
+  void test_cancel_before_wait() {
+    auto cmd = command();
+    CHECK(cmd->request_cancel());
+    int calls = 0;
+    cmd->on_cancel([&calls]() { ++calls; });
+    CHECK_EQ(calls, 1);
+    cmd->on_cancel(nullptr);
+    cmd->request_cancel();
+    CHECK_EQ(calls, 1);
+  }
+
+} // namespace
+
+int main() {
+  test::run("prepare_runs_until_it_succeeds", test_prepare_runs_until_it_succeeds);
+  test::run("cancel_interrupts_wait", test_cancel_interrupts_wait);
+  test::run("cancel_before_wait", test_cancel_before_wait);
+  return test::result();
+}
@@ -0,0 +1,173 @@
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "status_poller.h"
+#include "remote_command.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  const std::string POLL_URL = "/service/g2/remoteService/status.json";
+
+  nlohmann::json state(const std::string &status) {
+    return {{"success", true}, {"data", {{"remoteServiceState", status}}}};
+  }
+
+  PollSchedule right_away(int attempts = 1) {
+    PollSchedule schedule;
+    schedule.first_delay = std::chrono::milliseconds(0);
+    schedule.interval = std::chrono::milliseconds(10);
+    schedule.max_interval = std::chrono::milliseconds(10);
+    schedule.attempts = attempts;
+    return schedule;
+  }
+
+  // Stands in for the status endpoint: records which threads poll and how many polls overlap
+  class FakeService {
+  public:
+    explicit FakeService(std::chrono::milliseconds delay) : _delay(delay) {}
+
+    nlohmann::json poll(const std::string &req_id) {
+      auto vin = req_id.substr(0, req_id.find('-'));
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _threads.insert(std::this_thread::get_id());
+        _peak = std::max(_peak, ++_running);
+        _vin_peak = std::max(_vin_peak, ++_running_per_vin[vin]);
+        ++_polls[req_id];
+      }
+      std::this_thread::sleep_for(_delay);
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_running;
+      --_running_per_vin[vin];
+      return state(_polls[req_id] < _polls_until_done ? "STARTED" : "SUCCESS");
+    }
+
+    void polls_until_done(int polls) { _polls_until_done = polls; }
+    size_t threads() { std::lock_guard<std::mutex> lock(_mutex); return _threads.size(); }
+    int peak() { std::lock_guard<std::mutex> lock(_mutex); return _peak; }
+    int vin_peak() { std::lock_guard<std::mutex> lock(_mutex); return _vin_peak; }
+    int polls(const std::string &req_id) { std::lock_guard<std::mutex> lock(_mutex); return _polls[req_id]; }
+
+  private:
+    std::chrono::milliseconds _delay;
+    std::mutex _mutex;
+    std::set<std::thread::id> _threads;
+    std::map<std::string, int> _running_per_vin;
+    std::map<std::string, int> _polls;
+    int _running{0};
+    int _peak{0};
+    int _vin_peak{0};
+    int _polls_until_done{1};
+  };
+
+  StatusPoller::PollFunction poll_with(FakeService &service) {
+    return [&service](const std::string &, const std::string &req_id) { return service.poll(req_id); };
+  }
+
+  void test_thread_count_is_bounded() {
+    FakeService service(std::chrono::milliseconds(5));
+    StatusPoller poller(poll_with(service), 3);
+    std::vector<std::future<StatusPoller::Result>> results;
+    // A fleet-wide command: 60 requests due at once across 20 vehicles
+    for (int i = 0; i < 60; ++i) {
+      auto vin = "VIN" + std::to_string(i % 20);
+      results.push_back(poller.watch(vin, vin + "-" + std::to_string(i), POLL_URL, right_away()));
+    }
+    for (auto &result: results) {
+      CHECK(std::get<0>(result.get()));
+    }
+    CHECK(service.threads() <= 3u);
+    CHECK(service.peak() <= 3);
+    CHECK_EQ(poller.pending(), 0u);
+  }
+
+  void test_vehicle_polls_run_in_turn() {
+    FakeService service(std::chrono::milliseconds(5));
+    StatusPoller poller(poll_with(service), 4);
+    std::vector<std::future<StatusPoller::Result>> results;
+    for (int i = 0; i < 8; ++i) {
+      // Spread over several loop wakeups, so more than one batch is queued for the vehicle
+      std::this_thread::sleep_for(std::chrono::milliseconds(i % 2));
+      results.push_back(poller.watch("VIN", "VIN-" + std::to_string(i), POLL_URL, right_away()));
+    }
+    for (auto &result: results) {
+      CHECK(std::get<0>(result.get()));
+    }
+    // Whichever workers picked them up, the vehicle saw one poll at a time
+    CHECK_EQ(service.vin_peak(), 1);
+  }
+
+  void test_polls_until_final_state() {
+    FakeService service(std::chrono::milliseconds(0));
+    service.polls_until_done(3);
+    StatusPoller poller(poll_with(service), 1);
+    auto done = poller.watch("VIN", "VIN-done", POLL_URL, right_away(5));
+    auto gave_up = poller.watch("VIN", "VIN-gave-up", POLL_URL, right_away(2));
+    CHECK(std::get<0>(done.get()));
+    CHECK_EQ(service.polls("VIN-done"), 3);
+    auto [success, response] = gave_up.get();
+    CHECK(!success);
+    CHECK(response.is_null());
+    CHECK_EQ(service.polls("VIN-gave-up"), 2);
+  }
+
+  void test_cancel_during_poll() {
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    StatusPoller poller([&](const std::string &, const std::string &) {
+      started.set_value();
+      released.wait();
+      return state("SUCCESS");
+    }, 1);
+    auto result = poller.watch("VIN", "VIN-0", POLL_URL, right_away());
+    started.get_future().wait();
+
+    // The future completes while the only worker is still stuck in the poll
+    CHECK(poller.cancel("VIN-0"));
+    CHECK(result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    auto [success, response] = result.get();
+    CHECK(!success);
+    CHECK_EQ(response["errorCode"].get<std::string>(), RemoteCommand::CANCELLED);
+    CHECK_EQ(poller.pending(), 0u);
+    CHECK(!poller.cancel("VIN-0"));
+    release.set_value();
+  }
+
+  void test_stop_fails_outstanding_requests() {
+    std::future<StatusPoller::Result> waiting;
+    {
+      FakeService service(std::chrono::milliseconds(0));
+      StatusPoller poller(poll_with(service), 2);
+      auto schedule = right_away();
+      schedule.first_delay = std::chrono::hours(1);
+      waiting = poller.watch("VIN", "VIN-0", POLL_URL, schedule);
+    }
+    bool stopped = false;
+    try {
+      waiting.get();
+    } catch (const std::exception &) {
+      stopped = true;
+    }
+    CHECK(stopped);
+  }
+
+} // namespace
+
+int main() {
+  test::run("thread_count_is_bounded", test_thread_count_is_bounded);
+  test::run("vehicle_polls_run_in_turn", test_vehicle_polls_run_in_turn);
+  test::run("polls_until_final_state", test_polls_until_final_state);
+  test::run("cancel_during_poll", test_cancel_during_poll);
+  test::run("stop_fails_outstanding_requests", test_stop_fails_outstanding_requests);
+  return test::result();
+}
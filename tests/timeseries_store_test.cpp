@@ -0,0 +1,269 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "timeseries_store.h"
+#include "check.h"
+
+using namespace subarulink;
+
+namespace {
+
+  namespace fs = std::filesystem;
+
+  const std::string VIN = "4S4BTGND0L3100001";
+  const std::string FIELD = "ODOMETER";
+  constexpr int64_t START = 1700000000;
+
+  std::chrono::system_clock::time_point at(int64_t seconds) {
+    return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+  }
+
+  // Compares values bit for bit, so -0.0 and NaN payloads must survive too
+  bool same_bits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+  }
+
+  bool same(const std::vector<TimeSeriesPoint> &actual, const std::vector<TimeSeriesPoint> &expected) {
+    if (actual.size() != expected.size()) {
+      std::cerr << "  got " << actual.size() << " points, expected " << expected.size() << std::endl;
+      return false;
+    }
+    for (size_t i = 0; i < actual.size(); ++i) {
+      if (actual[i].time != expected[i].time || !same_bits(actual[i].value, expected[i].value)) {
+        std::cerr << "  point " << i << " differs: " << actual[i].value << " vs " << expected[i].value << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<TimeSeriesPoint> append_all(TimeSeriesStore &store, const std::vector<TimeSeriesPoint> &points) {
+    for (const auto &point: points) {
+      CHECK(store.append(VIN, FIELD, point.time, point.value));
+    }
+    return points;
+  }
+
+  std::vector<TimeSeriesPoint> all(const TimeSeriesStore &store) {
+    return store.range(VIN, FIELD, at(std::numeric_limits<int32_t>::min()), at(std::numeric_limits<int32_t>::max()));
+  }
+
+  // Points whose timestamps step by the given delta-of-delta values
+  std::vector<TimeSeriesPoint> with_dods(const std::vector<int64_t> &dods, int64_t first_delta) {
+    std::vector<TimeSeriesPoint> points;
+    int64_t time = START;
+    int64_t delta = first_delta;
+    points.push_back({at(time), 0.0});
+    time += delta;
+    points.push_back({at(time), 1.0});
+    for (auto dod: dods) {
+      delta += dod;
+      time += delta;
+      points.push_back({at(time), static_cast<double>(points.size())});
+    }
+    return points;
+  }
+
+  // Steady odometer-like series: regular polls with the value often unchanged
+  std::vector<TimeSeriesPoint> odometer(size_t count, int64_t start = START) {
+    std::vector<TimeSeriesPoint> points;
+    double value = 12345.0;
+    for (size_t i = 0; i < count; ++i) {
+      if (i % 3 == 0) {
+        value += 1.5;
+      }
+      points.push_back({at(start + static_cast<int64_t>(i) * 600 + static_cast<int64_t>(i % 4)), value});
+    }
+    return points;
+  }
+
+  class TempDirectory {
+  public:
+    TempDirectory() {
+      auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+      _path = fs::temp_directory_path() / ("subarulink_timeseries_test_" + std::to_string(stamp));
+    }
+
+    ~TempDirectory() {
+      std::error_code error;
+      fs::remove_all(_path, error);
+    }
+
+    std::string path() const { return _path.string(); }
+
+  private:
+    fs::path _path;
+  };
+
+  void test_every_timestamp_width() {
+    // The first delta is large so every negative delta-of-delta still moves time forward
+    const std::vector<int64_t> dods = {
+        0, 0,                       // '0'
+        1, -1, 63, -64,             // '10' + 7 bits
+        64, -65, 255, -256,         // '110' + 9 bits
+        256, -257, 2047, -2048,     // '1110' + 12 bits
+        2048, -2049,                // '1111' + 64 bits
+        100000000, -100000000, -600000,
+        0, 5, 0
+    };
+    TimeSeriesStore store;
+    auto expected = append_all(store, with_dods(dods, 1000000));
+    CHECK(same(all(store), expected));
+  }
+
+  void test_negative_and_special_values() {
+    const std::vector<double> values = {
+        0.0, -0.0, 1.0, -1.0, 1.0000000000000002, -1.0000000000000002, 1.0,
+        -123456.789, 5e-324, -5e-324, std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+        std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(), 42.0, 42.0, 42.5, 42.25, -42.25
+    };
+    std::vector<TimeSeriesPoint> points;
+    for (size_t i = 0; i < values.size(); ++i) {
+      points.push_back({at(START + static_cast<int64_t>(i) * 60), values[i]});
+    }
+    TimeSeriesStore store;
+    append_all(store, points);
+    CHECK(same(all(store), points));
+  }
+
+  void test_repeated_values() {
+    std::vector<TimeSeriesPoint> points;
+    for (int i = 0; i < 500; ++i) {
+      points.push_back({at(START + i * 300), 98.6});
+    }
+    TimeSeriesStore store;
+    append_all(store, points);
+    CHECK(same(all(store), points));
+    // A steady interval and an unchanged value take two bits per point after the first
+    CHECK(store.memory_bytes() < 500);
+  }
+
+  void test_xor_window_reuse() {
+    // Values whose XOR first opens a wide window, then fits inside it, then needs a new one
+    const std::vector<double> values = {100.0, 100.5, 100.25, 100.75, 100.125, 3.0e10, 3.0e10 + 1, 100.0};
+    std::vector<TimeSeriesPoint> points;
+    for (size_t i = 0; i < values.size(); ++i) {
+      points.push_back({at(START + static_cast<int64_t>(i)), values[i]});
+    }
+    TimeSeriesStore store;
+    append_all(store, points);
+    CHECK(same(all(store), points));
+  }
+
+  void test_segment_boundary() {
+    TimeSeriesStore store;
+    auto expected = append_all(store, odometer(2 * TimeSeriesStore::SEGMENT_POINTS + 17));
+    CHECK_EQ(store.size(VIN, FIELD), expected.size());
+    CHECK(same(all(store), expected));
+
+    const size_t boundary = TimeSeriesStore::SEGMENT_POINTS;
+    std::vector<TimeSeriesPoint> across(expected.begin() + boundary - 3, expected.begin() + boundary + 3);
+    CHECK(same(store.range(VIN, FIELD, across.front().time, across.back().time), across));
+
+    std::vector<TimeSeriesPoint> second(expected.begin() + boundary, expected.begin() + 2 * boundary);
+    CHECK(same(store.range(VIN, FIELD, second.front().time, second.back().time), second));
+  }
+
+  void test_rejects_old_points() {
+    TimeSeriesStore store;
+    CHECK(store.append(VIN, FIELD, at(START), 1.0));
+    CHECK(!store.append(VIN, FIELD, at(START), 2.0));
+    CHECK(!store.append(VIN, FIELD, at(START - 1), 2.0));
+    CHECK_EQ(store.size(VIN, FIELD), 1u);
+
+    // Also right after a segment is sealed
+    store.flush();
+    CHECK(!store.append(VIN, FIELD, at(START), 2.0));
+    CHECK(store.append(VIN, FIELD, at(START + 1), 2.0));
+    CHECK(same(all(store), {{at(START), 1.0}, {at(START + 1), 2.0}}));
+  }
+
+  void test_reload() {
+    TempDirectory directory;
+    auto expected = odometer(2 * TimeSeriesStore::SEGMENT_POINTS + 100);
+    {
+      TimeSeriesStore store(directory.path());
+      append_all(store, expected);
+      store.append(VIN, "FUEL", at(START), 0.5);
+    }
+
+    // Segments sealed on destruction come back with every point intact
+    TimeSeriesStore store(directory.path());
+    CHECK_EQ(store.size(VIN, FIELD), expected.size());
+    CHECK(store.fields(VIN) == (std::vector<std::string>{"FUEL", FIELD}));
+    CHECK(same(all(store), expected));
+
+    // A reloaded series keeps growing after its last sealed point
+    auto last = expected.back().time;
+    CHECK(!store.append(VIN, FIELD, last, 1.0));
+    CHECK(store.append(VIN, FIELD, last + std::chrono::seconds(60), -7.25));
+    expected.push_back({last + std::chrono::seconds(60), -7.25});
+    CHECK(same(all(store), expected));
+  }
+
+  void test_reload_skips_unreadable_segments() {
+    TempDirectory directory;
+    auto expected = odometer(TimeSeriesStore::SEGMENT_POINTS);
+    {
+      TimeSeriesStore store(directory.path());
+      append_all(store, expected);
+    }
+    auto folder = fs::path(directory.path()) / VIN / FIELD;
+    std::ofstream(folder / "1.seg", std::ios::binary) << "not a segment";
+    std::ofstream(folder / "notes.txt") << "ignored";
+
+    TimeSeriesStore store(directory.path());
+    CHECK_EQ(store.size(VIN, FIELD), expected.size());
+    CHECK(same(all(store), expected));
+  }
+
+  void test_retention_drops_whole_segments() {
+    TimeSeriesStore store;
+    auto points = append_all(store, odometer(3 * TimeSeriesStore::SEGMENT_POINTS + 1));
+    store.set_retention({std::chrono::seconds(0), TimeSeriesStore::SEGMENT_POINTS + 1});
+    std::vector<TimeSeriesPoint> kept(points.begin() + 2 * TimeSeriesStore::SEGMENT_POINTS, points.end());
+    CHECK_EQ(store.size(VIN, FIELD), kept.size());
+    CHECK(same(all(store), kept));
+  }
+
+  void test_downsample() {
+    TimeSeriesStore store;
+    append_all(store, {{at(START), 1.0}, {at(START + 10), 3.0}, {at(START + 60), -2.0}, {at(START + 179), 4.0}});
+    auto buckets = store.downsample(VIN, FIELD, at(START), at(START + 179), std::chrono::seconds(60));
+    CHECK_EQ(buckets.size(), 3u);
+    if (buckets.size() == 3) {
+      CHECK(buckets[0].start == at(START));
+      CHECK_EQ(buckets[0].count, 2u);
+      CHECK_EQ(buckets[0].min, 1.0);
+      CHECK_EQ(buckets[0].max, 3.0);
+      CHECK_EQ(buckets[0].avg, 2.0);
+      CHECK(buckets[1].start == at(START + 60));
+      CHECK_EQ(buckets[1].avg, -2.0);
+      CHECK(buckets[2].start == at(START + 120));
+      CHECK_EQ(buckets[2].avg, 4.0);
+    }
+  }
+
+} // namespace
+
+int main() {
+  test::run("every_timestamp_width", test_every_timestamp_width);
+  test::run("negative_and_special_values", test_negative_and_special_values);
+  test::run("repeated_values", test_repeated_values);
+  test::run("xor_window_reuse", test_xor_window_reuse);
+  test::run("segment_boundary", test_segment_boundary);
+  test::run("rejects_old_points", test_rejects_old_points);
+  test::run("reload", test_reload);
+  test::run("reload_skips_unreadable_segments", test_reload_skips_unreadable_segments);
+  test::run("retention_drops_whole_segments", test_retention_drops_whole_segments);
+  test::run("downsample", test_downsample);
+  return test::result();
+}